@@ -150,9 +150,19 @@ void AccountsService::setUser(const QString &user)
     m_user = user;
     Q_EMIT userChanged();
 
-    // Do the first update synchronously, as a cheap way to block rendering
-    // until we have the right values on bootup.
-    refresh(!wasEmpty);
+    if (wasEmpty) {
+        // Do the first update synchronously, as a cheap way to block rendering
+        // until we have the right values on bootup.
+        m_service->findUserNow(m_user);
+        refresh(false);
+    } else {
+        // The values come in as change notifications once the user was looked up
+        m_service->whenUserFound(m_user, this, [this, user]() {
+            if (m_user == user) {
+                refresh(true);
+            }
+        });
+    }
 }
 
 bool AccountsService::demoEdges() const
@@ -341,7 +351,10 @@ void AccountsService::setProperty(const QString &interface, const QString &prope
 {
     if (m_properties[interface][property].value != value) {
         m_properties[interface][property].value = value;
-        m_service->setUserPropertyAsync(m_user, interface, property, value);
+        const QString user = m_user;
+        m_service->whenUserFound(user, this, [this, user, interface, property, value]() {
+            m_service->setUserPropertyAsync(user, interface, property, value);
+        });
         emitChangedForProperty(interface, property);
     }
 }
@@ -369,6 +382,12 @@ void AccountsService::updateCache(const QString &interface, const QString &prope
 
 void AccountsService::updateProperty(const QString &interface, const QString &property)
 {
+    QVariant cached;
+    if (m_service->cachedProperty(m_user, interface, property, &cached)) {
+        updateCache(interface, property, cached);
+        return;
+    }
+
     QDBusPendingCall pendingReply = m_service->getUserPropertyAsync(m_user,
                                                                     interface,
                                                                     property);
@@ -390,6 +409,15 @@ void AccountsService::updateProperty(const QString &interface, const QString &pr
 
 void AccountsService::updateAllProperties(const QString &interface, bool async)
 {
+    QVariantMap cached;
+    if (m_service->cachedProperties(m_user, interface, &cached)) {
+        // Up to date already, no need to ask again
+        for (auto i = cached.constBegin(); i != cached.constEnd(); ++i) {
+            updateCache(interface, i.key(), i.value());
+        }
+        return;
+    }
+
     QDBusPendingCall pendingReply = m_service->getAllPropertiesAsync(m_user,
                                                                      interface);
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(pendingReply, this);
@@ -16,37 +16,183 @@
 
 #include "AccountsServiceDBusAdaptor.h"
 #include <QDBusConnection>
-#include <QDBusConnectionInterface>
 #include <QDBusMessage>
+#include <QDBusReply>
 #include <QDBusVariant>
 #include <QDebug>
 
+static const QString accountsService = QStringLiteral("org.freedesktop.Accounts");
+static const QString accountsUserInterface = QStringLiteral("org.freedesktop.Accounts.User");
+static const QString propertiesInterface = QStringLiteral("org.freedesktop.DBus.Properties");
+
+namespace {
+
+/* QDBusInterface synchronously introspects the remote object on construction,
+ * which blocks us on a round trip per user. QDBusAbstractInterface doesn't, and
+ * we only ever make plain calls on these interfaces anyway.
+ */
+class AsyncDBusInterface : public QDBusAbstractInterface
+{
+public:
+    AsyncDBusInterface(const QString &service, const QString &path,
+                       const QString &interface, const QDBusConnection &connection,
+                       QObject *parent = 0)
+    : QDBusAbstractInterface(service, path, interface.toLatin1().data(), connection, parent)
+    {}
+};
+
+}
+
 AccountsServiceDBusAdaptor::AccountsServiceDBusAdaptor(QObject* parent)
   : QObject(parent),
     m_accountsManager(nullptr),
     m_ignoreNextChanged(false)
 {
-    QDBusConnection connection = QDBusConnection::SM_BUSNAME();
-    QDBusConnectionInterface *interface = connection.interface();
-    interface->startService(QStringLiteral("org.freedesktop.Accounts"));
-    m_accountsManager = new QDBusInterface(QStringLiteral("org.freedesktop.Accounts"),
-                                           QStringLiteral("/org/freedesktop/Accounts"),
-                                           QStringLiteral("org.freedesktop.Accounts"),
-                                           connection, this);
+    // No need to start the service, the bus does that on our first call
+    m_accountsManager = new AsyncDBusInterface(accountsService,
+                                               QStringLiteral("/org/freedesktop/Accounts"),
+                                               accountsService,
+                                               QDBusConnection::SM_BUSNAME(), this);
+}
+
+void AccountsServiceDBusAdaptor::prefetchUser(const QString &user)
+{
+    // Not asking isValid(), that only holds once the service is up, and blocks to find out
+    if (m_users.contains(user) || m_pendingUsers.contains(user)) {
+        return;
+    }
+
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(m_accountsManager->asyncCall(QStringLiteral("FindUserByName"), user), this);
+    watcher->setProperty("user", user);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, &AccountsServiceDBusAdaptor::onUserFound);
+    m_pendingUsers.insert(user, watcher);
+}
+
+void AccountsServiceDBusAdaptor::whenUserFound(const QString &user, QObject *context, const std::function<void()> &callback)
+{
+    prefetchUser(user);
+    if (!m_pendingUsers.contains(user)) {
+        // Found already, or there is nothing to wait for
+        callback();
+        return;
+    }
+    m_userCallbacks[user].append(qMakePair(QPointer<QObject>(context), callback));
+}
+
+void AccountsServiceDBusAdaptor::findUserNow(const QString &user)
+{
+    prefetchUser(user);
+    QDBusPendingCallWatcher *watcher = m_pendingUsers.value(user);
+    if (watcher != nullptr) {
+        // Delivers finished() before returning, so onUserFound() is done by then
+        watcher->waitForFinished();
+    }
+}
+
+void AccountsServiceDBusAdaptor::onUserFound(QDBusPendingCallWatcher *watcher)
+{
+    const QString user = watcher->property("user").toString();
+    watcher->deleteLater();
+    m_pendingUsers.remove(user);
+
+    QDBusPendingReply<QDBusObjectPath> answer = *watcher;
+    if (answer.isError()) {
+        qWarning() << "Couldn't get user interface" << answer.error().name() << answer.error().message();
+    } else {
+        addUser(user, answer.value().path());
+    }
+
+    // Even if the lookup failed, their calls will just fail too
+    const auto callbacks = m_userCallbacks.take(user);
+    for (const auto &callback : callbacks) {
+        if (callback.first) {
+            callback.second();
+        }
+    }
+}
+
+void AccountsServiceDBusAdaptor::addUser(const QString &user, const QString &path)
+{
+    QDBusAbstractInterface *iface = new AsyncDBusInterface(accountsService,
+                                                           path,
+                                                           propertiesInterface,
+                                                           m_accountsManager->connection(), this);
+
+    // With its own pre-defined properties, AccountsService is oddly
+    // close-lipped.  It won't send out proper DBus.Properties notices,
+    // but it does have one catch-all Changed() signal.  So let's
+    // listen to that.
+    iface->connection().connect(
+        iface->service(),
+        path,
+        accountsUserInterface,
+        QStringLiteral("Changed"),
+        this,
+        SLOT(maybeChangedSlot()));
+
+    // But custom properties do send out the right notifications, so
+    // let's still listen there.
+    iface->connection().connect(
+        iface->service(),
+        path,
+        propertiesInterface,
+        QStringLiteral("PropertiesChanged"),
+        this,
+        SLOT(propertiesChangedSlot(QString, QVariantMap, QStringList)));
+
+    m_users.insert(user, iface);
+    m_userForPath.insert(path, user);
 }
 
 QDBusPendingReply<QVariantMap> AccountsServiceDBusAdaptor::getAllPropertiesAsync(const QString &user, const QString &interface)
 {
-    QDBusInterface *iface = getUserInterface(user);
+    QDBusAbstractInterface *iface = getUserInterface(user);
     if (iface != nullptr && iface->isValid()) {
-        return iface->asyncCall(QStringLiteral("GetAll"), interface);
+        QDBusPendingCallWatcher *watcher = m_properties[user][interface].fetching;
+        if (watcher == nullptr) {
+            watcher = fetchAllProperties(user, interface, iface);
+        }
+        return QDBusPendingReply<QVariantMap>(*watcher);
     }
     return QDBusPendingReply<QVariantMap>(QDBusMessage::createError(QDBusError::Other, QStringLiteral("Invalid Interface")));
 }
 
+QDBusPendingCallWatcher *AccountsServiceDBusAdaptor::fetchAllProperties(const QString &user, const QString &interface, QDBusAbstractInterface *iface)
+{
+    PropertyCache &cache = m_properties[user][interface];
+    const int generation = cache.generation;
+
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(iface->asyncCall(QStringLiteral("GetAll"), interface), this);
+    cache.fetching = watcher;
+    connect(watcher, &QDBusPendingCallWatcher::finished,
+            this, [this, user, interface, generation](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+
+        PropertyCache &cache = m_properties[user][interface];
+        if (cache.fetching == watcher) {
+            cache.fetching = nullptr;
+        }
+
+        QDBusPendingReply<QVariantMap> reply = *watcher;
+        if (reply.isError() || cache.generation != generation) {
+            return;
+        }
+        cache.values = reply.value();
+        cache.complete = true;
+    });
+    return watcher;
+}
+
+void AccountsServiceDBusAdaptor::invalidate(PropertyCache &cache)
+{
+    // Whoever asks from now on needs a reply sent after the change
+    cache.fetching = nullptr;
+    ++cache.generation;
+}
+
 QDBusPendingReply<QVariant> AccountsServiceDBusAdaptor::getUserPropertyAsync(const QString &user, const QString &interface, const QString &property)
 {
-    QDBusInterface *iface = getUserInterface(user);
+    QDBusAbstractInterface *iface = getUserInterface(user);
     if (iface != nullptr && iface->isValid()) {
         return iface->asyncCall(QStringLiteral("Get"), interface, property);
     }
@@ -55,15 +201,21 @@ QDBusPendingReply<QVariant> AccountsServiceDBusAdaptor::getUserPropertyAsync(con
 
 QDBusPendingCall AccountsServiceDBusAdaptor::setUserPropertyAsync(const QString &user, const QString &interface, const QString &property, const QVariant &value)
 {
-    QDBusInterface *iface = getUserInterface(user);
+    QDBusAbstractInterface *iface = getUserInterface(user);
     if (iface != nullptr && iface->isValid()) {
-        if (interface == QStringLiteral("org.freedesktop.Accounts.User")) {
+        // We'll hear about the new value, if it sticks
+        PropertyCache &cache = m_properties[user][interface];
+        cache.values.remove(property);
+        cache.complete = false;
+        invalidate(cache);
+
+        if (interface == accountsUserInterface) {
             // Standard AccountsService properties use special set methods.
             // It will not let you use the usual DBus property setters.
-            QDBusInterface accountsIface(iface->service(),
-                                         iface->path(),
-                                         interface,
-                                         iface->connection());
+            AsyncDBusInterface accountsIface(iface->service(),
+                                             iface->path(),
+                                             interface,
+                                             iface->connection());
             return accountsIface.asyncCall(QStringLiteral("Set") + property, value);
         } else {
             // The value needs to be carefully wrapped
@@ -73,15 +225,48 @@ QDBusPendingCall AccountsServiceDBusAdaptor::setUserPropertyAsync(const QString
     return QDBusPendingCall::fromCompletedCall(QDBusMessage::createError(QDBusError::Other, QStringLiteral("Invalid Interface")));
 }
 
+bool AccountsServiceDBusAdaptor::cachedProperty(const QString &user, const QString &interface, const QString &property, QVariant *value) const
+{
+    const QVariantMap values = m_properties.value(user).value(interface).values;
+    auto it = values.constFind(property);
+    if (it == values.constEnd()) {
+        return false;
+    }
+    *value = it.value();
+    return true;
+}
+
+bool AccountsServiceDBusAdaptor::cachedProperties(const QString &user, const QString &interface, QVariantMap *values) const
+{
+    const PropertyCache cache = m_properties.value(user).value(interface);
+    if (!cache.complete) {
+        return false;
+    }
+    *values = cache.values;
+    return true;
+}
+
 void AccountsServiceDBusAdaptor::propertiesChangedSlot(const QString &interface, const QVariantMap &changed, const QStringList &invalid)
 {
+    const QString user = getUserForPath(message().path());
+
+    PropertyCache &cache = m_properties[user][interface];
+    Q_FOREACH (const QString &property, invalid) {
+        cache.values.remove(property);
+        cache.complete = false;
+    }
+    for (auto it = changed.constBegin(); it != changed.constEnd(); ++it) {
+        cache.values.insert(it.key(), it.value());
+    }
+    invalidate(cache);
+
     // Merge changed and invalidated together
     QStringList combined;
     combined << invalid;
     combined << changed.keys();
     combined.removeDuplicates();
 
-    Q_EMIT propertiesChanged(getUserForPath(message().path()), interface, combined);
+    Q_EMIT propertiesChanged(user, interface, combined);
 
     // In case a non-builtin property changes, we're getting propertiesChanged *and* changed
     // As the generic changed requires asking back over DBus, it's quite slow to process.
@@ -91,62 +276,31 @@ void AccountsServiceDBusAdaptor::propertiesChangedSlot(const QString &interface,
 
 void AccountsServiceDBusAdaptor::maybeChangedSlot()
 {
+    const QString user = getUserForPath(message().path());
+
     if (!m_ignoreNextChanged) {
-        Q_EMIT maybeChanged(getUserForPath(message().path()));
+        // We don't know which of the standard properties changed, if any
+        PropertyCache &cache = m_properties[user][accountsUserInterface];
+        cache.values.clear();
+        cache.complete = false;
+        invalidate(cache);
+
+        Q_EMIT maybeChanged(user);
     }
     m_ignoreNextChanged = false;
 }
 
 QString AccountsServiceDBusAdaptor::getUserForPath(const QString &path) const
 {
-    QMap<QString, QDBusInterface *>::const_iterator i;
-    for (i = m_users.constBegin(); i != m_users.constEnd(); ++i) {
-        if (i.value()->path() == path) {
-            return i.key();
-        }
-    }
-    return QString();
-}
-
-QDBusInterface *AccountsServiceDBusAdaptor::getUserInterface(const QString &user)
-{
-    QDBusInterface *iface = m_users.value(user);
-    if (iface == nullptr && m_accountsManager->isValid()) {
-        QDBusReply<QDBusObjectPath> answer = m_accountsManager->call(QStringLiteral("FindUserByName"), user);
-        if (answer.isValid()) {
-            const QString path = answer.value().path();
-
-            iface = new QDBusInterface(QStringLiteral("org.freedesktop.Accounts"),
-                                       path,
-                                       QStringLiteral("org.freedesktop.DBus.Properties"),
-                                       m_accountsManager->connection(), this);
-
-            // With its own pre-defined properties, AccountsService is oddly
-            // close-lipped.  It won't send out proper DBus.Properties notices,
-            // but it does have one catch-all Changed() signal.  So let's
-            // listen to that.
-            iface->connection().connect(
-                iface->service(),
-                path,
-                QStringLiteral("org.freedesktop.Accounts.User"),
-                QStringLiteral("Changed"),
-                this,
-                SLOT(maybeChangedSlot()));
-
-            // But custom properties do send out the right notifications, so
-            // let's still listen there.
-            iface->connection().connect(
-                iface->service(),
-                path,
-                QStringLiteral("org.freedesktop.DBus.Properties"),
-                QStringLiteral("PropertiesChanged"),
-                this,
-                SLOT(propertiesChangedSlot(QString, QVariantMap, QStringList)));
-
-            m_users.insert(user, iface);
-        } else {
-            qWarning() << "Couldn't get user interface" << answer.error().name() << answer.error().message();
-        }
+    return m_userForPath.value(path);
+}
+
+QDBusAbstractInterface *AccountsServiceDBusAdaptor::getUserInterface(const QString &user)
+{
+    QDBusAbstractInterface *iface = m_users.value(user);
+    if (iface == nullptr) {
+        // We don't wait for it, whoever needs the user should go through whenUserFound()
+        prefetchUser(user);
     }
     return iface;
 }
@@ -17,14 +17,32 @@
 #ifndef UNITY_ACCOUNTSSERVICEDBUSADAPTOR_H
 #define UNITY_ACCOUNTSSERVICEDBUSADAPTOR_H
 
+#include <QDBusAbstractInterface>
 #include <QDBusArgument>
 #include <QDBusContext>
-#include <QDBusInterface>
+#include <QDBusPendingCallWatcher>
 #include <QDBusPendingReply>
-#include <QMap>
+#include <QHash>
 #include <QObject>
+#include <QPointer>
 #include <QString>
 
+#include <functional>
+
+/*
+ * Talks to AccountsService on behalf of the AccountsService plugin and friends.
+ *
+ * Users are looked up asynchronously: prefetchUser() starts the lookup and
+ * whenUserFound() calls back once it is done. Only findUserNow() waits for it,
+ * for when nothing can be shown before the user's values are known. Calls for
+ * a user that wasn't found yet fail right away. None of the interfaces are
+ * introspected, and AccountsService gets activated by the first call to it.
+ *
+ * The property values we come across, from GetAll replies and PropertiesChanged
+ * notifications, are kept around and can be asked for with cachedProperty()
+ * and cachedProperties() before going over the bus. Concurrent GetAll requests
+ * share a single call.
+ */
 class AccountsServiceDBusAdaptor: public QObject, public QDBusContext
 {
     Q_OBJECT
@@ -33,10 +51,20 @@ public:
     explicit AccountsServiceDBusAdaptor(QObject *parent = 0);
     ~AccountsServiceDBusAdaptor() = default;
 
+    void prefetchUser(const QString &user);
+    // Right away if the user was already looked up, and not at all if context is gone by then
+    void whenUserFound(const QString &user, QObject *context, const std::function<void()> &callback);
+    // Blocks until the user was looked up
+    void findUserNow(const QString &user);
+
     QDBusPendingReply<QVariantMap> getAllPropertiesAsync(const QString &user, const QString &interface);
     QDBusPendingReply<QVariant> getUserPropertyAsync(const QString &user, const QString &interface, const QString &property);
     QDBusPendingCall setUserPropertyAsync(const QString &user, const QString &interface, const QString &property, const QVariant &value);
 
+    bool cachedProperty(const QString &user, const QString &interface, const QString &property, QVariant *value) const;
+    // Only if all of them are known, as a GetAll reply would have them
+    bool cachedProperties(const QString &user, const QString &interface, QVariantMap *values) const;
+
 Q_SIGNALS:
     void propertiesChanged(const QString &user, const QString &interface, const QStringList &changed);
     void maybeChanged(const QString &user); // Standard properties might have changed
@@ -44,15 +72,37 @@ Q_SIGNALS:
 private Q_SLOTS:
     void propertiesChangedSlot(const QString &interface, const QVariantMap &changed, const QStringList &invalid);
     void maybeChangedSlot();
+    void onUserFound(QDBusPendingCallWatcher *watcher);
 
 private:
-    QDBusInterface *getUserInterface(const QString &user);
+    struct PropertyCache {
+        QVariantMap values;
+        // Whether values has all of the interface's properties, not just the ones we heard about
+        bool complete = false;
+        // Bumped whenever values get invalidated, replies to older GetAll calls are dropped
+        int generation = 0;
+        // GetAll in flight, shared by everyone asking for it meanwhile
+        QDBusPendingCallWatcher *fetching = nullptr;
+    };
+
+    void addUser(const QString &user, const QString &path);
+    QDBusAbstractInterface *getUserInterface(const QString &user);
     QString getUserForPath(const QString &path) const;
+    QDBusPendingCallWatcher *fetchAllProperties(const QString &user, const QString &interface, QDBusAbstractInterface *iface);
+    void invalidate(PropertyCache &cache);
 
-    QDBusInterface *m_accountsManager;
-    QMap<QString, QDBusInterface *> m_users;
+    QDBusAbstractInterface *m_accountsManager;
+    QHash<QString, QDBusAbstractInterface *> m_users;
+    QHash<QString, QString> m_userForPath;
+    QHash<QString, QDBusPendingCallWatcher *> m_pendingUsers;
+    QHash<QString, QList<QPair<QPointer<QObject>, std::function<void()>>>> m_userCallbacks;
+
+    // By user, then by interface
+    QHash<QString, QHash<QString, PropertyCache>> m_properties;
 
     bool m_ignoreNextChanged;
+
+    friend class AccountsServiceTest;
 };
 
 #endif
@@ -51,6 +51,7 @@ void AbstractDashView::setModel(QAbstractItemModel *model)
         connect(m_delegateModel, &QQmlDelegateModel::modelUpdated, this, &AbstractDashView::onModelUpdated);
 
         cleanupExistingItems();
+        m_delegatePool.clear();
 
         Q_EMIT modelChanged();
         polish();
@@ -70,6 +71,7 @@ void AbstractDashView::setDelegate(QQmlComponent *delegate)
         }
 
         cleanupExistingItems();
+        m_delegatePool.clear();
 
         m_delegateModel->setDelegate(delegate);
 
@@ -166,9 +168,38 @@ void AbstractDashView::setDisplayMarginEnd(qreal end)
     emit displayMarginEndChanged();
 }
 
+int AbstractDashView::delegatePoolSize() const
+{
+    return m_delegatePool.capacity();
+}
+
+void AbstractDashView::setDelegatePoolSize(int delegatePoolSize)
+{
+    if (delegatePoolSize < 0) {
+        qmlInfo(this) << "Cannot set a negative delegate pool size";
+        return;
+    }
+
+    if (delegatePoolSize != m_delegatePool.capacity()) {
+        m_delegatePool.setCapacity(delegatePoolSize);
+        Q_EMIT delegatePoolSizeChanged();
+    }
+}
+
+int AbstractDashView::delegatePoolHits() const
+{
+    return m_delegatePool.hits();
+}
+
+int AbstractDashView::delegatePoolMisses() const
+{
+    return m_delegatePool.misses();
+}
+
 void AbstractDashView::createDelegateModel()
 {
     m_delegateModel = new QQmlDelegateModel(qmlContext(this), this);
+    m_delegatePool.setDelegateModel(m_delegateModel);
     connect(m_delegateModel, &QQmlDelegateModel::createdItem, this, &AbstractDashView::itemCreated);
     if (isComponentComplete())
         m_delegateModel->componentComplete();
@@ -236,7 +267,7 @@ QQuickItem *AbstractDashView::createItem(int modelIndex, bool asynchronous)
         return nullptr;
 
     m_asyncRequestedIndex = -1;
-    QObject* object = m_delegateModel->object(modelIndex, asynchronous);
+    QObject* object = m_delegatePool.object(modelIndex, asynchronous);
     QQuickItem *item = qmlobject_cast<QQuickItem*>(object);
     if (!item) {
         if (object) {
@@ -260,10 +291,7 @@ QQuickItem *AbstractDashView::createItem(int modelIndex, bool asynchronous)
 void AbstractDashView::releaseItem(QQuickItem *item)
 {
     QQuickItemPrivate::get(item)->removeItemChangeListener(this, QQuickItemPrivate::Geometry);
-    QQmlDelegateModel::ReleaseFlags flags = m_delegateModel->release(item);
-    if (flags & QQmlDelegateModel::Destroyed) {
-        item->setParentItem(nullptr);
-    }
+    m_delegatePool.park(item);
 }
 
 void AbstractDashView::setImplicitHeightDirty()
@@ -296,8 +324,13 @@ void AbstractDashView::onModelUpdated(const QQmlChangeSet &changeSet, bool reset
 {
     if (reset) {
         cleanupExistingItems();
+        m_delegatePool.clear();
     } else {
         processModelRemoves(changeSet.removes());
+        // Parked items may belong to rows that are gone
+        if (!changeSet.removes().isEmpty()) {
+            m_delegatePool.clear();
+        }
 
         // The current AbstractDashViews do not support insertions that are not at the end
         // so reset if that happens
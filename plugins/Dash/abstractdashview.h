@@ -19,6 +19,8 @@
 
 #include <QQuickItem>
 
+#include "delegatepool.h"
+
 class QAbstractItemModel;
 class QQmlComponent;
 
@@ -41,6 +43,7 @@ class AbstractDashView : public QQuickItem, public QQuickItemChangeListener
     Q_PROPERTY(qreal displayMarginEnd READ displayMarginEnd
                                       WRITE setDisplayMarginEnd
                                       NOTIFY displayMarginEndChanged)
+    Q_PROPERTY(int delegatePoolSize READ delegatePoolSize WRITE setDelegatePoolSize NOTIFY delegatePoolSizeChanged)
 
 friend class VerticalJournalTest;
 friend class HorizontalJournalTest;
@@ -70,6 +73,12 @@ public:
     qreal displayMarginEnd() const;
     void setDisplayMarginEnd(qreal);
 
+    int delegatePoolSize() const;
+    void setDelegatePoolSize(int delegatePoolSize);
+
+    Q_INVOKABLE int delegatePoolHits() const;
+    Q_INVOKABLE int delegatePoolMisses() const;
+
 Q_SIGNALS:
     void modelChanged();
     void delegateChanged();
@@ -78,6 +87,7 @@ Q_SIGNALS:
     void cacheBufferChanged();
     void displayMarginBeginningChanged();
     void displayMarginEndChanged();
+    void delegatePoolSizeChanged();
 
 protected Q_SLOTS:
     void relayout();
@@ -111,6 +121,7 @@ private:
     virtual void processModelRemoves(const QVector<QQmlChangeSet::Change> &removes) = 0;
 
     QQmlDelegateModel *m_delegateModel;
+    DelegatePool m_delegatePool;
 
     // Index we are waiting because we requested it asynchronously
     int m_asyncRequestedIndex;
@@ -0,0 +1,1403 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cardcreator.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJSValue>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QQmlComponent>
+#include <QQmlEngine>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QUrl>
+
+#include <algorithm>
+
+// Bump when the cache layout changes or when old cards should go away
+static const int kCacheVersion = 1;
+
+// How many of the most used cards of previous sessions we start loading on creation
+static const int kPrewarmCount = 16;
+
+// How many cards we keep in the disk cache
+static const int kMaxCachedCards = 64;
+
+static const char kIndexFileName[] = "index.json";
+
+static const char kImportsCode[] =
+    "import QtQuick 2.4;\n"
+    "import Ubuntu.Components 1.3;\n"
+    "import Ubuntu.Settings.Components 0.1;\n"
+    "import Dash 0.1;\n"
+    "import Utils 0.1;\n";
+
+// %1 is whether the card is enabled
+static const char kCardCode[] =
+    "AbstractButton {\n"
+    "    id: root;\n"
+    "    property var cardData;\n"
+    "    property string backgroundShapeStyle: \"flat\";\n"
+    "    property real fontScale: 1.0;\n"
+    "    property var scopeStyle: null;\n"
+    "    readonly property string title: cardData && cardData[\"title\"] || \"\";\n"
+    "    property bool showHeader: true;\n"
+    "    implicitWidth: childrenRect.width;\n"
+    "    enabled: %1;\n"
+    "\n";
+
+static const char kFixedSizesCode[] =
+    "property int fixedHeaderHeight: -1;\n"
+    "property size fixedArtShapeSize: Qt.size(-1, -1);\n";
+
+// %1 is the template["card-background"]["elements"][0]
+// %2 is the template["card-background"]["elements"][1]
+// %3 is whether the loader should be asynchronous or not
+// %4 is the template["card-background"] string
+static const char kBackgroundLoaderCode[] =
+    "Loader {\n"
+    "    id: backgroundLoader;\n"
+    "    objectName: \"backgroundLoader\";\n"
+    "    anchors.fill: parent;\n"
+    "    asynchronous: %3;\n"
+    "    visible: status === Loader.Ready;\n"
+    "    sourceComponent: UbuntuShape {\n"
+    "        objectName: \"background\";\n"
+    "        radius: \"small\";\n"
+    "        aspect: {\n"
+    "            switch (root.backgroundShapeStyle) {\n"
+    "                case \"inset\": return UbuntuShape.Inset;\n"
+    "                case \"shadow\": return UbuntuShape.DropShadow;\n"
+    "                default:\n"
+    "                case \"flat\": return UbuntuShape.Flat;\n"
+    "            }\n"
+    "        }\n"
+    "        backgroundColor: getColor(0) || \"white\";\n"
+    "        secondaryBackgroundColor: getColor(1) || backgroundColor;\n"
+    "        backgroundMode: UbuntuShape.VerticalGradient;\n"
+    "        anchors.fill: parent;\n"
+    "        source: backgroundImage.source ? backgroundImage : null;\n"
+    "        property real luminance: Style.luminance(backgroundColor);\n"
+    "        property Image backgroundImage: Image {\n"
+    "            objectName: \"backgroundImage\";\n"
+    "            source: {\n"
+    "                if (cardData && typeof cardData[\"background\"] === \"string\") return cardData[\"background\"];\n"
+    "                else return %4;\n"
+    "            }\n"
+    "        }\n"
+    "        function getColor(index) {\n"
+    "            if (cardData && typeof cardData[\"background\"] === \"object\"\n"
+    "            && (cardData[\"background\"][\"type\"] === \"color\" || cardData[\"background\"][\"type\"] === \"gradient\")) {\n"
+    "                return cardData[\"background\"][\"elements\"][index];\n"
+    "            } else return index === 0 ? %1 : %2;\n"
+    "        }\n"
+    "    }\n"
+    "}\n";
+
+// %1 is the aspect of the UbuntuShape
+static const char kArtUbuntuShapeCode[] =
+    "UbuntuShape {\n"
+    "    anchors.fill: parent;\n"
+    "    source: artImage;\n"
+    "    sourceFillMode: UbuntuShape.PreserveAspectCrop;\n"
+    "    radius: \"small\";\n"
+    "    aspect: %1;\n"
+    "}";
+
+static const char kArtProportionalShapeCode[] =
+    "ProportionalShape {\n"
+    "    anchors.left: parent.left;\n"
+    "    anchors.right: parent.right;\n"
+    "    source: artImage;\n"
+    "    aspect: UbuntuShape.DropShadow;\n"
+    "}";
+
+// %1 is used as anchors of artShapeLoader
+// %2 is used as image width
+// %3 is used as image height
+// %4 is whether the image should be visible
+// %5 is whether the loader should be asynchronous or not
+// %6 is the shape code we want to use
+// %7 is injected as code to artImage
+// %8 is used as image fallback
+static const char kArtShapeHolderCode[] =
+    "Loader {\n"
+    "    id: artShapeLoader;\n"
+    "    height: root.fixedArtShapeSize.height;\n"
+    "    width: root.fixedArtShapeSize.width;\n"
+    "    anchors { %1 }\n"
+    "    objectName: \"artShapeLoader\";\n"
+    "    readonly property string cardArt: cardData && cardData[\"art\"] || %8;\n"
+    "    onCardArtChanged: { if (item) { item.image.source = cardArt; } }\n"
+    "    active: cardArt != \"\";\n"
+    "    asynchronous: %5;\n"
+    "    visible: status === Loader.Ready;\n"
+    "    sourceComponent: Item {\n"
+    "        id: artShape;\n"
+    "        objectName: \"artShape\";\n"
+    "        visible: image.status === Image.Ready;\n"
+    "        readonly property alias image: artImage;\n"
+    "        %6\n"
+    "        width: root.fixedArtShapeSize.width;\n"
+    "        height: root.fixedArtShapeSize.height;\n"
+    "        CroppedImageMinimumSourceSize {\n"
+    "            id: artImage;\n"
+    "            objectName: \"artImage\";\n"
+    "            source: artShapeLoader.cardArt;\n"
+    "            asynchronous: %5;\n"
+    "            visible: %4;\n"
+    "            width: %2;\n"
+    "            height: %3;\n"
+    "            %7\n"
+    "        }\n"
+    "    }\n"
+    "}\n";
+
+// Same as kArtShapeHolderCode, the card tool card sizes itself after the image
+static const char kArtShapeHolderCodeCardToolCard[] =
+    "Loader {\n"
+    "    id: artShapeLoader;\n"
+    "    anchors { %1 }\n"
+    "    objectName: \"artShapeLoader\";\n"
+    "    readonly property string cardArt: cardData && cardData[\"art\"] || %8;\n"
+    "    onCardArtChanged: { if (item) { item.image.source = cardArt; } }\n"
+    "    active: cardArt != \"\";\n"
+    "    asynchronous: %5;\n"
+    "    visible: status === Loader.Ready;\n"
+    "    sourceComponent: Item {\n"
+    "        id: artShape;\n"
+    "        objectName: \"artShape\";\n"
+    "        visible: image.status === Image.Ready;\n"
+    "        readonly property alias image: artImage;\n"
+    "        %6\n"
+    "        width: image.status !== Image.Ready ? 0 : image.width;\n"
+    "        height: image.status !== Image.Ready ? 0 : image.height;\n"
+    "        CroppedImageMinimumSourceSize {\n"
+    "            id: artImage;\n"
+    "            objectName: \"artImage\";\n"
+    "            source: artShapeLoader.cardArt;\n"
+    "            asynchronous: %5;\n"
+    "            visible: %4;\n"
+    "            width: %2;\n"
+    "            height: %3;\n"
+    "            %7\n"
+    "        }\n"
+    "    }\n"
+    "}\n";
+
+// %1 is anchors.fill
+// %2 is width
+// %3 is height
+// %4 is whether the icon should be asynchronous or not
+static const char kAudioButtonCode[] =
+    "AbstractButton {\n"
+    "    id: audioButton;\n"
+    "    anchors.fill: %1;\n"
+    "    width: %2;\n"
+    "    height: %3;\n"
+    "    readonly property url source: (cardData[\"quickPreviewData\"] && cardData[\"quickPreviewData\"][\"uri\"]) || \"\";\n"
+    "    UbuntuShape {\n"
+    "        anchors.fill: parent;\n"
+    "        visible: parent.pressed;\n"
+    "        radius: \"small\";\n"
+    "    }\n"
+    "    Rectangle {\n"
+    "        color: Qt.rgba(0, 0, 0, 0.5);\n"
+    "        anchors.centerIn: parent;\n"
+    "        width: parent.width * 0.5;\n"
+    "        height: width;\n"
+    "        radius: width / 2;\n"
+    "    }\n"
+    "    Icon {\n"
+    "        anchors.centerIn: parent;\n"
+    "        width: parent.width * 0.3;\n"
+    "        height: width;\n"
+    "        opacity: 0.9;\n"
+    "        name: DashAudioPlayer.playing && AudioUrlComparer.compare(parent.source, DashAudioPlayer.currentSource) ? \"media-playback-pause\" : \"media-playback-start\";\n"
+    "        color: \"white\";\n"
+    "        asynchronous: %4;\n"
+    "    }\n"
+    "    onClicked: {\n"
+    "        if (AudioUrlComparer.compare(source, DashAudioPlayer.currentSource)) {\n"
+    "            if (DashAudioPlayer.playing) {\n"
+    "                DashAudioPlayer.pause();\n"
+    "            } else {\n"
+    "                DashAudioPlayer.play();\n"
+    "            }\n"
+    "        } else {\n"
+    "            var playlist = (cardData[\"quickPreviewData\"] && cardData[\"quickPreviewData\"][\"playlist\"]) || null;\n"
+    "            DashAudioPlayer.playSource(source, playlist);\n"
+    "        }\n"
+    "    }\n"
+    "    onPressAndHold: {\n"
+    "        root.pressAndHold();\n"
+    "    }\n"
+    "}";
+
+// %1 is whether the loader should be asynchronous or not
+// %2 is the header height code
+static const char kOverlayLoaderCode[] =
+    "Loader {\n"
+    "    id: overlayLoader;\n"
+    "    readonly property real overlayHeight: %2 + units.gu(2);\n"
+    "    anchors.fill: artShapeLoader;\n"
+    "    active: artShapeLoader.active && artShapeLoader.item && artShapeLoader.item.image.status === Image.Ready || false;\n"
+    "    asynchronous: %1;\n"
+    "    visible: showHeader && status === Loader.Ready;\n"
+    "    sourceComponent: UbuntuShapeOverlay {\n"
+    "        id: overlay;\n"
+    "        property real luminance: Style.luminance(overlayColor);\n"
+    "        aspect: UbuntuShape.Flat;\n"
+    "        radius: \"small\";\n"
+    "        overlayColor: cardData && cardData[\"overlayColor\"] || \"#99000000\";\n"
+    "        overlayRect: Qt.rect(0, 1 - overlayLoader.overlayHeight / height, 1, 1);\n"
+    "    }\n"
+    "}\n";
+
+// %1 is the height code
+// %2 is used as anchors of row
+// %3 are the row children
+static const char kHeaderRowCode[] =
+    "Row {\n"
+    "    id: row;\n"
+    "    objectName: \"outerRow\";\n"
+    "    property real margins: units.gu(1);\n"
+    "    spacing: margins;\n"
+    "    %1"
+    "    anchors { %2 }\n"
+    "    anchors.right: parent.right;\n"
+    "    anchors.margins: margins;\n"
+    "    anchors.rightMargin: 0;\n"
+    "    data: [\n"
+    "        %3\n"
+    "    ]\n"
+    "}\n";
+
+// %1 is used as anchors of headerTitleContainer
+// %2 is used as implicitHeight of headerTitleContainer
+// %3 are the container children
+static const char kHeaderContainerCode[] =
+    "Item {\n"
+    "    id: headerTitleContainer;\n"
+    "    anchors { %1 }\n"
+    "    width: parent.width - x;\n"
+    "    implicitHeight: %2;\n"
+    "    data: [\n"
+    "        %3\n"
+    "    ]\n"
+    "}\n";
+
+// %1 is used as anchors of mascotShapeLoader
+// %2 is whether the loader should be asynchronous or not
+static const char kMascotShapeLoaderCode[] =
+    "Loader {\n"
+    "    id: mascotShapeLoader;\n"
+    "    objectName: \"mascotShapeLoader\";\n"
+    "    asynchronous: %2;\n"
+    "    active: mascotImage.status === Image.Ready;\n"
+    "    visible: showHeader && active && status === Loader.Ready;\n"
+    "    width: units.gu(6);\n"
+    "    height: units.gu(5.625);\n"
+    "    sourceComponent: UbuntuShape { aspect: UbuntuShape.Flat; image: mascotImage }\n"
+    "    anchors { %1 }\n"
+    "}\n";
+
+// %1 is used as anchors of mascotImage
+// %2 is used as visible of mascotImage
+// %3 is injected as code to mascotImage
+// %4 is used as fallback image
+static const char kMascotImageCode[] =
+    "CroppedImageMinimumSourceSize {\n"
+    "    id: mascotImage;\n"
+    "    objectName: \"mascotImage\";\n"
+    "    anchors { %1 }\n"
+    "    source: cardData && cardData[\"mascot\"] || %4;\n"
+    "    width: units.gu(6);\n"
+    "    height: units.gu(5.625);\n"
+    "    horizontalAlignment: Image.AlignHCenter;\n"
+    "    verticalAlignment: Image.AlignVCenter;\n"
+    "    visible: %2;\n"
+    "    %3\n"
+    "}\n";
+
+// %1 is used as anchors of titleLabel
+// %2 is used as color of titleLabel
+// %3 is used as extra condition for visible of titleLabel
+// %4 is used as title width
+// %5 is used as horizontal alignment
+static const char kTitleLabelCode[] =
+    "Label {\n"
+    "    id: titleLabel;\n"
+    "    objectName: \"titleLabel\";\n"
+    "    anchors { %1 }\n"
+    "    elide: Text.ElideRight;\n"
+    "    fontSize: \"small\";\n"
+    "    wrapMode: Text.Wrap;\n"
+    "    maximumLineCount: 2;\n"
+    "    font.pixelSize: Math.round(FontUtils.sizeToPixels(fontSize) * fontScale);\n"
+    "    color: %2;\n"
+    "    visible: showHeader %3;\n"
+    "    width: %4;\n"
+    "    text: root.title;\n"
+    "    font.weight: Font.Normal;\n"
+    "    horizontalAlignment: %5;\n"
+    "}\n";
+
+// %1 is used as extra anchors of emblemIcon
+// %2 is used as color of emblemIcon
+// FIXME The width code is a
+// Workaround for bug https://bugs.launchpad.net/ubuntu/+source/ubuntu-ui-toolkit/+bug/1421293
+static const char kEmblemIconCode[] =
+    "Icon {\n"
+    "    id: emblemIcon;\n"
+    "    objectName: \"emblemIcon\";\n"
+    "    anchors {\n"
+    "        bottom: titleLabel.baseline;\n"
+    "        right: parent.right;\n"
+    "        %1\n"
+    "    }\n"
+    "    source: cardData && cardData[\"emblem\"] || \"\";\n"
+    "    color: %2;\n"
+    "    height: source != \"\" ? titleLabel.font.pixelSize : 0;\n"
+    "    width: implicitWidth > 0 && implicitHeight > 0 ? (implicitWidth / implicitHeight * height) : implicitWidth;\n"
+    "}\n";
+
+// %1 is used as anchors of touchdown effect
+static const char kTouchdownCode[] =
+    "Loader {\n"
+    "    active: root.pressed;\n"
+    "    anchors { %1 }\n"
+    "    sourceComponent: UbuntuShape {\n"
+    "        objectName: \"touchdown\";\n"
+    "        anchors.fill: parent;\n"
+    "        radius: \"small\";\n"
+    "        borderSource: \"radius_pressed.sci\"\n"
+    "    }\n"
+    "}\n";
+
+// %1 is used as anchors of subtitleLabel
+// %2 is used as color of subtitleLabel
+static const char kSubtitleLabelCode[] =
+    "Label {\n"
+    "    id: subtitleLabel;\n"
+    "    objectName: \"subtitleLabel\";\n"
+    "    anchors { %1 }\n"
+    "    anchors.topMargin: units.dp(2);\n"
+    "    elide: Text.ElideRight;\n"
+    "    maximumLineCount: 1;\n"
+    "    fontSize: \"x-small\";\n"
+    "    font.pixelSize: Math.round(FontUtils.sizeToPixels(fontSize) * fontScale);\n"
+    "    color: %2;\n"
+    "    visible: titleLabel.visible && titleLabel.text;\n"
+    "    text: cardData && cardData[\"subtitle\"] || \"\";\n"
+    "    font.weight: Font.Light;\n"
+    "}\n";
+
+// %1 is used as anchors of attributesRow
+// %2 is used as color of attributesRow
+static const char kAttributesRowCode[] =
+    "CardAttributes {\n"
+    "    id: attributesRow;\n"
+    "    objectName: \"attributesRow\";\n"
+    "    anchors { %1 }\n"
+    "    color: %2;\n"
+    "    fontScale: root.fontScale;\n"
+    "    model: cardData && cardData[\"attributes\"];\n"
+    "}\n";
+
+// %1 is used as anchors of socialActionsRow
+// %2 is used as color of socialActionsRow
+static const char kSocialActionsRowCode[] =
+    "CardSocialActions {\n"
+    "    id: socialActionsRow;\n"
+    "    objectName: \"socialActionsRow\";\n"
+    "    anchors { %1 }\n"
+    "    color: %2;\n"
+    "    model: cardData && cardData[\"socialActions\"];\n"
+    "    onClicked: root.action(actionId);\n"
+    "}\n";
+
+// %1 is used as top anchor of summary
+// %2 is used as topMargin anchor of summary
+// %3 is used as color of summary
+static const char kSummaryLabelCode[] =
+    "Label {\n"
+    "    id: summary;\n"
+    "    objectName: \"summaryLabel\";\n"
+    "    anchors {\n"
+    "        top: %1;\n"
+    "        left: parent.left;\n"
+    "        right: parent.right;\n"
+    "        margins: units.gu(1);\n"
+    "        topMargin: %2;\n"
+    "    }\n"
+    "    wrapMode: Text.Wrap;\n"
+    "    maximumLineCount: 5;\n"
+    "    elide: Text.ElideRight;\n"
+    "    text: cardData && cardData[\"summary\"] || \"\";\n"
+    "    height: text ? implicitHeight : 0;\n"
+    "    fontSize: \"x-small\";\n"
+    "    font.weight: Font.Light;\n"
+    "    color: %3;\n"
+    "}\n";
+
+// %1 is used as bottom anchor of audio progress bar
+// %2 is used as left anchor of audio progress bar
+// %3 is used as text color
+static const char kAudioProgressBarCode[] =
+    "CardAudioProgress {\n"
+    "    id: audioProgressBar;\n"
+    "    duration: (cardData[\"quickPreviewData\"] && cardData[\"quickPreviewData\"][\"duration\"]) || 0;\n"
+    "    source: (cardData[\"quickPreviewData\"] && cardData[\"quickPreviewData\"][\"uri\"]) || \"\";\n"
+    "    anchors {\n"
+    "        bottom: %1;\n"
+    "        left: %2;\n"
+    "        right: parent.right;\n"
+    "        margins: units.gu(1);\n"
+    "    }\n"
+    "    color: %3;\n"
+    "}";
+
+// Mimics javascript truthiness of the JSON values we get from the scopes
+static bool isTruthy(const QVariant &value)
+{
+    switch (static_cast<int>(value.type())) {
+    case QMetaType::UnknownType:
+        return false;
+    case QMetaType::Bool:
+        return value.toBool();
+    case QMetaType::QString:
+        return !value.toString().isEmpty();
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Float:
+    case QMetaType::Double: {
+        const double number = value.toDouble();
+        return number != 0 && !qIsNaN(number);
+    }
+    default:
+        return !value.isNull();
+    }
+}
+
+static bool isString(const QVariant &value)
+{
+    return value.type() == QVariant::String;
+}
+
+static bool isObject(const QVariant &value)
+{
+    return value.type() == QVariant::Map || value.type() == QVariant::List;
+}
+
+static QVariantMap toMap(const QVariant &value)
+{
+    if (value.userType() == qMetaTypeId<QJSValue>()) {
+        return value.value<QJSValue>().toVariant().toMap();
+    }
+    return value.toMap();
+}
+
+static QString boolString(bool value)
+{
+    return value ? QStringLiteral("true") : QStringLiteral("false");
+}
+
+static QString sanitizeColor(const QString &color)
+{
+    // This is not the perfect check for a color
+    // but what we're trying to do here is just protect
+    // against injection so it's ok
+    Q_FOREACH(const QChar c, color) {
+        if (c.unicode() > 127 || !(c.isLetterOrNumber() || c == QLatin1Char('#'))) {
+            return QLatin1String("");
+        }
+    }
+    return color;
+}
+
+// Same as javascript encodeURI
+static QString encodeURI(const QString &uri)
+{
+    return QString::fromLatin1(QUrl::toPercentEncoding(uri, ";,/?:@&=+$!*'()#"));
+}
+
+CardDescription::CardDescription()
+ : interactive(true)
+ , horizontal(false)
+ , smallSize(false)
+ , overlay(false)
+ , audio(false)
+ , hasCardBackground(false)
+ , cardBackgroundIsString(false)
+ , hasArt(false)
+ , conciergeMode(false)
+ , artAspectRatio(QStringLiteral("1"))
+ , hasSummary(false)
+ , hasBackgroundComponent(false)
+ , hasTitle(false)
+ , titleAlignLeft(false)
+ , hasMascot(false)
+ , hasEmblem(false)
+ , hasSubtitle(false)
+ , hasAttributes(false)
+ , hasSocialActions(false)
+{
+    hasBackgroundColor[0] = hasBackgroundColor[1] = false;
+}
+
+CardDescription CardDescription::fromVariant(const QVariant &cardTemplate, const QVariant &components)
+{
+    const QVariantMap t = toMap(cardTemplate);
+    const QVariantMap c = toMap(components);
+    CardDescription d;
+
+    const QVariant nonInteractive = t.value(QStringLiteral("non-interactive"));
+    d.interactive = !nonInteractive.isValid() || !isTruthy(nonInteractive);
+    d.horizontal = t.value(QStringLiteral("card-layout")).toString() == QLatin1String("horizontal");
+    d.smallSize = t.value(QStringLiteral("card-size")).toString() == QLatin1String("small");
+    const QVariant overlay = t.value(QStringLiteral("overlay"));
+    d.overlay = overlay.type() == QVariant::Bool && overlay.toBool();
+    d.audio = t.value(QStringLiteral("quick-preview-type")).toString() == QLatin1String("audio");
+
+    const QVariant cardBackground = t.value(QStringLiteral("card-background"));
+    d.hasCardBackground = isTruthy(cardBackground);
+    d.cardBackgroundIsString = isString(cardBackground);
+    if (d.cardBackgroundIsString) {
+        d.cardBackground = cardBackground.toString();
+    } else if (cardBackground.type() == QVariant::Map) {
+        const QVariantMap background = cardBackground.toMap();
+        const QString type = background.value(QStringLiteral("type")).toString();
+        if (type == QLatin1String("color") || type == QLatin1String("gradient")) {
+            const QVariantList elements = background.value(QStringLiteral("elements")).toList();
+            for (int i = 0; i < 2 && i < elements.count(); ++i) {
+                if (elements[i].isValid()) {
+                    d.hasBackgroundColor[i] = true;
+                    d.backgroundColor[i] = sanitizeColor(elements[i].toString());
+                }
+            }
+        }
+    }
+
+    const QVariant art = c.value(QStringLiteral("art"));
+    const QVariantMap artMap = art.toMap();
+    d.hasArt = isTruthy(art) && isTruthy(artMap.value(QStringLiteral("field")));
+    d.conciergeMode = isTruthy(artMap.value(QStringLiteral("conciergeMode")));
+    const QVariant aspectRatio = artMap.value(QStringLiteral("aspect-ratio"));
+    if (isTruthy(aspectRatio)) {
+        if (isString(aspectRatio)) {
+            bool ok;
+            aspectRatio.toString().trimmed().toDouble(&ok);
+            if (ok) {
+                d.artAspectRatio = aspectRatio.toString();
+            }
+        } else if (aspectRatio.canConvert<double>() && aspectRatio.type() != QVariant::Bool) {
+            d.artAspectRatio = QString::number(aspectRatio.toDouble(), 'g', 15);
+        }
+    }
+    const QVariant artFallback = artMap.value(QStringLiteral("fallback"));
+    if (isTruthy(artFallback)) {
+        d.artFallback = artFallback.toString();
+    }
+
+    d.hasSummary = isTruthy(c.value(QStringLiteral("summary")));
+    d.hasBackgroundComponent = isTruthy(c.value(QStringLiteral("background")));
+
+    const QVariant title = c.value(QStringLiteral("title"));
+    d.hasTitle = isTruthy(title);
+    d.titleAlignLeft = !isObject(title) || title.toMap().value(QStringLiteral("align")).toString() == QLatin1String("left");
+    const QStringList leftAlignKeys = QStringList() << QStringLiteral("mascot") << QStringLiteral("emblem")
+                                                    << QStringLiteral("subtitle") << QStringLiteral("attributes")
+                                                    << QStringLiteral("summary");
+    Q_FOREACH(const QString &key, leftAlignKeys) {
+        const QVariant component = c.value(key);
+        if (isString(component) || isString(component.toMap().value(QStringLiteral("field")))) {
+            d.titleAlignLeft = true;
+        }
+    }
+
+    const QVariant mascot = c.value(QStringLiteral("mascot"));
+    d.hasMascot = isTruthy(mascot);
+    const QVariant mascotFallback = mascot.toMap().value(QStringLiteral("fallback"));
+    if (isTruthy(mascotFallback)) {
+        d.mascotFallback = mascotFallback.toString();
+    }
+
+    d.hasEmblem = isTruthy(c.value(QStringLiteral("emblem")));
+    d.hasSubtitle = isTruthy(c.value(QStringLiteral("subtitle")));
+    d.hasAttributes = isTruthy(c.value(QStringLiteral("attributes")).toMap().value(QStringLiteral("field")));
+    d.hasSocialActions = isTruthy(c.value(QStringLiteral("social-actions")));
+
+    return d;
+}
+
+bool CardDescription::operator==(const CardDescription &other) const
+{
+    return interactive == other.interactive
+        && horizontal == other.horizontal
+        && smallSize == other.smallSize
+        && overlay == other.overlay
+        && audio == other.audio
+        && hasCardBackground == other.hasCardBackground
+        && cardBackgroundIsString == other.cardBackgroundIsString
+        && cardBackground == other.cardBackground
+        && hasBackgroundColor[0] == other.hasBackgroundColor[0]
+        && hasBackgroundColor[1] == other.hasBackgroundColor[1]
+        && backgroundColor[0] == other.backgroundColor[0]
+        && backgroundColor[1] == other.backgroundColor[1]
+        && hasArt == other.hasArt
+        && conciergeMode == other.conciergeMode
+        && artAspectRatio == other.artAspectRatio
+        && artFallback == other.artFallback
+        && hasSummary == other.hasSummary
+        && hasBackgroundComponent == other.hasBackgroundComponent
+        && hasTitle == other.hasTitle
+        && titleAlignLeft == other.titleAlignLeft
+        && hasMascot == other.hasMascot
+        && mascotFallback == other.mascotFallback
+        && hasEmblem == other.hasEmblem
+        && hasSubtitle == other.hasSubtitle
+        && hasAttributes == other.hasAttributes
+        && hasSocialActions == other.hasSocialActions;
+}
+
+uint qHash(const CardDescription &d, uint seed)
+{
+    // All the flags fit in an int, only hash strings when there are some
+    const uint flags = d.interactive
+                     | d.horizontal << 1
+                     | d.smallSize << 2
+                     | d.overlay << 3
+                     | d.audio << 4
+                     | d.hasCardBackground << 5
+                     | d.cardBackgroundIsString << 6
+                     | d.hasBackgroundColor[0] << 7
+                     | d.hasBackgroundColor[1] << 8
+                     | d.hasArt << 9
+                     | d.conciergeMode << 10
+                     | d.hasSummary << 11
+                     | d.hasBackgroundComponent << 12
+                     | d.hasTitle << 13
+                     | d.titleAlignLeft << 14
+                     | d.hasMascot << 15
+                     | d.hasEmblem << 16
+                     | d.hasSubtitle << 17
+                     | d.hasAttributes << 18
+                     | d.hasSocialActions << 19;
+
+    uint hash = qHash(flags, seed) ^ qHash(d.artAspectRatio, seed);
+    if (!d.cardBackground.isEmpty()) hash ^= qHash(d.cardBackground, seed) * 3;
+    if (!d.backgroundColor[0].isEmpty()) hash ^= qHash(d.backgroundColor[0], seed) * 5;
+    if (!d.backgroundColor[1].isEmpty()) hash ^= qHash(d.backgroundColor[1], seed) * 7;
+    if (!d.artFallback.isEmpty()) hash ^= qHash(d.artFallback, seed) * 11;
+    if (!d.mascotFallback.isEmpty()) hash ^= qHash(d.mascotFallback, seed) * 13;
+    return hash;
+}
+
+static QString cacheVersion()
+{
+    return QStringLiteral("%1 Dash 0.1 Qt %2").arg(kCacheVersion).arg(QLatin1String(qVersion()));
+}
+
+CardCreator::CardCreator(QQmlEngine *engine, QObject *parent)
+ : QObject(parent)
+ , m_engine(engine)
+ , m_cacheDir(cacheDirectory())
+{
+    m_saveIndexTimer.setSingleShot(true);
+    m_saveIndexTimer.setInterval(5000);
+    connect(&m_saveIndexTimer, &QTimer::timeout, this, &CardCreator::saveIndex);
+
+    loadIndex();
+    prewarm();
+}
+
+CardCreator::~CardCreator()
+{
+    if (m_saveIndexTimer.isActive()) {
+        saveIndex();
+    }
+}
+
+QString CardCreator::cardString(const CardDescription &d, bool isCardTool, const QString &artShapeStyle, const QString &categoryLayout)
+{
+    QString code = QString::fromLatin1(kCardCode).arg(boolString(d.interactive));
+
+    if (!isCardTool) {
+        code += QLatin1String(kFixedSizesCode);
+    }
+
+    const bool hasArt = d.hasArt;
+    const bool hasSummary = d.hasSummary;
+    const bool isConciergeMode = d.conciergeMode;
+    const bool artAndSummary = hasArt && hasSummary && !isConciergeMode;
+    const bool isHorizontal = d.horizontal;
+    const bool hasBackground = (!isHorizontal && (d.hasCardBackground || d.hasBackgroundComponent || artAndSummary)) ||
+                               (hasSummary && (d.hasCardBackground || d.hasBackgroundComponent));
+    const bool hasTitle = d.hasTitle;
+    const bool hasMascot = d.hasMascot;
+    const bool hasEmblem = d.hasEmblem && !(hasMascot && d.smallSize);
+    const bool headerAsOverlay = hasArt && d.overlay && (hasTitle || hasMascot);
+    const bool hasSubtitle = hasTitle && d.hasSubtitle;
+    const bool hasHeaderRow = hasMascot && hasTitle;
+    const bool hasAttributes = hasTitle && d.hasAttributes;
+    const bool hasSocialActions = hasTitle && d.hasSocialActions;
+    const QString asynchronous = boolString(!isCardTool);
+
+    // For now we only support audio cards with [optional] art, title, subtitle
+    // in horizontal mode
+    // Anything else makes it behave not like an audio card
+    const bool isAudio = d.audio && !hasSummary && isHorizontal && !hasMascot && !hasEmblem && !headerAsOverlay && !hasAttributes;
+
+    code += QLatin1String("signal action(var actionId);\n");
+
+    if (hasBackground) {
+        QString templateCardBackground;
+        if (d.cardBackgroundIsString) {
+            templateCardBackground = QStringLiteral("decodeURI(\"%1\")").arg(encodeURI(d.cardBackground));
+        } else {
+            templateCardBackground = QStringLiteral("\"\"");
+        }
+
+        QString backgroundElements[2];
+        for (int i = 0; i < 2; ++i) {
+            if (d.hasBackgroundColor[i]) {
+                backgroundElements[i] = QStringLiteral("\"%1\"").arg(d.backgroundColor[i]);
+            } else {
+                backgroundElements[i] = QStringLiteral("undefined");
+            }
+        }
+        code += QString::fromLatin1(kBackgroundLoaderCode).arg(backgroundElements[0])
+                                                          .arg(backgroundElements[1])
+                                                          .arg(asynchronous)
+                                                          .arg(templateCardBackground);
+    }
+
+    if (hasArt) {
+        QString artShapeAspect;
+        if (isCardTool) {
+            code += QLatin1String("readonly property size artShapeSize: artShapeLoader.item ? Qt.size(artShapeLoader.item.width, artShapeLoader.item.height) : Qt.size(-1, -1);\n");
+            artShapeAspect = d.artAspectRatio;
+        } else {
+            artShapeAspect = QStringLiteral("(root.fixedArtShapeSize.width / root.fixedArtShapeSize.height)");
+        }
+
+        QString widthCode, heightCode;
+        QString artAnchors;
+        if (isHorizontal) {
+            artAnchors = QStringLiteral("left: parent.left");
+            widthCode = QStringLiteral("height * ") + artShapeAspect;
+            if (hasMascot || hasTitle) {
+                heightCode = QStringLiteral("headerHeight + 2 * units.gu(1)");
+            } else {
+                // This side of the else is a bit silly, who wants an horizontal layout without mascot and title?
+                // So we define a "random" height of the image height + 2 gu for the margins
+                heightCode = QStringLiteral("units.gu(7.625)");
+            }
+        } else {
+            artAnchors = QStringLiteral("horizontalCenter: parent.horizontalCenter;");
+            widthCode = QStringLiteral("root.width");
+            heightCode = QStringLiteral("width / ") + artShapeAspect;
+        }
+
+        const QString fallback = isCardTool ? QString() : encodeURI(d.artFallback);
+        QString fallbackStatusCode;
+        QString fallbackURICode = QStringLiteral("\"\"");
+        if (!fallback.isEmpty()) {
+            // fallbackStatusCode has %8 in it because we want to substitute it for fallbackURICode
+            // which in kArtShapeHolderCode is %8
+            fallbackStatusCode = QStringLiteral("onStatusChanged: if (status === Image.Error) source = %8;");
+            fallbackURICode = QStringLiteral("decodeURI(\"%1\")").arg(fallback);
+        }
+
+        QString artShapeHolderShapeCode;
+        if (!isConciergeMode) {
+            if (artShapeStyle == QLatin1String("icon")) {
+                artShapeHolderShapeCode = QLatin1String(kArtProportionalShapeCode);
+            } else {
+                QString artShapeHolderShapeAspect;
+                if (artShapeStyle == QLatin1String("inset")) {
+                    artShapeHolderShapeAspect = QStringLiteral("UbuntuShape.Inset");
+                } else if (artShapeStyle == QLatin1String("shadow")) {
+                    artShapeHolderShapeAspect = QStringLiteral("UbuntuShape.DropShadow");
+                } else {
+                    artShapeHolderShapeAspect = QStringLiteral("UbuntuShape.Flat");
+                }
+                artShapeHolderShapeCode = QString::fromLatin1(kArtUbuntuShapeCode).arg(artShapeHolderShapeAspect);
+            }
+        }
+
+        const char *artShapeHolderCode = isCardTool ? kArtShapeHolderCodeCardToolCard : kArtShapeHolderCode;
+        code += QString::fromLatin1(artShapeHolderCode).arg(artAnchors)
+                                                       .arg(widthCode)
+                                                       .arg(heightCode)
+                                                       .arg(boolString(isConciergeMode))
+                                                       .arg(asynchronous)
+                                                       .arg(artShapeHolderShapeCode)
+                                                       .arg(fallbackStatusCode)
+                                                       .arg(fallbackURICode);
+    } else if (isCardTool) {
+        code += QLatin1String("readonly property size artShapeSize: Qt.size(-1, -1);\n");
+    }
+
+    if (headerAsOverlay) {
+        const QString headerHeightCode = isCardTool ? QStringLiteral("headerHeight") : QStringLiteral("root.fixedHeaderHeight");
+        code += QString::fromLatin1(kOverlayLoaderCode).arg(asynchronous).arg(headerHeightCode);
+    }
+
+    QString headerVerticalAnchors;
+    if (headerAsOverlay) {
+        headerVerticalAnchors = QStringLiteral("bottom: artShapeLoader.bottom;\n"
+                                               "bottomMargin: units.gu(1);\n");
+    } else if (hasArt) {
+        if (isHorizontal) {
+            headerVerticalAnchors = QStringLiteral("top: artShapeLoader.top;\n"
+                                                   "topMargin: units.gu(1);\n");
+        } else {
+            headerVerticalAnchors = QStringLiteral("top: artShapeLoader.bottom;\n"
+                                                   "topMargin: units.gu(1);\n");
+        }
+    } else {
+        headerVerticalAnchors = QStringLiteral("top: parent.top;\n"
+                                               "topMargin: units.gu(1);\n");
+    }
+
+    QString headerLeftAnchor;
+    bool headerLeftAnchorHasMargin = false;
+    if (isHorizontal && hasArt) {
+        headerLeftAnchor = QStringLiteral("left: artShapeLoader.right;\n"
+                                          "leftMargin: units.gu(1);\n");
+        headerLeftAnchorHasMargin = true;
+    } else if (isHorizontal && isAudio) {
+        headerLeftAnchor = QStringLiteral("left: audioButton.right;\n"
+                                          "leftMargin: units.gu(1);\n");
+        headerLeftAnchorHasMargin = true;
+    } else {
+        headerLeftAnchor = QStringLiteral("left: parent.left;\n");
+    }
+
+    const bool touchdownOnArtShape = !hasBackground && hasArt && !hasMascot && !hasSummary && !isAudio;
+
+    if (hasHeaderRow) {
+        code += QLatin1String("readonly property int headerHeight: row.height;\n");
+    } else if (hasMascot) {
+        code += QLatin1String("readonly property int headerHeight: mascotImage.height;\n");
+    } else if (hasAttributes) {
+        if (hasTitle && hasSubtitle) {
+            code += QLatin1String("readonly property int headerHeight: titleLabel.height + subtitleLabel.height + subtitleLabel.anchors.topMargin + attributesRow.height + attributesRow.anchors.topMargin;\n");
+        } else if (hasTitle) {
+            code += QLatin1String("readonly property int headerHeight: titleLabel.height + attributesRow.height + attributesRow.anchors.topMargin;\n");
+        } else {
+            code += QLatin1String("readonly property int headerHeight: attributesRow.height;\n");
+        }
+    } else if (isAudio) {
+        if (hasSubtitle) {
+            code += QLatin1String("readonly property int headerHeight: titleLabel.height + subtitleLabel.height + subtitleLabel.anchors.topMargin + audioProgressBar.height + audioProgressBar.anchors.topMargin;\n");
+        } else if (hasTitle) {
+            code += QLatin1String("readonly property int headerHeight: titleLabel.height + audioProgressBar.height + audioProgressBar.anchors.topMargin;\n");
+        } else {
+            code += QLatin1String("readonly property int headerHeight: audioProgressBar.height;\n");
+        }
+    } else if (hasSubtitle) {
+        code += QLatin1String("readonly property int headerHeight: titleLabel.height + subtitleLabel.height + subtitleLabel.anchors.topMargin;\n");
+    } else if (hasTitle) {
+        code += QLatin1String("readonly property int headerHeight: titleLabel.height;\n");
+    } else {
+        code += QLatin1String("readonly property int headerHeight: 0;\n");
+    }
+
+    QString mascotShapeCode;
+    QString mascotCode;
+    if (hasMascot) {
+        const bool useMascotShape = !hasBackground && !headerAsOverlay;
+        QString mascotAnchors;
+        if (!hasHeaderRow) {
+            mascotAnchors += headerLeftAnchor;
+            mascotAnchors += headerVerticalAnchors;
+            if (!headerLeftAnchorHasMargin) {
+                mascotAnchors += QLatin1String("leftMargin: units.gu(1);\n");
+            }
+        } else {
+            mascotAnchors = QStringLiteral("verticalCenter: parent.verticalCenter;");
+        }
+
+        if (useMascotShape) {
+            mascotShapeCode = QString::fromLatin1(kMascotShapeLoaderCode).arg(mascotAnchors).arg(asynchronous);
+        }
+
+        const QString mascotImageVisible = useMascotShape ? QStringLiteral("false") : QStringLiteral("showHeader");
+        const QString fallback = isCardTool ? QString() : encodeURI(d.mascotFallback);
+        QString fallbackStatusCode;
+        QString fallbackURICode = QStringLiteral("\"\"");
+        if (!fallback.isEmpty()) {
+            // fallbackStatusCode has %4 in it because we want to substitute it for fallbackURICode
+            // which in kMascotImageCode is %4
+            fallbackStatusCode = QStringLiteral("onStatusChanged: if (status === Image.Error) source = %4;");
+            fallbackURICode = QStringLiteral("decodeURI(\"%1\")").arg(fallback);
+        }
+        mascotCode = QString::fromLatin1(kMascotImageCode).arg(mascotAnchors)
+                                                          .arg(mascotImageVisible)
+                                                          .arg(fallbackStatusCode)
+                                                          .arg(fallbackURICode);
+    }
+
+    const QString summaryColorWithBackground = QStringLiteral("backgroundLoader.active && backgroundLoader.item && root.scopeStyle ? root.scopeStyle.getTextColor(backgroundLoader.item.luminance) : (backgroundLoader.item && backgroundLoader.item.luminance > 0.7 ? theme.palette.normal.baseText : \"white\")");
+    const QString foregroundColor = QStringLiteral("root.scopeStyle ? root.scopeStyle.foreground : theme.palette.normal.baseText");
+
+    const bool hasTitleContainer = hasTitle && (hasEmblem || (hasMascot && (hasSubtitle || hasAttributes)));
+    QString titleSubtitleCode;
+    if (hasTitle) {
+        QString titleColor;
+        if (headerAsOverlay) {
+            titleColor = QStringLiteral("root.scopeStyle && overlayLoader.item ? root.scopeStyle.getTextColor(overlayLoader.item.luminance) : (overlayLoader.item && overlayLoader.item.luminance > 0.7 ? theme.palette.normal.baseText : \"white\")");
+        } else if (hasSummary) {
+            titleColor = QStringLiteral("summary.color");
+        } else if (hasBackground) {
+            titleColor = summaryColorWithBackground;
+        } else {
+            titleColor = foregroundColor;
+        }
+
+        QString titleAnchors;
+        QString subtitleAnchors;
+        QString attributesAnchors;
+        QString titleContainerAnchors;
+        QString titleRightAnchor;
+        QString titleWidth = QStringLiteral("undefined");
+
+        QString extraRightAnchor;
+        QString extraLeftAnchor;
+        if (!touchdownOnArtShape) {
+            extraRightAnchor = QStringLiteral("rightMargin: units.gu(1);\n");
+            extraLeftAnchor = QStringLiteral("leftMargin: units.gu(1);\n");
+        } else if (headerAsOverlay && !hasEmblem) {
+            extraRightAnchor = QStringLiteral("rightMargin: units.gu(1);\n");
+        }
+
+        if (hasMascot) {
+            titleContainerAnchors = QStringLiteral("verticalCenter: parent.verticalCenter; ");
+        } else {
+            titleContainerAnchors = QStringLiteral("right: parent.right; ");
+            titleContainerAnchors += headerLeftAnchor;
+            titleContainerAnchors += headerVerticalAnchors;
+            if (!headerLeftAnchorHasMargin) {
+                titleContainerAnchors += extraLeftAnchor;
+            }
+        }
+        if (hasEmblem) {
+            titleRightAnchor = QStringLiteral("right: emblemIcon.left;\n"
+                                              "rightMargin: emblemIcon.width > 0 ? units.gu(0.5) : 0;\n");
+        } else {
+            titleRightAnchor = QStringLiteral("right: parent.right;\n");
+            titleRightAnchor += extraRightAnchor;
+        }
+
+        if (hasTitleContainer) {
+            // Using headerTitleContainer
+            titleAnchors = titleRightAnchor;
+            titleAnchors += QLatin1String("left: parent.left;\n"
+                                          "top: parent.top;");
+            subtitleAnchors = QStringLiteral("right: parent.right;\n"
+                                             "left: parent.left;\n");
+            subtitleAnchors += extraRightAnchor;
+            if (hasSubtitle) {
+                attributesAnchors = subtitleAnchors + QLatin1String("top: subtitleLabel.bottom;\n");
+                subtitleAnchors += QLatin1String("top: titleLabel.bottom;\n");
+            } else {
+                attributesAnchors = subtitleAnchors + QLatin1String("top: titleLabel.bottom;\n");
+            }
+        } else if (hasMascot) {
+            // Using row without titleContainer
+            titleAnchors = QStringLiteral("verticalCenter: parent.verticalCenter;\n");
+            titleWidth = QStringLiteral("parent.width - x");
+        } else {
+            if (headerAsOverlay) {
+                // Using anchors to the overlay
+                titleAnchors = titleRightAnchor;
+                titleAnchors += QLatin1String("left: parent.left;\n"
+                                              "leftMargin: units.gu(1);\n"
+                                              "top: overlayLoader.top;\n"
+                                              "topMargin: units.gu(1) + overlayLoader.height - overlayLoader.overlayHeight;\n");
+            } else {
+                // Using anchors to the mascot/parent
+                titleAnchors = titleRightAnchor;
+                titleAnchors += headerLeftAnchor;
+                titleAnchors += headerVerticalAnchors;
+                if (!headerLeftAnchorHasMargin) {
+                    titleAnchors += extraLeftAnchor;
+                }
+            }
+            subtitleAnchors = QStringLiteral("left: titleLabel.left;\n"
+                                             "leftMargin: titleLabel.leftMargin;\n");
+            subtitleAnchors += extraRightAnchor;
+            if (hasEmblem) {
+                // using container
+                subtitleAnchors += QLatin1String("right: parent.right;\n");
+            } else {
+                subtitleAnchors += QLatin1String("right: titleLabel.right;\n");
+            }
+
+            if (hasSubtitle) {
+                attributesAnchors = subtitleAnchors + QLatin1String("top: subtitleLabel.bottom;\n");
+                subtitleAnchors += QLatin1String("top: titleLabel.bottom;\n");
+            } else {
+                attributesAnchors = subtitleAnchors + QLatin1String("top: titleLabel.bottom;\n");
+            }
+        }
+
+        const QString titleAlignment = isHorizontal || d.titleAlignLeft ? QStringLiteral("Text.AlignLeft")
+                                                                        : QStringLiteral("Text.AlignHCenter");
+
+        // code for different elements
+        const QString titleLabelVisibleExtra = headerAsOverlay ? QStringLiteral("&& overlayLoader.active") : QString();
+        const QString titleCode = QString::fromLatin1(kTitleLabelCode).arg(titleAnchors)
+                                                                      .arg(titleColor)
+                                                                      .arg(titleLabelVisibleExtra)
+                                                                      .arg(titleWidth)
+                                                                      .arg(titleAlignment);
+        QString subtitleCode;
+        QString attributesCode;
+
+        // code for the title container
+        QStringList containerCode;
+        QString containerHeight = QStringLiteral("titleLabel.height");
+        containerCode << titleCode;
+        if (hasSubtitle) {
+            subtitleCode = QString::fromLatin1(kSubtitleLabelCode).arg(subtitleAnchors).arg(titleColor);
+            containerCode << subtitleCode;
+            containerHeight += QLatin1String(" + subtitleLabel.height");
+        }
+        if (hasEmblem) {
+            containerCode << QString::fromLatin1(kEmblemIconCode).arg(extraRightAnchor).arg(titleColor);
+        }
+        if (hasAttributes) {
+            attributesCode = QString::fromLatin1(kAttributesRowCode).arg(attributesAnchors).arg(titleColor);
+            containerCode << attributesCode;
+            containerHeight += QLatin1String(" + attributesRow.height");
+        }
+
+        if (hasTitleContainer) {
+            // use container
+            titleSubtitleCode = QString::fromLatin1(kHeaderContainerCode).arg(titleContainerAnchors)
+                                                                         .arg(containerHeight)
+                                                                         .arg(containerCode.join(QLatin1Char(',')));
+        } else {
+            // no container
+            titleSubtitleCode = titleCode + subtitleCode + attributesCode;
+        }
+    }
+
+    if (hasHeaderRow) {
+        QStringList rowCode;
+        if (!mascotShapeCode.isEmpty()) {
+            rowCode << mascotShapeCode;
+        }
+        rowCode << mascotCode << titleSubtitleCode;
+        const QString heightCode = isCardTool ? QString() : QStringLiteral("height: root.fixedHeaderHeight;\n");
+        code += QString::fromLatin1(kHeaderRowCode).arg(heightCode)
+                                                   .arg(headerVerticalAnchors + headerLeftAnchor)
+                                                   .arg(rowCode.join(QLatin1Char(',')));
+    } else {
+        code += mascotShapeCode + mascotCode + titleSubtitleCode;
+    }
+
+    if (isAudio) {
+        code += QString::fromLatin1(kAudioProgressBarCode).arg(QStringLiteral("audioButton.bottom"))
+                                                          .arg(QStringLiteral("audioButton.right"))
+                                                          .arg(foregroundColor);
+
+        QString audioButtonAnchorsFill;
+        QString audioButtonWidth;
+        QString audioButtonHeight;
+        if (hasArt) {
+            audioButtonAnchorsFill = QStringLiteral("artShapeLoader");
+            audioButtonWidth = QStringLiteral("undefined");
+            audioButtonHeight = QStringLiteral("undefined");
+        } else {
+            audioButtonAnchorsFill = QStringLiteral("undefined");
+            audioButtonWidth = QStringLiteral("height");
+            audioButtonHeight = isCardTool ? QStringLiteral("headerHeight + 2 * units.gu(1)")
+                                           : QStringLiteral("root.fixedHeaderHeight + 2 * units.gu(1)");
+        }
+        code += QString::fromLatin1(kAudioButtonCode).arg(audioButtonAnchorsFill)
+                                                     .arg(audioButtonWidth)
+                                                     .arg(audioButtonHeight)
+                                                     .arg(asynchronous);
+    }
+
+    if (hasSummary) {
+        QString summaryTopAnchor;
+        if (isHorizontal && hasArt) summaryTopAnchor = QStringLiteral("artShapeLoader.bottom");
+        else if (headerAsOverlay && hasArt) summaryTopAnchor = QStringLiteral("artShapeLoader.bottom");
+        else if (hasHeaderRow) summaryTopAnchor = QStringLiteral("row.bottom");
+        else if (hasTitleContainer) summaryTopAnchor = QStringLiteral("headerTitleContainer.bottom");
+        else if (hasMascot) summaryTopAnchor = QStringLiteral("mascotImage.bottom");
+        else if (hasAttributes) summaryTopAnchor = QStringLiteral("attributesRow.bottom");
+        else if (hasSubtitle) summaryTopAnchor = QStringLiteral("subtitleLabel.bottom");
+        else if (hasTitle) summaryTopAnchor = QStringLiteral("titleLabel.bottom");
+        else if (hasArt) summaryTopAnchor = QStringLiteral("artShapeLoader.bottom");
+        else summaryTopAnchor = QStringLiteral("parent.top");
+
+        const QString summaryColor = hasBackground ? summaryColorWithBackground : foregroundColor;
+        const QString summaryTopMargin = hasMascot || hasSubtitle || hasAttributes ? QStringLiteral("anchors.margins") : QStringLiteral("0");
+
+        code += QString::fromLatin1(kSummaryLabelCode).arg(summaryTopAnchor).arg(summaryTopMargin).arg(summaryColor);
+    }
+
+    if (hasSocialActions) {
+        QString socialTopAnchor;
+        if (hasSummary) socialTopAnchor = QStringLiteral("summary.bottom;");
+        else if (isHorizontal && hasArt) socialTopAnchor = QStringLiteral("artShapeLoader.bottom;");
+        else if (headerAsOverlay && hasArt) socialTopAnchor = QStringLiteral("artShapeLoader.bottom;");
+        else if (hasHeaderRow) socialTopAnchor = QStringLiteral("row.bottom;");
+        else if (hasTitleContainer) socialTopAnchor = QStringLiteral("headerTitleContainer.bottom;");
+        else if (hasMascot) socialTopAnchor = QStringLiteral("mascotImage.bottom;");
+        else if (hasAttributes) socialTopAnchor = QStringLiteral("attributesRow.bottom;");
+        else if (hasSubtitle) socialTopAnchor = QStringLiteral("subtitleLabel.bottom;");
+        else if (hasTitle) socialTopAnchor = QStringLiteral("titleLabel.bottom;");
+        else if (hasArt) socialTopAnchor = QStringLiteral("artShapeLoader.bottom;");
+        else socialTopAnchor = QStringLiteral("parent.top");
+
+        const QString socialAnchors = QStringLiteral("top: ") + socialTopAnchor + QStringLiteral(" left: parent.left; right: parent.right; topMargin: units.gu(1);");
+        const QString socialColor = hasBackground ? summaryColorWithBackground : foregroundColor;
+
+        code += QString::fromLatin1(kSocialActionsRowCode).arg(socialAnchors).arg(socialColor);
+    }
+
+    if (artShapeStyle != QLatin1String("shadow") && artShapeStyle != QLatin1String("icon") && !isCardTool) {
+        QString touchdownAnchors;
+        if (hasBackground) {
+            touchdownAnchors = QStringLiteral("fill: backgroundLoader");
+        } else if (touchdownOnArtShape) {
+            touchdownAnchors = QStringLiteral("fill: artShapeLoader");
+        } else {
+            touchdownAnchors = QStringLiteral("fill: root");
+        }
+        code += QString::fromLatin1(kTouchdownCode).arg(touchdownAnchors);
+    }
+
+    if (isCardTool || categoryLayout != QLatin1String("grid")) {
+        if (hasSocialActions) {
+            code += QLatin1String("implicitHeight: socialActionsRow.y + socialActionsRow.height + units.gu(1);\n");
+        } else if (hasSummary) {
+            code += QLatin1String("implicitHeight: summary.y + summary.height + units.gu(1);\n");
+        } else if (isAudio) {
+            code += QLatin1String("implicitHeight: audioButton.height;\n");
+        } else if (headerAsOverlay) {
+            code += QLatin1String("implicitHeight: artShapeLoader.height;\n");
+        } else if (hasHeaderRow) {
+            code += QLatin1String("implicitHeight: row.y + row.height + units.gu(1);\n");
+        } else if (hasMascot) {
+            code += QLatin1String("implicitHeight: mascotImage.y + mascotImage.height;\n");
+        } else if (hasTitleContainer) {
+            code += QLatin1String("implicitHeight: headerTitleContainer.y + headerTitleContainer.height + units.gu(1);\n");
+        } else if (hasAttributes) {
+            code += QLatin1String("implicitHeight: attributesRow.y + attributesRow.height + units.gu(1);\n");
+        } else if (hasSubtitle) {
+            code += QLatin1String("implicitHeight: subtitleLabel.y + subtitleLabel.height + units.gu(1);\n");
+        } else if (hasTitle) {
+            code += QLatin1String("implicitHeight: titleLabel.y + titleLabel.height + units.gu(1);\n");
+        } else if (hasArt) {
+            code += QLatin1String("implicitHeight: artShapeLoader.height;\n");
+        }
+    }
+
+    // Close the AbstractButton
+    code += QLatin1String("}\n");
+
+    return code;
+}
+
+QString CardCreator::cardCode(const CardDescription &description, bool isCardTool, const QString &artShapeStyle, const QString &categoryLayout)
+{
+    return QLatin1String(kImportsCode) + cardString(description, isCardTool, artShapeStyle, categoryLayout);
+}
+
+QString CardCreator::cacheDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/unity8/cards/");
+}
+
+QQmlComponent *CardCreator::getCardComponent(const QVariant &cardTemplate, const QVariant &components, bool isCardTool,
+                                             const QString &artShapeStyle, const QString &categoryLayout)
+{
+    if (!cardTemplate.isValid() || !components.isValid())
+        return nullptr;
+
+    ComponentKey key;
+    key.description = CardDescription::fromVariant(cardTemplate, components);
+    key.isCardTool = isCardTool;
+    key.artShapeStyle = artShapeStyle;
+    key.categoryLayout = categoryLayout;
+
+    QQmlComponent *component = m_components.value(key);
+    if (component)
+        return component;
+
+    const QString code = cardCode(key.description, isCardTool, artShapeStyle, categoryLayout);
+    const QString fileName = QString::fromLatin1(QCryptographicHash::hash(code.toUtf8(), QCryptographicHash::Sha1).toHex())
+                           + QStringLiteral(".qml");
+
+    component = m_fileComponents.value(fileName);
+    if (!component) {
+        if (QFile::exists(m_cacheDir + fileName) || writeCardFile(fileName, code)) {
+            component = createComponent(fileName);
+            m_fileComponents.insert(fileName, component);
+        } else {
+            qWarning() << "CardCreator: Could not write" << m_cacheDir + fileName << ", compiling the card synchronously";
+            component = new QQmlComponent(m_engine, this);
+            connect(component, &QQmlComponent::statusChanged, this, &CardCreator::onComponentStatusChanged);
+            component->setData(code.toUtf8(), QUrl());
+        }
+    }
+
+    if (m_fileComponents.contains(fileName)) {
+        markUsed(fileName);
+    }
+
+    m_components.insert(key, component);
+    return component;
+}
+
+void CardCreator::onComponentStatusChanged()
+{
+    QQmlComponent *component = qobject_cast<QQmlComponent*>(sender());
+    if (component && component->isError()) {
+        qWarning() << "ERROR: Invalid component created." << component->url();
+        qWarning() << component->errors();
+    }
+}
+
+QQmlComponent *CardCreator::createComponent(const QString &fileName)
+{
+    // Loading from a file lets the type loader compile it in its own thread,
+    // setData would block us until the card is compiled
+    QQmlComponent *component = new QQmlComponent(m_engine, this);
+    connect(component, &QQmlComponent::statusChanged, this, &CardCreator::onComponentStatusChanged);
+    component->loadUrl(QUrl::fromLocalFile(m_cacheDir + fileName), QQmlComponent::Asynchronous);
+    return component;
+}
+
+bool CardCreator::writeCardFile(const QString &fileName, const QString &code)
+{
+    QSaveFile file(m_cacheDir + fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write(code.toUtf8());
+    return file.commit();
+}
+
+void CardCreator::loadIndex()
+{
+    QFile file(m_cacheDir + QLatin1String(kIndexFileName));
+    if (file.open(QIODevice::ReadOnly)) {
+        const QJsonObject index = QJsonDocument::fromJson(file.readAll()).object();
+        if (index.value(QStringLiteral("version")).toString() == cacheVersion()) {
+            const QJsonObject uses = index.value(QStringLiteral("uses")).toObject();
+            for (auto it = uses.constBegin(); it != uses.constEnd(); ++it) {
+                if (QFile::exists(m_cacheDir + it.key())) {
+                    m_uses.insert(it.key(), it.value().toInt());
+                }
+            }
+            return;
+        }
+    }
+
+    // Either there's no cache yet or it's from a different version
+    QDir(m_cacheDir).removeRecursively();
+    QDir().mkpath(m_cacheDir);
+}
+
+void CardCreator::prewarm()
+{
+    QStringList fileNames = m_uses.keys();
+    std::sort(fileNames.begin(), fileNames.end(), [this](const QString &a, const QString &b) {
+        return m_uses.value(a) > m_uses.value(b);
+    });
+
+    for (int i = 0; i < fileNames.count() && i < kPrewarmCount; ++i) {
+        m_fileComponents.insert(fileNames[i], createComponent(fileNames[i]));
+    }
+}
+
+void CardCreator::markUsed(const QString &fileName)
+{
+    if (m_usedThisSession.contains(fileName))
+        return;
+
+    m_usedThisSession.insert(fileName);
+    m_uses[fileName]++;
+    m_saveIndexTimer.start();
+}
+
+void CardCreator::saveIndex()
+{
+    m_saveIndexTimer.stop();
+
+    if (m_uses.count() > kMaxCachedCards) {
+        // Forget the least used cards, but not the ones we're using
+        QStringList fileNames = m_uses.keys();
+        std::sort(fileNames.begin(), fileNames.end(), [this](const QString &a, const QString &b) {
+            const bool aUsed = m_usedThisSession.contains(a);
+            const bool bUsed = m_usedThisSession.contains(b);
+            if (aUsed != bUsed)
+                return bUsed;
+            return m_uses.value(a) < m_uses.value(b);
+        });
+        for (int i = 0; i < fileNames.count() && m_uses.count() > kMaxCachedCards; ++i) {
+            m_uses.remove(fileNames[i]);
+            QFile::remove(m_cacheDir + fileNames[i]);
+            // The QML disk cache of the card, if any
+            QFile::remove(m_cacheDir + fileNames[i] + QLatin1Char('c'));
+        }
+    }
+
+    QJsonObject uses;
+    for (auto it = m_uses.constBegin(); it != m_uses.constEnd(); ++it) {
+        uses.insert(it.key(), it.value());
+    }
+
+    QJsonObject index;
+    index.insert(QStringLiteral("version"), cacheVersion());
+    index.insert(QStringLiteral("uses"), uses);
+
+    QSaveFile file(m_cacheDir + QLatin1String(kIndexFileName));
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(QJsonDocument(index).toJson(QJsonDocument::Compact));
+        file.commit();
+    }
+}
+
+bool CardCreator::ComponentKey::operator==(const ComponentKey &other) const
+{
+    return isCardTool == other.isCardTool
+        && artShapeStyle == other.artShapeStyle
+        && categoryLayout == other.categoryLayout
+        && description == other.description;
+}
+
+uint qHash(const CardCreator::ComponentKey &key, uint seed)
+{
+    return qHash(key.description, seed) ^ (key.isCardTool ? 1 : 0)
+         ^ qHash(key.artShapeStyle, seed) * 3 ^ qHash(key.categoryLayout, seed) * 5;
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CARDCREATOR_H
+#define CARDCREATOR_H
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+#include <QVariant>
+
+class QQmlComponent;
+class QQmlEngine;
+
+/**
+    The parts of a card template and its components that change the generated card
+
+    Scopes give us the template and the components as JSON objects,
+    we only keep what the code generator looks at, so that cards that
+    only differ in things we don't care about (e.g. the field names)
+    share the same description, and thus the same component.
+*/
+struct CardDescription
+{
+    CardDescription();
+
+    static CardDescription fromVariant(const QVariant &cardTemplate, const QVariant &components);
+
+    bool operator==(const CardDescription &other) const;
+    bool operator!=(const CardDescription &other) const { return !(*this == other); }
+
+    // Template
+    bool interactive;
+    bool horizontal;
+    bool smallSize;
+    bool overlay;
+    bool audio;
+    bool hasCardBackground;
+    bool cardBackgroundIsString;
+    QString cardBackground;
+    bool hasBackgroundColor[2];
+    QString backgroundColor[2];
+
+    // Components, as given by the scope, e.g. hasSubtitle doesn't
+    // mean there will be a subtitle if there is no title
+    bool hasArt;
+    bool conciergeMode;
+    QString artAspectRatio;
+    QString artFallback;
+    bool hasSummary;
+    bool hasBackgroundComponent;
+    bool hasTitle;
+    bool titleAlignLeft;
+    bool hasMascot;
+    QString mascotFallback;
+    bool hasEmblem;
+    bool hasSubtitle;
+    bool hasAttributes;
+    bool hasSocialActions;
+};
+
+uint qHash(const CardDescription &description, uint seed = 0);
+
+/**
+    Generates the QML code of the cards and compiles it into components
+
+    Components are cached, the key is the card description plus the
+    other arguments of getCardComponent, so each card layout is only
+    generated and compiled once.
+
+    Compilation happens asynchronously in the QML type loader thread,
+    the returned component may still be loading, which is fine since
+    Loader waits for its sourceComponent to be ready.
+
+    The generated code is also kept across sessions in
+    $XDG_CACHE_HOME/unity8/cards/, named after the hash of its contents,
+    together with an index of how many sessions used each card. On creation
+    we start loading the most used cards so that by the time the Dash asks
+    for them they are compiled (or loaded from the QML disk cache).
+    The whole directory is wiped when the cache version changes.
+*/
+class CardCreator : public QObject
+{
+    Q_OBJECT
+
+    friend class CardCreatorTest;
+
+public:
+    explicit CardCreator(QQmlEngine *engine, QObject *parent = nullptr);
+    ~CardCreator();
+
+    static QString cardString(const CardDescription &description, bool isCardTool, const QString &artShapeStyle, const QString &categoryLayout);
+
+    // Card code including the imports, ready to be compiled
+    static QString cardCode(const CardDescription &description, bool isCardTool, const QString &artShapeStyle, const QString &categoryLayout);
+
+    static QString cacheDirectory();
+
+    Q_INVOKABLE QQmlComponent *getCardComponent(const QVariant &cardTemplate, const QVariant &components, bool isCardTool,
+                                                const QString &artShapeStyle, const QString &categoryLayout);
+
+private Q_SLOTS:
+    void onComponentStatusChanged();
+    void saveIndex();
+
+private:
+    struct ComponentKey
+    {
+        bool operator==(const ComponentKey &other) const;
+
+        CardDescription description;
+        bool isCardTool;
+        QString artShapeStyle;
+        QString categoryLayout;
+    };
+    friend uint qHash(const CardCreator::ComponentKey &key, uint seed);
+
+    QQmlComponent *createComponent(const QString &fileName);
+    bool writeCardFile(const QString &fileName, const QString &code);
+    void loadIndex();
+    void prewarm();
+    void markUsed(const QString &fileName);
+
+    QQmlEngine *m_engine;
+    QString m_cacheDir;
+    QHash<ComponentKey, QQmlComponent*> m_components;
+
+    // Components by card file name, includes the prewarmed ones
+    QHash<QString, QQmlComponent*> m_fileComponents;
+
+    // Number of sessions that used each card file
+    QHash<QString, int> m_uses;
+    QSet<QString> m_usedThisSession;
+    QTimer m_saveIndexTimer;
+};
+
+#endif
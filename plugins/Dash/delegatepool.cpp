@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "delegatepool.h"
+
+#include <private/qqmldelegatemodel_p.h>
+#include <private/qquickitem_p.h>
+
+DelegatePool::DelegatePool()
+ : m_delegateModel(nullptr)
+ , m_capacity(0)
+ , m_hits(0)
+ , m_misses(0)
+{
+}
+
+void DelegatePool::setDelegateModel(QQmlDelegateModel *delegateModel)
+{
+    if (delegateModel != m_delegateModel) {
+        clear();
+        m_delegateModel = delegateModel;
+    }
+}
+
+int DelegatePool::capacity() const
+{
+    return m_capacity;
+}
+
+void DelegatePool::setCapacity(int capacity)
+{
+    m_capacity = qMax(0, capacity);
+    while (m_items.count() > m_capacity) {
+        releaseItem(m_items.takeFirst());
+    }
+}
+
+QObject *DelegatePool::object(int modelIndex, bool asynchronous)
+{
+    QObject *object = m_delegateModel->object(modelIndex, asynchronous);
+    QQuickItem *item = qmlobject_cast<QQuickItem*>(object);
+    if (item && m_items.removeOne(item)) {
+        // The delegate model gave us a new reference to the parked item
+        // drop the one the pool was holding
+        m_delegateModel->release(item);
+        ++m_hits;
+    } else if (object) {
+        ++m_misses;
+    }
+    return object;
+}
+
+void DelegatePool::park(QQuickItem *item)
+{
+    if (m_capacity == 0) {
+        releaseItem(item);
+        return;
+    }
+
+    QQuickItemPrivate::get(item)->setCulled(true);
+    m_items << item;
+    if (m_items.count() > m_capacity) {
+        releaseItem(m_items.takeFirst());
+    }
+}
+
+void DelegatePool::clear()
+{
+    Q_FOREACH(QQuickItem *item, m_items)
+        releaseItem(item);
+    m_items.clear();
+}
+
+int DelegatePool::count() const
+{
+    return m_items.count();
+}
+
+int DelegatePool::hits() const
+{
+    return m_hits;
+}
+
+int DelegatePool::misses() const
+{
+    return m_misses;
+}
+
+void DelegatePool::releaseItem(QQuickItem *item)
+{
+    QQmlDelegateModel::ReleaseFlags flags = m_delegateModel->release(item);
+    if (flags & QQmlDelegateModel::Destroyed) {
+        item->setParentItem(nullptr);
+    }
+}
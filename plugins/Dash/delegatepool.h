@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DELEGATEPOOL_H
+#define DELEGATEPOOL_H
+
+#include <QList>
+
+class QObject;
+class QQmlDelegateModel;
+class QQuickItem;
+
+/**
+    Keeps released delegates alive so they can be reused
+
+    Instead of giving a released item back to the QQmlDelegateModel
+    (that would destroy it) views park it in the pool culled. While
+    it's parked the pool keeps the delegate model reference, so the next
+    time the view asks for the same model row the delegate model
+    hands out the very same item and we avoid creating it again.
+
+    QQmlDelegateModel does not support binding an existing item to a
+    different row, so hits happen when rows come back to the viewport
+    (flicking back and forth, rebounds, cache buffer churn). Each view
+    has its own pool so parked items are always of the view delegate.
+
+    When the pool is full the least recently parked item is released.
+    The default capacity is 0, i.e. released items are not parked.
+*/
+class DelegatePool
+{
+public:
+    DelegatePool();
+
+    void setDelegateModel(QQmlDelegateModel *delegateModel);
+
+    int capacity() const;
+    void setCapacity(int capacity);
+
+    // Same as QQmlDelegateModel::object, taking the item out of the pool if it was parked
+    QObject *object(int modelIndex, bool asynchronous);
+
+    // Parks the item, the caller must not use it anymore
+    void park(QQuickItem *item);
+
+    // Releases all the parked items
+    void clear();
+
+    int count() const;
+    int hits() const;
+    int misses() const;
+
+private:
+    void releaseItem(QQuickItem *item);
+
+    QQmlDelegateModel *m_delegateModel;
+
+    // Least recently parked first
+    QList<QQuickItem *> m_items;
+
+    int m_capacity;
+    int m_hits;
+    int m_misses;
+};
+
+#endif
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "heightindex.h"
+
+static inline int lowestBit(int i)
+{
+    return i & -i;
+}
+
+HeightIndex::HeightIndex()
+ : m_measuredHeight(0)
+ , m_measuredCount(0)
+{
+}
+
+int HeightIndex::count() const
+{
+    return m_heights.count();
+}
+
+void HeightIndex::reset(int count)
+{
+    m_heights.fill(-1, qMax(0, count));
+    rebuild();
+}
+
+void HeightIndex::insert(int index, int count)
+{
+    if (count <= 0 || index < 0 || index > m_heights.count())
+        return;
+
+    m_heights.insert(index, count, -1);
+    rebuild();
+}
+
+void HeightIndex::remove(int index, int count)
+{
+    if (count <= 0 || index < 0 || index >= m_heights.count())
+        return;
+
+    m_heights.remove(index, qMin(count, m_heights.count() - index));
+    rebuild();
+}
+
+bool HeightIndex::isMeasured(int index) const
+{
+    return index >= 0 && index < m_heights.count() && m_heights[index] >= 0;
+}
+
+void HeightIndex::setHeight(int index, qreal height)
+{
+    if (index < 0 || index >= m_heights.count() || height < 0)
+        return;
+
+    const qreal oldHeight = m_heights[index];
+    if (oldHeight == height)
+        return;
+
+    m_heights[index] = height;
+    if (oldHeight < 0) {
+        add(index, height, 1);
+    } else {
+        add(index, height - oldHeight, 0);
+    }
+}
+
+void HeightIndex::invalidate(int index)
+{
+    if (!isMeasured(index))
+        return;
+
+    const qreal oldHeight = m_heights[index];
+    m_heights[index] = -1;
+    add(index, -oldHeight, -1);
+}
+
+qreal HeightIndex::estimatedHeight() const
+{
+    return m_measuredCount > 0 ? m_measuredHeight / m_measuredCount : 0;
+}
+
+qreal HeightIndex::position(int index) const
+{
+    index = qBound(0, index, m_heights.count());
+
+    qreal height = 0;
+    int measured = 0;
+    for (int i = index; i > 0; i -= lowestBit(i)) {
+        height += m_heightTree[i];
+        measured += m_measuredTree[i];
+    }
+    return height + (index - measured) * estimatedHeight();
+}
+
+qreal HeightIndex::totalHeight() const
+{
+    return m_measuredHeight + (m_heights.count() - m_measuredCount) * estimatedHeight();
+}
+
+int HeightIndex::indexAt(qreal position) const
+{
+    const int n = m_heights.count();
+    if (n == 0)
+        return -1;
+
+    if (position <= 0)
+        return 0;
+
+    const qreal estimated = estimatedHeight();
+    int mask = 1;
+    while (mask * 2 <= n)
+        mask *= 2;
+
+    // Find the biggest number of rows whose total height is <= position
+    int index = 0;
+    qreal accumulated = 0;
+    for (; mask > 0; mask /= 2) {
+        const int next = index + mask;
+        if (next <= n) {
+            // The node at next covers exactly mask rows
+            const qreal nodeHeight = m_heightTree[next] + (mask - m_measuredTree[next]) * estimated;
+            if (accumulated + nodeHeight <= position) {
+                index = next;
+                accumulated += nodeHeight;
+            }
+        }
+    }
+
+    return qMin(index, n - 1);
+}
+
+void HeightIndex::add(int index, qreal heightDiff, int measuredDiff)
+{
+    m_measuredHeight += heightDiff;
+    m_measuredCount += measuredDiff;
+    for (int i = index + 1; i < m_heightTree.count(); i += lowestBit(i)) {
+        m_heightTree[i] += heightDiff;
+        m_measuredTree[i] += measuredDiff;
+    }
+}
+
+void HeightIndex::rebuild()
+{
+    const int n = m_heights.count();
+    m_heightTree.fill(0, n + 1);
+    m_measuredTree.fill(0, n + 1);
+    m_measuredHeight = 0;
+    m_measuredCount = 0;
+
+    for (int i = 1; i <= n; ++i) {
+        const qreal height = m_heights[i - 1];
+        if (height >= 0) {
+            m_heightTree[i] += height;
+            m_measuredTree[i] += 1;
+            m_measuredHeight += height;
+            m_measuredCount++;
+        }
+        const int parent = i + lowestBit(i);
+        if (parent <= n) {
+            m_heightTree[parent] += m_heightTree[i];
+            m_measuredTree[parent] += m_measuredTree[i];
+        }
+    }
+}
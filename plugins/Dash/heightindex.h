@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HEIGHTINDEX_H
+#define HEIGHTINDEX_H
+
+#include <QVector>
+
+/**
+    Prefix sums over the heights of the rows of a list
+
+    Heights are only known for rows that have been measured (i.e. had a
+    delegate created at some point). Rows not measured yet are accounted
+    using the average of the measured ones, so the positions returned
+    are exact once every row above has been seen and a good estimate otherwise.
+
+    Measured heights and the number of measured rows are kept in two
+    Fenwick trees so position() and indexAt() are O(log n).
+    insert() and remove() need to shift rows so they are O(n), model changes
+    are much less frequent than scrolling so that's fine.
+*/
+class HeightIndex
+{
+public:
+    HeightIndex();
+
+    int count() const;
+
+    // Forgets all the measured heights and sets the number of rows
+    void reset(int count);
+
+    // Adds count unmeasured rows at index
+    void insert(int index, int count);
+
+    // Removes the count rows starting at index
+    void remove(int index, int count);
+
+    bool isMeasured(int index) const;
+    void setHeight(int index, qreal height);
+    void invalidate(int index);
+
+    // Height used for the rows that have not been measured yet
+    qreal estimatedHeight() const;
+
+    // Sum of the heights of the rows in [0, index)
+    qreal position(int index) const;
+
+    qreal totalHeight() const;
+
+    // Index of the row that contains position, -1 if there are no rows
+    int indexAt(qreal position) const;
+
+private:
+    void add(int index, qreal heightDiff, int measuredDiff);
+    void rebuild();
+
+    // -1 for rows without a measured height
+    QVector<qreal> m_heights;
+
+    // 1-based Fenwick trees
+    QVector<qreal> m_heightTree;
+    QVector<int> m_measuredTree;
+
+    qreal m_measuredHeight;
+    int m_measuredCount;
+};
+
+#endif
@@ -78,10 +78,16 @@
  * do it at the C++ level.
  *
  * Note that minYExtent and height are not always totally accurate, since
- * we don't have the items created we can't guess their heights
- * so we can only guarantee the values are correct when the first/last
- * items of the list are visible, otherwise we just live with good enough
- * values that make the list scrollable
+ * we don't have all the items created we can't know all their heights.
+ * m_heightIndex remembers the height of every item we have ever created
+ * and uses the average of those for the ones we have not, so the
+ * values get better the more the list has been scrolled and are correct
+ * when the first/last items of the list are visible.
+ *
+ * m_heightIndex is also used to find which item is at a given position
+ * without creating the items in between, e.g. when a long flick ends
+ * way past the items we have created we release them all and start
+ * filling again from the item that is at the new viewport.
  *
  * There are a few things that are not really implemented or tested properly
  * which we don't use at the moment like changing the model, changing
@@ -191,8 +197,10 @@ void ListViewWithPageHeader::setModel(QAbstractItemModel *model)
         } else {
             disconnect(m_delegateModel, &QQmlDelegateModel::modelUpdated, this, &ListViewWithPageHeader::onModelUpdated);
         }
+        m_delegatePool.clear();
         m_delegateModel->setModel(QVariant::fromValue<QAbstractItemModel *>(model));
         connect(m_delegateModel, &QQmlDelegateModel::modelUpdated, this, &ListViewWithPageHeader::onModelUpdated);
+        m_heightIndex.reset(m_delegateModel->count());
         Q_EMIT modelChanged();
         polish();
         // TODO?
@@ -219,7 +227,15 @@ void ListViewWithPageHeader::setDelegate(QQmlComponent *delegate)
         m_visibleItems.clear();
         initializeValuesForEmptyList();
 
+        // Items of the old delegate can't be reused
+        Q_FOREACH(ListItem *item, m_itemsToRelease)
+            reallyReleaseItem(item);
+        m_itemsToRelease.clear();
+        m_delegatePool.clear();
+
         m_delegateModel->setDelegate(delegate);
+        // Heights from the old delegate are meaningless for the new one
+        m_heightIndex.reset(m_delegateModel->count());
 
         Q_EMIT delegateChanged();
         m_delegateValidated = false;
@@ -359,6 +375,24 @@ void ListViewWithPageHeader::setCacheBuffer(int cacheBuffer)
     }
 }
 
+int ListViewWithPageHeader::delegatePoolSize() const
+{
+    return m_delegatePool.capacity();
+}
+
+void ListViewWithPageHeader::setDelegatePoolSize(int delegatePoolSize)
+{
+    if (delegatePoolSize < 0) {
+        qmlInfo(this) << "Cannot set a negative delegate pool size";
+        return;
+    }
+
+    if (delegatePoolSize != m_delegatePool.capacity()) {
+        m_delegatePool.setCapacity(delegatePoolSize);
+        Q_EMIT delegatePoolSizeChanged();
+    }
+}
+
 void ListViewWithPageHeader::positionAtBeginning()
 {
     if (m_delegateModel->count() <= 0)
@@ -451,6 +485,16 @@ QQuickItem *ListViewWithPageHeader::item(int modelIndex) const
         return nullptr;
 }
 
+int ListViewWithPageHeader::delegatePoolHits() const
+{
+    return m_delegatePool.hits();
+}
+
+int ListViewWithPageHeader::delegatePoolMisses() const
+{
+    return m_delegatePool.misses();
+}
+
 bool ListViewWithPageHeader::maximizeVisibleArea(int modelIndex)
 {
     ListItem *listItem = itemAtIndex(modelIndex);
@@ -620,6 +664,7 @@ void ListViewWithPageHeader::adjustHeader(qreal diff)
 void ListViewWithPageHeader::createDelegateModel()
 {
     m_delegateModel = new QQmlDelegateModel(qmlContext(this), this);
+    m_delegatePool.setDelegateModel(m_delegateModel);
     connect(m_delegateModel, &QQmlDelegateModel::createdItem, this, &ListViewWithPageHeader::itemCreated);
     if (isComponentComplete())
         m_delegateModel->componentComplete();
@@ -660,6 +705,18 @@ bool ListViewWithPageHeader::addVisibleItems(qreal fillFrom, qreal fillTo, bool
     ListItem *item;
 //     qDebug() << "ListViewWithPageHeader::addVisibleItems" << fillFrom << fillTo << asynchronous;
 
+    if (!asynchronous && !m_visibleItems.isEmpty()) {
+        // If we are far away from the items we have (e.g. after a long flick)
+        // start again from the item at fillFrom instead of creating all the ones in between
+        ListItem *firstItem = m_visibleItems.first();
+        ListItem *lastItem = m_visibleItems.last();
+        const qreal createdFrom = firstItem->y() + m_clipItem->y();
+        const qreal createdTo = lastItem->y() + lastItem->height() + m_clipItem->y();
+        if (createdTo + m_cacheBuffer < fillFrom || createdFrom - m_cacheBuffer > fillTo) {
+            jumpToPosition(fillFrom);
+        }
+    }
+
     int modelIndex = 0;
     qreal pos = 0;
     if (!m_visibleItems.isEmpty()) {
@@ -697,13 +754,40 @@ bool ListViewWithPageHeader::addVisibleItems(qreal fillFrom, qreal fillTo, bool
     return changed;
 }
 
-void ListViewWithPageHeader::reallyReleaseItem(ListItem *listItem)
+bool ListViewWithPageHeader::jumpToPosition(qreal position)
 {
-    QQuickItem *item = listItem->m_item;
-    QQmlDelegateModel::ReleaseFlags flags = m_delegateModel->release(item);
-    if (flags & QQmlDelegateModel::Destroyed) {
-        item->setParentItem(nullptr);
+    // Where the first item of the model starts, see adjustMinYExtent()
+    const qreal listStart = -m_minYExtent + (m_headerItem ? m_headerItem->implicitHeight() : 0);
+    const int modelIndex = m_heightIndex.indexAt(position - listStart);
+    if (modelIndex < 0 || modelIndex >= m_delegateModel->count())
+        return false;
+
+    // If it's just before or after the items we have the normal refill will do
+    if (modelIndex >= m_firstVisibleIndex - 1 && modelIndex <= m_firstVisibleIndex + m_visibleItems.count())
+        return false;
+
+    const qreal itemPos = listStart + m_heightIndex.position(modelIndex);
+
+    Q_FOREACH(ListItem *item, m_visibleItems)
+        releaseItem(item);
+    m_visibleItems.clear();
+    m_firstVisibleIndex = -1;
+
+    ListItem *item = createItem(modelIndex, false);
+    if (!item) {
+        initializeValuesForEmptyList();
+        return false;
     }
+    item->setY(itemPos - m_clipItem->y());
+    adjustMinYExtent();
+    layout();
+
+    return true;
+}
+
+void ListViewWithPageHeader::reallyReleaseItem(ListItem *listItem)
+{
+    m_delegatePool.park(listItem->m_item);
     if (listItem->sectionItem()) {
         listItem->sectionItem()->deleteLater();
     }
@@ -871,7 +955,7 @@ ListViewWithPageHeader::ListItem *ListViewWithPageHeader::createItem(int modelIn
         return nullptr;
 
     m_asyncRequestedIndex = -1;
-    QObject* object = m_delegateModel->object(modelIndex, asynchronous);
+    QObject* object = m_delegatePool.object(modelIndex, asynchronous);
     QQuickItem *item = qmlobject_cast<QQuickItem*>(object);
     if (!item) {
         if (object) {
@@ -918,6 +1002,7 @@ ListViewWithPageHeader::ListItem *ListViewWithPageHeader::createItem(int modelIn
             releaseItem(listItem);
             listItem = nullptr;
         } else {
+            m_heightIndex.setHeight(modelIndex, listItem->height());
             listItem->setCulled(listItem->y() + listItem->height() + m_clipItem->y() <= contentY() || listItem->y() + m_clipItem->y() >= contentY() + height());
             if (m_visibleItems.isEmpty()) {
                 m_visibleItems << listItem;
@@ -987,7 +1072,7 @@ void ListViewWithPageHeader::onHeightChanged()
 }
 
 
-void ListViewWithPageHeader::onModelUpdated(const QQmlChangeSet &changeSet, bool /*reset*/)
+void ListViewWithPageHeader::onModelUpdated(const QQmlChangeSet &changeSet, bool reset)
 {
     // TODO Do something with reset
 //     qDebug() << "ListViewWithPageHeader::onModelUpdated" << changeSet << reset;
@@ -995,6 +1080,7 @@ void ListViewWithPageHeader::onModelUpdated(const QQmlChangeSet &changeSet, bool
 
     Q_FOREACH(const QQmlChangeSet::Change remove, changeSet.removes()) {
 //         qDebug() << "ListViewWithPageHeader::onModelUpdated Remove" << remove.index << remove.count;
+        m_heightIndex.remove(remove.index, remove.count);
         if (remove.index + remove.count > m_firstVisibleIndex && remove.index < m_firstVisibleIndex + m_visibleItems.count()) {
             const qreal oldFirstValidIndexPos = m_visibleItems.first()->y();
             // If all the items we are removing are either not created or culled
@@ -1048,6 +1134,7 @@ void ListViewWithPageHeader::onModelUpdated(const QQmlChangeSet &changeSet, bool
 
     Q_FOREACH(const QQmlChangeSet::Change insert, changeSet.inserts()) {
 //         qDebug() << "ListViewWithPageHeader::onModelUpdated Insert" << insert.index << insert.count;
+        m_heightIndex.insert(insert.index, insert.count);
         const bool insertingInValidIndexes = insert.index > m_firstVisibleIndex && insert.index < m_firstVisibleIndex + m_visibleItems.count();
         const bool firstItemWithViewOnTop = insert.index == 0 && m_firstVisibleIndex == 0 && m_visibleItems.first()->y() + m_clipItem->y() > contentY();
         if (insertingInValidIndexes || firstItemWithViewOnTop)
@@ -1107,6 +1194,10 @@ void ListViewWithPageHeader::onModelUpdated(const QQmlChangeSet &changeSet, bool
     Q_FOREACH(const QQmlChangeSet::Change change, changeSet.changes()) {
         for (int i = change.start(); i < change.end(); ++i) {
             updateSectionItem(i);
+            // The created ones will be measured again in layout()
+            if (!itemAtIndex(i)) {
+                m_heightIndex.invalidate(i);
+            }
         }
         // Also update the section header for the next item after the change since it may be influenced
         updateSectionItem(change.end());
@@ -1127,6 +1218,17 @@ void ListViewWithPageHeader::onModelUpdated(const QQmlChangeSet &changeSet, bool
         }
     }
 
+    // Parked items may belong to rows that are gone
+    if (reset || !changeSet.removes().isEmpty()) {
+        m_delegatePool.clear();
+    }
+
+    if (reset) {
+        m_heightIndex.reset(m_delegateModel->count());
+    } else {
+        syncHeightIndex();
+    }
+
     layout();
     polish();
     m_contentHeightDirty = true;
@@ -1212,17 +1314,7 @@ void ListViewWithPageHeader::adjustMinYExtent()
     if (m_visibleItems.isEmpty() || (contentHeight() + m_minYExtent < height())) {
         m_minYExtent = 0;
     } else {
-        qreal nonCreatedHeight = 0;
-        if (m_firstVisibleIndex != 0) {
-            // Calculate the average height of items to estimate the position of the list start
-            const int visibleItems = m_visibleItems.count();
-            qreal visibleItemsHeight = 0;
-            Q_FOREACH(ListItem *item, m_visibleItems) {
-                visibleItemsHeight += item->height();
-            }
-            nonCreatedHeight = m_firstVisibleIndex * visibleItemsHeight / visibleItems;
-//             qDebug() << m_firstVisibleIndex << visibleItemsHeight << visibleItems << nonCreatedHeight;
-        }
+        const qreal nonCreatedHeight = m_heightIndex.position(m_firstVisibleIndex);
         const qreal headerHeight = (m_headerItem ? m_headerItem->implicitHeight() : 0);
         m_minYExtent = nonCreatedHeight - m_visibleItems.first()->y() - m_clipItem->y() + headerHeight;
         if (m_minYExtent != 0 && qFuzzyIsNull(m_minYExtent)) {
@@ -1232,6 +1324,14 @@ void ListViewWithPageHeader::adjustMinYExtent()
     }
 }
 
+void ListViewWithPageHeader::syncHeightIndex()
+{
+    // Should not happen since we follow all the model updates, but better safe than sorry
+    if (m_delegateModel && m_heightIndex.count() != m_delegateModel->count()) {
+        m_heightIndex.reset(m_delegateModel->count());
+    }
+}
+
 ListViewWithPageHeader::ListItem *ListViewWithPageHeader::itemAtIndex(int modelIndex) const
 {
     const int visibleIndexedModelIndex = modelIndex - m_firstVisibleIndex;
@@ -1260,6 +1360,7 @@ void ListViewWithPageHeader::layout()
             const bool cull = pos + item->height() <= visibleFrom || pos >= visibleTo;
             item->setCulled(cull);
             item->setY(pos);
+            m_heightIndex.setHeight(modelIndex, item->height());
             if (!cull && firstReallyVisibleItem == -1) {
                 firstReallyVisibleItem = modelIndex;
                 if (m_topSectionItem) {
@@ -1353,6 +1454,8 @@ void ListViewWithPageHeader::updatePolish()
     if (!model())
         return;
 
+    syncHeightIndex();
+
     layout();
 
     refill();
@@ -1362,19 +1465,8 @@ void ListViewWithPageHeader::updatePolish()
         if (m_visibleItems.isEmpty()) {
             contentHeight = m_headerItem ? m_headerItem->height() : 0;
         } else {
-            const int modelCount = model()->rowCount();
-            const int visibleItems = m_visibleItems.count();
-            const int lastValidIndex = m_firstVisibleIndex + visibleItems - 1;
-            qreal nonCreatedHeight = 0;
-            if (lastValidIndex != modelCount - 1) {
-                const int visibleItems = m_visibleItems.count();
-                qreal visibleItemsHeight = 0;
-                Q_FOREACH(ListItem *item, m_visibleItems) {
-                    visibleItemsHeight += item->height();
-                }
-                const int unknownSizes = modelCount - (m_firstVisibleIndex + visibleItems);
-                nonCreatedHeight = unknownSizes * visibleItemsHeight / visibleItems;
-            }
+            const int lastValidIndex = m_firstVisibleIndex + m_visibleItems.count() - 1;
+            const qreal nonCreatedHeight = m_heightIndex.totalHeight() - m_heightIndex.position(lastValidIndex + 1);
             ListItem *item = m_visibleItems.last();
             contentHeight = nonCreatedHeight + item->y() + item->height() + m_clipItem->y();
             if (m_firstVisibleIndex != 0) {
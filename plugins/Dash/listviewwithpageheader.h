@@ -20,6 +20,9 @@
 #include <private/qquickitemchangelistener_p.h>
 #include <private/qquickflickable_p.h>
 
+#include "delegatepool.h"
+#include "heightindex.h"
+
 class QAbstractItemModel;
 class QQuickNumberAnimation;
 class QQmlChangeSet;
@@ -55,6 +58,7 @@ class ListViewWithPageHeader : public QQuickFlickable, public QQuickItemChangeLi
     Q_PROPERTY(int stickyHeaderHeight READ stickyHeaderHeight NOTIFY stickyHeaderHeightChanged)
     Q_PROPERTY(qreal headerItemShownHeight READ headerItemShownHeight NOTIFY headerItemShownHeightChanged)
     Q_PROPERTY(int cacheBuffer READ cacheBuffer WRITE setCacheBuffer NOTIFY cacheBufferChanged)
+    Q_PROPERTY(int delegatePoolSize READ delegatePoolSize WRITE setDelegatePoolSize NOTIFY delegatePoolSizeChanged)
 
     friend class ListViewWithPageHeaderTest;
     friend class ListViewWithPageHeaderTestSection;
@@ -88,11 +92,16 @@ public:
     int cacheBuffer() const;
     void setCacheBuffer(int cacheBuffer);
 
+    int delegatePoolSize() const;
+    void setDelegatePoolSize(int delegatePoolSize);
+
     Q_INVOKABLE void positionAtBeginning();
     Q_INVOKABLE void showHeader();
     Q_INVOKABLE int firstCreatedIndex() const;
     Q_INVOKABLE int createdItemCount() const;
     Q_INVOKABLE QQuickItem *item(int modelIndex) const;
+    Q_INVOKABLE int delegatePoolHits() const;
+    Q_INVOKABLE int delegatePoolMisses() const;
 
     // The index has to be created for this to try to do something
     // Created items are those visible and the precached ones
@@ -110,6 +119,7 @@ Q_SIGNALS:
     void stickyHeaderHeightChanged();
     void headerItemShownHeightChanged();
     void cacheBufferChanged();
+    void delegatePoolSizeChanged();
 
 protected:
     void componentComplete() override;
@@ -157,6 +167,7 @@ private:
     bool addVisibleItems(qreal fillFrom, qreal fillTo, bool asynchronous);
     bool removeNonVisibleItems(qreal bufferFrom, qreal bufferTo);
     ListItem *createItem(int modelIndex, bool asynchronous);
+    bool jumpToPosition(qreal position);
 
     void adjustHeader(qreal diff);
     void adjustMinYExtent();
@@ -170,8 +181,10 @@ private:
     QQuickItem *getSectionItem(const QString &sectionText, bool watchGeometry = true);
     void updateSectionItem(int modelIndex);
     void initializeValuesForEmptyList();
+    void syncHeightIndex();
 
     QQmlDelegateModel *m_delegateModel;
+    DelegatePool m_delegatePool;
 
     // Index we are waiting because we requested it asynchronously
     int m_asyncRequestedIndex;
@@ -183,6 +196,10 @@ private:
     QList<ListItem *> m_visibleItems;
     int m_firstVisibleIndex;
 
+    // Heights of all the model rows, measured when their delegate
+    // has been created and estimated otherwise
+    HeightIndex m_heightIndex;
+
     qreal m_minYExtent;
 
     QQuickItem *m_clipItem;
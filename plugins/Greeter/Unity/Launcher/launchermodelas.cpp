@@ -194,19 +194,26 @@ void LauncherModel::refresh()
     if (!m_accounts || m_user.isEmpty()) {
         refreshWithItems(QList<QVariantMap>());
     } else {
-        QDBusPendingCall pendingCall = m_accounts->getUserPropertyAsync(m_user, QStringLiteral("com.canonical.unity.AccountsService"), QStringLiteral("LauncherItems"));
-        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(pendingCall, this);
-        connect(watcher, &QDBusPendingCallWatcher::finished,
-            this, [this](QDBusPendingCallWatcher* watcher) {
-
-            QDBusPendingReply<QVariant> reply = *watcher;
-            watcher->deleteLater();
-            if (reply.isError()) {
-                qWarning() << "Failed to refresh LauncherItems" << reply.error().message();
+        const QString user = m_user;
+        m_accounts->whenUserFound(user, this, [this, user]() {
+            if (m_user != user) {
                 return;
             }
 
-            refreshWithItems(qdbus_cast<QList<QVariantMap>>(reply.value().value<QDBusArgument>()));
+            QDBusPendingCall pendingCall = m_accounts->getUserPropertyAsync(m_user, QStringLiteral("com.canonical.unity.AccountsService"), QStringLiteral("LauncherItems"));
+            QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(pendingCall, this);
+            connect(watcher, &QDBusPendingCallWatcher::finished,
+                this, [this](QDBusPendingCallWatcher* watcher) {
+
+                QDBusPendingReply<QVariant> reply = *watcher;
+                watcher->deleteLater();
+                if (reply.isError()) {
+                    qWarning() << "Failed to refresh LauncherItems" << reply.error().message();
+                    return;
+                }
+
+                refreshWithItems(qdbus_cast<QList<QVariantMap>>(reply.value().value<QDBusArgument>()));
+            });
         });
     }
 }
@@ -14,18 +14,395 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <QCache>
 #include <QDateTime>
 #include <QDebug>
 #include <QDir>
+#include <QDirIterator>
+#include <QHash>
+#include <QMutex>
+#include <QRunnable>
+#include <QSaveFile>
 #include <QUrl>
 #include <QUrlQuery>
+#include <QVector>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
 
 #include "ImageCache.h"
+#include "ImageCacheStats.h"
+
+class ImageCacheResponse;
+
+struct SourceInfo
+{
+    QDateTime lastModified;
+    QSize size;
+};
+
+// Header of the raw files, followed by the pixels
+struct RawHeader
+{
+    char magic[8];
+    quint32 width;
+    quint32 height;
+    quint32 bytesPerLine;
+    quint32 format;
+};
+
+static const char rawMagic[8] = { 'U', '8', 'I', 'C', 'R', 'A', 'W', '1' };
+
+struct RawMapping
+{
+    void *address;
+    size_t length;
+};
+
+static void unmapRawImage(void *info)
+{
+    auto mapping = static_cast<RawMapping*>(info);
+    munmap(mapping->address, mapping->length);
+    delete mapping;
+}
+
+struct DiskEntry
+{
+    DiskEntry() : size(0) {}
+
+    qint64 size;
+    QDateTime lastAccess;
+};
+
+// Everything here is protected by mutex
+class ImageCacheState
+{
+public:
+    ImageCacheState()
+      : images(ImageCache::MemoryBudget)
+      , diskScanned(false)
+      , diskBytes(0)
+    {
+    }
+
+    QMutex mutex;
+
+    // Decoded images, the cost is their size in bytes
+    QCache<ImageCacheKey, QImage> images;
+
+    // Sizes of the source images, so we don't read their header every time
+    QHash<QString, SourceInfo> sources;
+
+    // Responses waiting for an image being decoded
+    QHash<ImageCacheKey, QList<ImageCacheResponse*>> pending;
+
+    // Files on disk, known once the writer went through the directory
+    bool diskScanned;
+    QHash<QString, DiskEntry> files;
+    qint64 diskBytes;
+};
+
+class ImageCacheResponse: public QQuickImageResponse
+{
+public:
+    ImageCacheResponse(const QSharedPointer<ImageCacheState> &state, const ImageCacheKey &key)
+      : m_state(state)
+      , m_key(key)
+    {
+    }
+
+    ~ImageCacheResponse()
+    {
+        QMutexLocker locker(&m_state->mutex);
+        auto it = m_state->pending.find(m_key);
+        if (it != m_state->pending.end()) {
+            it->removeOne(this);
+        }
+    }
+
+    QQuickTextureFactory *textureFactory() const override
+    {
+        return QQuickTextureFactory::textureFactoryForImage(m_image);
+    }
+
+    QString errorString() const override
+    {
+        return m_errorString;
+    }
+
+    // Must be called with the state mutex locked, so that we're not deleted meanwhile
+    void finish(const QImage &image, const QString &errorString)
+    {
+        m_image = image;
+        m_errorString = errorString;
+        if (m_image.isNull() && m_errorString.isEmpty()) {
+            m_errorString = QStringLiteral("ImageCache could not read image %1").arg(m_key.path);
+        }
+        // Whoever asked for us connects to finished once we're returned
+        QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection);
+    }
+
+private:
+    QSharedPointer<ImageCacheState> m_state;
+    ImageCacheKey m_key;
+    QImage m_image;
+    QString m_errorString;
+};
+
+// Runs in the writer pool, so there's only one at a time
+class ImageCacheWriteJob: public QRunnable
+{
+public:
+    // Without an image this only makes sure we are under the disk budget
+    ImageCacheWriteJob(const QSharedPointer<ImageCacheState> &state, ImageCacheStats *stats,
+                       const QImage &image = QImage(), const QString &cachePath = QString(),
+                       const QByteArray &format = QByteArray())
+      : m_state(state)
+      , m_stats(stats)
+      , m_image(image)
+      , m_cachePath(cachePath)
+      , m_format(format)
+    {
+    }
+
+    void run() override
+    {
+        if (!m_state->diskScanned) {
+            scan();
+        }
+        if (!m_image.isNull()) {
+            write();
+        }
+        evict();
+    }
+
+private:
+    void scan()
+    {
+        QHash<QString, DiskEntry> files;
+        qint64 bytes = 0;
+
+        QDirIterator it(ImageCache::imageCacheRoot(), QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            it.next();
+            DiskEntry entry;
+            entry.size = it.fileInfo().size();
+            entry.lastAccess = it.fileInfo().lastRead();
+            files.insert(it.filePath(), entry);
+            bytes += entry.size;
+        }
+
+        QMutexLocker locker(&m_state->mutex);
+        m_state->files = files;
+        m_state->diskBytes = bytes;
+        m_state->diskScanned = true;
+    }
+
+    void write()
+    {
+        QByteArray format = m_format.isEmpty() ? QByteArrayLiteral("png") : m_format;
+        if (m_stats->fastFormat()) {
+            // Quality 100 means no compression at all for PNG
+            format = QByteArrayLiteral("png");
+        }
+
+        // Raw files are big, don't let one of them push everything else out
+        const bool raw = m_stats->rawFormat() &&
+                         ImageCache::rawImageSize(m_image) * ImageCache::RawBudgetShare <= m_stats->diskBudget();
+
+        QFileInfo(m_cachePath).dir().mkpath(QStringLiteral("."));
+        QSaveFile file(m_cachePath);
+        bool written = file.open(QIODevice::WriteOnly);
+        if (written && raw) {
+            written = ImageCache::writeRawImage(&file, m_image);
+        } else if (written) {
+            written = m_image.save(&file, format.constData(), 100);
+        }
+        if (!written || !file.commit()) {
+            qWarning() << "ImageCache could not write image" << m_cachePath << ":" << file.errorString();
+            return;
+        }
+
+        DiskEntry entry;
+        entry.size = QFileInfo(m_cachePath).size();
+        entry.lastAccess = QDateTime::currentDateTime();
+
+        QMutexLocker locker(&m_state->mutex);
+        m_state->diskBytes += entry.size - m_state->files.value(m_cachePath).size;
+        m_state->files.insert(m_cachePath, entry);
+    }
+
+    void evict()
+    {
+        const qint64 budget = m_stats->diskBudget();
+        QStringList evicted;
+        qint64 bytes;
+
+        {
+            QMutexLocker locker(&m_state->mutex);
+            if (m_state->diskBytes > budget) {
+                // Go a bit further than needed, so we don't sort everything on every write
+                const qint64 target = budget - budget / 10;
+
+                QVector<QPair<QDateTime, QString>> byAccess;
+                byAccess.reserve(m_state->files.count());
+                for (auto it = m_state->files.constBegin(); it != m_state->files.constEnd(); ++it) {
+                    byAccess.append(qMakePair(it->lastAccess, it.key()));
+                }
+                std::sort(byAccess.begin(), byAccess.end());
+
+                for (const auto &file : byAccess) {
+                    if (m_state->diskBytes <= target)
+                        break;
+                    if (file.second == m_cachePath)
+                        continue;
+                    m_state->diskBytes -= m_state->files.take(file.second).size;
+                    evicted.append(file.second);
+                }
+            }
+            bytes = m_state->diskBytes;
+        }
+
+        Q_FOREACH(const QString &path, evicted) {
+            QFile::remove(path);
+        }
+        if (!evicted.isEmpty()) {
+            m_stats->addEvictions(evicted.count());
+        }
+        m_stats->setBytes(bytes);
+    }
+
+    QSharedPointer<ImageCacheState> m_state;
+    ImageCacheStats *m_stats;
+    QImage m_image;
+    QString m_cachePath;
+    QByteArray m_format;
+};
+
+class ImageCacheJob: public QRunnable
+{
+public:
+    ImageCacheJob(const QSharedPointer<ImageCacheState> &state, ImageCacheStats *stats, QThreadPool *writePool,
+                  const ImageCacheKey &key, const QUrl &image, const QSize &imageSize, const QSize &requestedSize, bool scale)
+      : m_state(state)
+      , m_stats(stats)
+      , m_writePool(writePool)
+      , m_key(key)
+      , m_image(image)
+      , m_imageSize(imageSize)
+      , m_requestedSize(requestedSize)
+      , m_scale(scale)
+    {
+    }
+
+    void run() override
+    {
+        QImageReader imageReader(m_key.path);
+        QImage result;
+        QString errorString;
+
+        if (!m_scale) {
+            result = imageReader.read();
+            if (result.isNull()) {
+                errorString = imageReader.errorString();
+            }
+            m_stats->addMiss();
+        } else {
+            auto cachePath = ImageCache::imagePath(m_image);
+            QSize finalSize;
+
+            if (ImageCache::needsUpdate(m_image, cachePath, m_imageSize, m_requestedSize, finalSize)) {
+                if (finalSize.isEmpty()) {
+                    finalSize = ImageCache::calculateSize(m_imageSize, m_requestedSize);
+                }
+                QByteArray format;
+                result = ImageCache::loadScaledImage(imageReader, finalSize, &format);
+                if (!result.isNull()) {
+                    m_writePool->start(new ImageCacheWriteJob(m_state, m_stats, result, cachePath.filePath(), format));
+                }
+                m_stats->addMiss();
+            } else {
+                result = ImageCache::loadCachedImage(cachePath.filePath());
+                touch(cachePath);
+                m_stats->addHit();
+            }
+        }
+
+        QMutexLocker locker(&m_state->mutex);
+        if (!result.isNull()) {
+            m_state->images.insert(m_key, new QImage(result), result.byteCount());
+        }
+        Q_FOREACH(ImageCacheResponse *response, m_state->pending.take(m_key)) {
+            response->finish(result, errorString);
+        }
+    }
+
+private:
+    // Bumps the access time for the eviction, the modification time is compared to the source's
+    void touch(const QFileInfo &cachePath)
+    {
+        struct timespec times[2];
+        times[0].tv_nsec = UTIME_NOW;
+        times[1].tv_nsec = UTIME_OMIT;
+        utimensat(AT_FDCWD, QFile::encodeName(cachePath.filePath()).constData(), times, 0);
+
+        QMutexLocker locker(&m_state->mutex);
+        auto it = m_state->files.find(cachePath.filePath());
+        if (it != m_state->files.end()) {
+            it->lastAccess = QDateTime::currentDateTime();
+        }
+    }
+
+    QSharedPointer<ImageCacheState> m_state;
+    ImageCacheStats *m_stats;
+    QThreadPool *m_writePool;
+    ImageCacheKey m_key;
+    QUrl m_image;
+    QSize m_imageSize;
+    QSize m_requestedSize;
+    bool m_scale;
+};
+
+bool ImageCacheKey::operator==(const ImageCacheKey &other) const
+{
+    return path == other.path && lastModified == other.lastModified && size == other.size;
+}
+
+uint qHash(const ImageCacheKey &key, uint seed)
+{
+    return qHash(key.path, seed) ^ qHash(key.lastModified.toMSecsSinceEpoch(), seed)
+         ^ qHash(key.size.width() << 16 | key.size.height(), seed);
+}
 
 ImageCache::ImageCache()
-  : QQuickImageProvider(QQmlImageProviderBase::Image,
-                        QQmlImageProviderBase::ForceAsynchronousImageLoading)
+  : m_state(new ImageCacheState)
+  , m_stats(new ImageCacheStats)
+{
+    m_decodePool.setMaxThreadCount(DecodeThreads);
+    m_writePool.setMaxThreadCount(1);
+
+    // Find out what's on disk early, and trim it whenever the budget changes
+    m_writePool.start(new ImageCacheWriteJob(m_state, m_stats));
+    QObject::connect(m_stats, &ImageCacheStats::diskBudgetChanged, m_stats, [this]() {
+        m_writePool.start(new ImageCacheWriteJob(m_state, m_stats));
+    });
+}
+
+ImageCache::~ImageCache()
 {
+    // Decoding may still queue writes
+    m_decodePool.waitForDone();
+    m_writePool.waitForDone();
+    delete m_stats;
+}
+
+ImageCacheStats *ImageCache::stats() const
+{
+    return m_stats;
 }
 
 QString ImageCache::imageCacheRoot()
@@ -61,7 +438,7 @@ bool ImageCache::needsUpdate(const QUrl &image, const QFileInfo &cachePath, cons
     if (imageInfo.lastModified() > cachePath.lastModified())
         return true;
 
-    QSize cacheSize(QImageReader(cachePath.filePath()).size());
+    QSize cacheSize(cachedImageSize(cachePath.filePath()));
     finalSize = calculateSize(imageSize, requestedSize);
     if (finalSize.isValid() && cacheSize != finalSize)
         return true;
@@ -82,11 +459,11 @@ QSize ImageCache::calculateSize(const QSize &imageSize, const QSize &requestedSi
     return finalSize;
 }
 
-QImage ImageCache::loadAndCacheImage(QImageReader &reader, const QFileInfo &cachePath, const QSize &finalSize)
+QImage ImageCache::loadScaledImage(QImageReader &reader, const QSize &finalSize, QByteArray *format)
 {
     reader.setQuality(100);
     reader.setScaledSize(finalSize);
-    auto format = reader.format(); // can't get this after reading
+    *format = reader.format(); // can't get this after reading
 
     QImage loadedImage(reader.read());
     if (loadedImage.isNull()) {
@@ -94,42 +471,151 @@ QImage ImageCache::loadAndCacheImage(QImageReader &reader, const QFileInfo &cach
         return QImage();
     }
 
-    cachePath.dir().mkpath(QStringLiteral("."));
-    loadedImage.save(cachePath.filePath(), format, 100);
-
     return loadedImage;
 }
 
-QImage ImageCache::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+static bool readRawHeader(QFile &file, RawHeader *header)
 {
-    QUrl image(id);
-    QImageReader imageReader(image.toLocalFile());
-    QSize imageSize(imageReader.size());
-    QImage result;
+    if (file.read(reinterpret_cast<char*>(header), sizeof(RawHeader)) != sizeof(RawHeader))
+        return false;
+    if (memcmp(header->magic, rawMagic, sizeof(rawMagic)) != 0)
+        return false;
+    if (header->format != QImage::Format_ARGB32_Premultiplied)
+        return false;
+    // QImage takes ints, and nothing we write is anywhere near that
+    if (header->width == 0 || header->height == 0 || header->width > 32768 || header->height > 32768)
+        return false;
 
-    // Early exit here, with no sourceSize, scaled-up sourceSize, or bad source image
-    if ((requestedSize.width() <= 0 && requestedSize.height() <= 0) ||
-        imageSize.isEmpty() ||
-        requestedSize.height() >= imageSize.height() ||
-        requestedSize.width() >= imageSize.width()) {
-        // We're only interested in scaling down, not up.
-        result = imageReader.read();
-        *size = result.size();
-        return result;
+    // In 64 bits so that nothing overflows, QImage can't have more than INT_MAX bytes either
+    const qint64 pixelBytes = (qint64)header->bytesPerLine * header->height;
+    if ((qint64)header->bytesPerLine < (qint64)header->width * 4 || pixelBytes > INT_MAX)
+        return false;
+    // Truncated files would have us read past the end of the mapping
+    return file.size() >= (qint64)sizeof(RawHeader) + pixelBytes;
+}
+
+QSize ImageCache::cachedImageSize(const QString &path)
+{
+    QFile file(path);
+    RawHeader header;
+    if (file.open(QIODevice::ReadOnly) && readRawHeader(file, &header)) {
+        return QSize(header.width, header.height);
+    }
+    return QImageReader(path).size();
+}
+
+QImage ImageCache::loadCachedImage(const QString &path)
+{
+    QFile file(path);
+    RawHeader header;
+    if (!file.open(QIODevice::ReadOnly) || !readRawHeader(file, &header)) {
+        return QImage(path);
     }
 
-    auto cachePath = imagePath(image);
-    QSize finalSize;
+    // The mapping stays valid even if the file is replaced or evicted meanwhile
+    auto mapping = new RawMapping;
+    mapping->length = sizeof(RawHeader) + (size_t)header.bytesPerLine * header.height;
+    mapping->address = mmap(nullptr, mapping->length, PROT_READ, MAP_PRIVATE, file.handle(), 0);
+    if (mapping->address == MAP_FAILED) {
+        qWarning() << "ImageCache could not map image" << path;
+        delete mapping;
+        return QImage();
+    }
+
+    // Read only, anything writing to it gets its own copy
+    const uchar *pixels = static_cast<const uchar*>(mapping->address) + sizeof(RawHeader);
+    QImage image(pixels, header.width, header.height, header.bytesPerLine,
+                 QImage::Format_ARGB32_Premultiplied, unmapRawImage, mapping);
+    if (image.isNull()) {
+        // QImage doesn't own the mapping unless it was created
+        qWarning() << "ImageCache could not use mapped image" << path;
+        unmapRawImage(mapping);
+    }
+    return image;
+}
+
+qint64 ImageCache::rawImageSize(const QImage &image)
+{
+    return sizeof(RawHeader) + (qint64)image.width() * 4 * image.height();
+}
+
+bool ImageCache::writeRawImage(QIODevice *device, const QImage &image)
+{
+    const QImage pixels = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    RawHeader header;
+    memcpy(header.magic, rawMagic, sizeof(rawMagic));
+    header.width = pixels.width();
+    header.height = pixels.height();
+    header.bytesPerLine = pixels.width() * 4;
+    header.format = QImage::Format_ARGB32_Premultiplied;
+
+    if (device->write(reinterpret_cast<const char*>(&header), sizeof(RawHeader)) != sizeof(RawHeader))
+        return false;
+    for (int y = 0; y < pixels.height(); ++y) {
+        if (device->write(reinterpret_cast<const char*>(pixels.constScanLine(y)), header.bytesPerLine) != header.bytesPerLine)
+            return false;
+    }
+    return true;
+}
 
-    if (needsUpdate(image, cachePath, imageSize, requestedSize, finalSize)) {
-        if (finalSize.isEmpty()) {
-            finalSize = calculateSize(imageSize, requestedSize);
+QSize ImageCache::sourceSize(const QString &path, const QDateTime &lastModified)
+{
+    {
+        QMutexLocker locker(&m_state->mutex);
+        auto it = m_state->sources.constFind(path);
+        if (it != m_state->sources.constEnd() && it->lastModified == lastModified) {
+            return it->size;
         }
-        result = loadAndCacheImage(imageReader, cachePath, finalSize);
+    }
+
+    SourceInfo source;
+    source.lastModified = lastModified;
+    source.size = QImageReader(path).size();
+    if (lastModified.isValid()) {
+        QMutexLocker locker(&m_state->mutex);
+        m_state->sources.insert(path, source);
+    }
+    return source.size;
+}
+
+QQuickImageResponse *ImageCache::requestImageResponse(const QString &id, const QSize &requestedSize)
+{
+    QUrl image(id);
+    const QString path = image.toLocalFile();
+    const QDateTime lastModified = QFileInfo(path).lastModified();
+    const QSize imageSize = sourceSize(path, lastModified);
+
+    // Early exit here, with no sourceSize, scaled-up sourceSize, or bad source image
+    // We're only interested in scaling down, not up.
+    const bool scale = !((requestedSize.width() <= 0 && requestedSize.height() <= 0) ||
+                         imageSize.isEmpty() ||
+                         requestedSize.height() >= imageSize.height() ||
+                         requestedSize.width() >= imageSize.width());
+
+    ImageCacheKey key;
+    key.path = path;
+    key.lastModified = lastModified;
+    key.size = scale ? calculateSize(imageSize, requestedSize) : imageSize;
+
+    auto response = new ImageCacheResponse(m_state, key);
+
+    QMutexLocker locker(&m_state->mutex);
+    QImage *cachedImage = m_state->images.object(key);
+    if (cachedImage) {
+        m_stats->addHit();
+        response->finish(*cachedImage, QString());
+        return response;
+    }
+
+    auto it = m_state->pending.find(key);
+    if (it != m_state->pending.end()) {
+        // Already being decoded, just wait for it
+        it->append(response);
     } else {
-        result = QImage(cachePath.filePath());
+        m_state->pending.insert(key, QList<ImageCacheResponse*>() << response);
+        m_decodePool.start(new ImageCacheJob(m_state, m_stats, &m_writePool, key, image, imageSize, requestedSize, scale));
     }
 
-    *size = result.size();
-    return result;
+    return response;
 }
@@ -16,10 +16,16 @@
 
 #pragma once
 
+#include <QDateTime>
 #include <QFileInfo>
 #include <QImageReader>
 #include <QQuickImageProvider>
+#include <QSharedPointer>
 #include <QSize>
+#include <QThreadPool>
+
+class ImageCacheState;
+class ImageCacheStats;
 
 /**
  * This class accepts an id formulated like a URL. So you'd use something like:
@@ -31,23 +37,81 @@
  * Right now, we only support file:/// URLs. We do accept some flags though:
  *
  * ?name=NAME
- *   - This will use NAME as the cache lookup key instead of the provided URL.
+ *   - This will use NAME as the cache lookup key on disk instead of the
+ *     provided URL. Images already decoded in memory are still shared by all
+ *     the names of the same source and size, as their pixels are the same.
+ *
+ * The cached files are kept under ImageCacheStats::diskBudget bytes, the
+ * least recently used ones are removed first. You may still want to provide a
+ * name, so that different sources for the same image share a file.
+ *
+ * In front of the files in $XDG_CACHE_HOME/unity8/imagecache we keep the
+ * decoded images in memory, keyed on the source path, its modification time
+ * and the final size. Decoding happens in a small thread pool of our own and
+ * requests for an image that is already being decoded wait for that decode
+ * instead of starting another one. Writing the scaled images to disk happens
+ * later, in a single writer thread of its own.
  *
- * We don't do any cleaning of old cached files yet.  So you may want to always
- * provide a name to avoid leaving lots of files around.
+ * Cached files are either encoded images or, with ImageCacheStats::rawFormat,
+ * a small header followed by premultiplied ARGB32 pixels. Those are mapped
+ * into memory and used as they are, without decoding anything.
  */
 
-class ImageCache: public QQuickImageProvider
+struct ImageCacheKey
+{
+    bool operator==(const ImageCacheKey &other) const;
+
+    QString path;
+    QDateTime lastModified;
+    QSize size;
+};
+
+uint qHash(const ImageCacheKey &key, uint seed = 0);
+
+class ImageCache: public QQuickAsyncImageProvider
 {
 public:
     ImageCache();
+    ~ImageCache();
+
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize) override;
+
+    // Decoded images are kept in memory up to this many bytes
+    static const int MemoryBudget = 32 * 1024 * 1024;
 
-    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
+    // Number of threads decoding images
+    static const int DecodeThreads = 2;
+
+    // Raw files may take up to 1/RawBudgetShare of the disk budget each
+    static const int RawBudgetShare = 4;
+
+    ImageCacheStats *stats() const;
 
 private:
+    friend class ImageCacheJob;
+    friend class ImageCacheWriteJob;
+
     static QString imageCacheRoot();
     static QFileInfo imagePath(const QUrl &image);
     static bool needsUpdate(const QUrl &image, const QFileInfo &cachePath, const QSize &imageSize, const QSize &requestedSize, QSize &finalSize);
     static QSize calculateSize(const QSize &imageSize, const QSize &requestedSize);
-    static QImage loadAndCacheImage(QImageReader &reader, const QFileInfo &cachePath, const QSize &finalSize);
+    static QImage loadScaledImage(QImageReader &reader, const QSize &finalSize, QByteArray *format);
+
+    // Cached files, whether raw or encoded
+    static QSize cachedImageSize(const QString &path);
+    static QImage loadCachedImage(const QString &path);
+    static qint64 rawImageSize(const QImage &image);
+    static bool writeRawImage(QIODevice *device, const QImage &image);
+
+    QSize sourceSize(const QString &path, const QDateTime &lastModified);
+
+    // Shared with the responses, which may outlive us
+    QSharedPointer<ImageCacheState> m_state;
+
+    QThreadPool m_decodePool;
+
+    // Single thread, writes don't compete with each other or with the decoding
+    QThreadPool m_writePool;
+
+    ImageCacheStats *m_stats;
 };
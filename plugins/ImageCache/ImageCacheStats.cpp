@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ImageCacheStats.h"
+
+ImageCacheStats::ImageCacheStats(QObject *parent)
+  : QObject(parent)
+  , m_hits(0)
+  , m_misses(0)
+  , m_bytes(0)
+  , m_evictions(0)
+  , m_diskBudget(DefaultDiskBudget)
+  , m_fastFormat(false)
+  , m_rawFormat(false)
+  , m_changedPending(false)
+{
+}
+
+int ImageCacheStats::hits() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_hits;
+}
+
+int ImageCacheStats::misses() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_misses;
+}
+
+qint64 ImageCacheStats::bytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bytes;
+}
+
+int ImageCacheStats::evictions() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_evictions;
+}
+
+qint64 ImageCacheStats::diskBudget() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_diskBudget;
+}
+
+void ImageCacheStats::setDiskBudget(qint64 diskBudget)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_diskBudget == diskBudget)
+            return;
+        m_diskBudget = diskBudget;
+    }
+    Q_EMIT diskBudgetChanged();
+}
+
+bool ImageCacheStats::fastFormat() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_fastFormat;
+}
+
+void ImageCacheStats::setFastFormat(bool fastFormat)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_fastFormat == fastFormat)
+            return;
+        m_fastFormat = fastFormat;
+    }
+    Q_EMIT fastFormatChanged();
+}
+
+bool ImageCacheStats::rawFormat() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_rawFormat;
+}
+
+void ImageCacheStats::setRawFormat(bool rawFormat)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_rawFormat == rawFormat)
+            return;
+        m_rawFormat = rawFormat;
+    }
+    Q_EMIT rawFormatChanged();
+}
+
+void ImageCacheStats::addHit()
+{
+    QMutexLocker locker(&m_mutex);
+    m_hits++;
+    scheduleChanged();
+}
+
+void ImageCacheStats::addMiss()
+{
+    QMutexLocker locker(&m_mutex);
+    m_misses++;
+    scheduleChanged();
+}
+
+void ImageCacheStats::addEvictions(int evictions)
+{
+    QMutexLocker locker(&m_mutex);
+    m_evictions += evictions;
+    scheduleChanged();
+}
+
+void ImageCacheStats::setBytes(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_bytes = bytes;
+    scheduleChanged();
+}
+
+// Must be called with the mutex locked
+void ImageCacheStats::scheduleChanged()
+{
+    if (!m_changedPending) {
+        m_changedPending = true;
+        QMetaObject::invokeMethod(this, "emitChanged", Qt::QueuedConnection);
+    }
+}
+
+void ImageCacheStats::emitChanged()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_changedPending = false;
+    }
+    Q_EMIT changed();
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QMutex>
+#include <QObject>
+
+/**
+ * Statistics and settings of the image cache, available in QML as the
+ * ImageCacheStats singleton.
+ *
+ * The counters are updated from the decoding and writing threads, changed()
+ * is emitted at most once per event loop iteration in the thread of this object.
+ *
+ * hits counts images that came from memory or from the files on disk,
+ * misses the ones that had to be decoded from their source.
+ * bytes is the size of the files on disk, which we keep under diskBudget by
+ * removing the ones that were used least recently.
+ * fastFormat writes uncompressed PNGs instead of the format of the source,
+ * trading disk space for less time spent encoding.
+ * rawFormat writes the pixels as they are kept in memory, so that reading them
+ * back is just mapping the file. Images that would take too much of the budget
+ * that way are still written encoded.
+ */
+class ImageCacheStats : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int hits READ hits NOTIFY changed)
+    Q_PROPERTY(int misses READ misses NOTIFY changed)
+    Q_PROPERTY(qint64 bytes READ bytes NOTIFY changed)
+    Q_PROPERTY(int evictions READ evictions NOTIFY changed)
+    Q_PROPERTY(qint64 diskBudget READ diskBudget WRITE setDiskBudget NOTIFY diskBudgetChanged)
+    Q_PROPERTY(bool fastFormat READ fastFormat WRITE setFastFormat NOTIFY fastFormatChanged)
+    Q_PROPERTY(bool rawFormat READ rawFormat WRITE setRawFormat NOTIFY rawFormatChanged)
+
+public:
+    explicit ImageCacheStats(QObject *parent = nullptr);
+
+    int hits() const;
+    int misses() const;
+    qint64 bytes() const;
+    int evictions() const;
+
+    qint64 diskBudget() const;
+    void setDiskBudget(qint64 diskBudget);
+
+    bool fastFormat() const;
+    void setFastFormat(bool fastFormat);
+
+    bool rawFormat() const;
+    void setRawFormat(bool rawFormat);
+
+    // Thread safe
+    void addHit();
+    void addMiss();
+    void addEvictions(int evictions);
+    void setBytes(qint64 bytes);
+
+    static const qint64 DefaultDiskBudget = 50 * 1024 * 1024;
+
+Q_SIGNALS:
+    void changed();
+    void diskBudgetChanged();
+    void fastFormatChanged();
+    void rawFormatChanged();
+
+private Q_SLOTS:
+    void emitChanged();
+
+private:
+    void scheduleChanged();
+
+    mutable QMutex m_mutex;
+    int m_hits;
+    int m_misses;
+    qint64 m_bytes;
+    int m_evictions;
+    qint64 m_diskBudget;
+    bool m_fastFormat;
+    bool m_rawFormat;
+    bool m_changedPending;
+};
@@ -17,16 +17,27 @@
 #include <QQmlEngine>
 
 #include "ImageCache.h"
+#include "ImageCacheStats.h"
 #include "plugin.h"
 
 #include <QtQml>
 
+static QObject* stats_provider(QQmlEngine* engine, QJSEngine* /* scriptEngine */)
+{
+    // The provider owns the stats, they live as long as the engine
+    auto imageCache = static_cast<ImageCache*>(engine->imageProvider(QStringLiteral("unity8imagecache")));
+    auto stats = imageCache->stats();
+    QQmlEngine::setObjectOwnership(stats, QQmlEngine::CppOwnership);
+    return stats;
+}
+
 void ImageCachePlugin::registerTypes(const char *uri)
 {
     Q_ASSERT(uri == QLatin1String("ImageCache"));
 
     qmlRegisterTypeNotAvailable(uri, 0, 1, "__ImageCacheIgnoreMe",
                                 QStringLiteral("Ignore this: QML plugins must contain at least one type"));
+    qmlRegisterSingletonType<ImageCacheStats>(uri, 0, 1, "ImageCacheStats", stats_provider);
 }
 
 void ImageCachePlugin::initializeEngine(QQmlEngine* engine, const char* uri)
@@ -56,14 +56,14 @@ UsersModelPrivate::UsersModelPrivate(UsersModel* parent)
         connect(m_service, &AccountsServiceDBusAdaptor::maybeChanged,
                 this, [this](const QString &user) {
             if (user == entries[0].username) {
-                updateName(true);
+                updateName();
             }
         });
-        updateName(false);
+        m_service->whenUserFound(currentUser, this, [this]() { updateName(); });
     }
 }
 
-void UsersModelPrivate::updateName(bool async)
+void UsersModelPrivate::updateName()
 {
     auto pendingReply = m_service->getUserPropertyAsync(entries[0].username,
                                                         QStringLiteral("org.freedesktop.Accounts.User"),
@@ -86,9 +86,6 @@ void UsersModelPrivate::updateName(bool async)
             Q_EMIT dataChanged(0);
         }
     });
-    if (!async) {
-        watcher->waitForFinished();
-    }
 }
 
 }
@@ -62,7 +62,7 @@ protected:
 private:
     Q_DECLARE_PUBLIC(UsersModel)
 
-    void updateName(bool async);
+    void updateName();
 
     AccountsServiceDBusAdaptor *m_service;
 };
@@ -23,6 +23,120 @@
 
 UG_USE_NAMESPACE
 
+AxisVelocitySampler::AxisVelocitySampler()
+{
+    reset();
+}
+
+void AxisVelocitySampler::addMovement(qreal movement, qint64 time)
+{
+    int index;
+    if (m_count < MAX_SAMPLES) {
+        index = bufferIndex(m_count);
+        ++m_count;
+    } else {
+        /* the oldest value is going to be overwritten.
+           so now the oldest will be the next one. */
+        index = m_first;
+        m_first = (m_first + 1) % MAX_SAMPLES;
+    }
+
+    m_movements[index] = movement;
+    m_times[index] = time;
+}
+
+void AxisVelocitySampler::reset()
+{
+    m_first = 0;
+    m_count = 0;
+}
+
+qreal AxisVelocitySampler::velocity(Estimator estimator) const
+{
+    if (m_count < MIN_SAMPLES_NEEDED) {
+        return 0.0;
+    }
+
+    switch (estimator) {
+    case WeightedLeastSquares:
+        return leastSquaresVelocity();
+    case Average:
+    default:
+        return averageVelocity();
+    }
+}
+
+int AxisVelocitySampler::firstRecentSample() const
+{
+    const qint64 currTime = m_times[bufferIndex(m_count - 1)];
+
+    // Times never decrease, so the recent samples are all at the end
+    int position = m_count - 1;
+    while (position > 1 && currTime - m_times[bufferIndex(position - 1)] <= AGE_OLDEST_SAMPLE) {
+        --position;
+    }
+    return position;
+}
+
+qreal AxisVelocitySampler::averageVelocity() const
+{
+    const int first = firstRecentSample();
+
+    // Go through the buffer in at most two contiguous runs, it's faster than wrapping every index
+    qreal totalDistance = 0;
+    const int begin = bufferIndex(first);
+    const int end = begin + (m_count - first);
+    for (int i = begin; i < qMin(end, (int)MAX_SAMPLES); ++i) {
+        totalDistance += m_movements[i];
+    }
+    for (int i = 0; i < end - MAX_SAMPLES; ++i) {
+        totalDistance += m_movements[i];
+    }
+
+    // The time deltas between consecutive samples add up to this
+    const qreal totalTime = m_times[bufferIndex(m_count - 1)] - m_times[bufferIndex(first - 1)];
+
+    return totalDistance / totalTime;
+}
+
+qreal AxisVelocitySampler::leastSquaresVelocity() const
+{
+    const int first = firstRecentSample() - 1; // where the recent movement started from
+    const int count = m_count - first;
+    const qint64 currTime = m_times[bufferIndex(m_count - 1)];
+
+    // Lay the positions out relative to the oldest one and the times relative to the newest one
+    double times[MAX_SAMPLES];
+    double positions[MAX_SAMPLES];
+    double position = 0;
+    for (int i = 0; i < count; ++i) {
+        const int index = bufferIndex(first + i);
+        if (i > 0) {
+            position += m_movements[index];
+        }
+        positions[i] = position;
+        times[i] = m_times[index] - currTime;
+    }
+
+    // Newer samples weigh more, down to half for the oldest ones
+    double sumW = 0, sumWT = 0, sumWX = 0, sumWTT = 0, sumWTX = 0;
+    for (int i = 0; i < count; ++i) {
+        const double w = 1.0 + qMax(times[i], (double)-AGE_OLDEST_SAMPLE) / (2.0 * AGE_OLDEST_SAMPLE);
+        sumW += w;
+        sumWT += w * times[i];
+        sumWX += w * positions[i];
+        sumWTT += w * times[i] * times[i];
+        sumWTX += w * times[i] * positions[i];
+    }
+
+    const double denominator = sumW * sumWTT - sumWT * sumWT;
+    if (denominator <= 0) {
+        // All samples at the same time, there's no line to fit
+        return averageVelocity();
+    }
+    return (sumW * sumWTX - sumWT * sumWX) / denominator;
+}
+
 AxisVelocityCalculator::AxisVelocityCalculator(QObject *parent)
     : AxisVelocityCalculator(SharedTimeSource(new RealTimeSource), parent)
 {
@@ -31,10 +145,10 @@ AxisVelocityCalculator::AxisVelocityCalculator(QObject *parent)
 AxisVelocityCalculator::AxisVelocityCalculator(const SharedTimeSource &timeSource,
                                                QObject *parent)
     : QObject(parent)
+    , m_estimator(Average)
     , m_timeSource(timeSource)
     , m_trackedPosition(0.0)
 {
-    reset();
 }
 
 AxisVelocityCalculator::~AxisVelocityCalculator()
@@ -56,6 +170,19 @@ void AxisVelocityCalculator::setTrackedPosition(qreal newPosition)
     }
 }
 
+AxisVelocityCalculator::Estimator AxisVelocityCalculator::estimator() const
+{
+    return m_estimator;
+}
+
+void AxisVelocityCalculator::setEstimator(Estimator estimator)
+{
+    if (estimator != m_estimator) {
+        m_estimator = estimator;
+        Q_EMIT estimatorChanged();
+    }
+}
+
 void AxisVelocityCalculator::updateIdleTime()
 {
     processMovement(0);
@@ -63,17 +190,7 @@ void AxisVelocityCalculator::updateIdleTime()
 
 void AxisVelocityCalculator::processMovement(qreal movement)
 {
-    if (m_samplesRead == -1) {
-        m_samplesRead = m_samplesWrite;
-    } else if (m_samplesRead == m_samplesWrite) {
-        /* the oldest value is going to be overwritten.
-           so now the oldest will be the next one. */
-        m_samplesRead = (m_samplesRead + 1) % MAX_SAMPLES;
-    }
-
-    m_samples[m_samplesWrite].mov = movement;
-    m_samples[m_samplesWrite].time = m_timeSource->msecsSinceReference();
-    m_samplesWrite = (m_samplesWrite + 1) % MAX_SAMPLES;
+    m_sampler.addMovement(movement, m_timeSource->msecsSinceReference());
 }
 
 qreal AxisVelocityCalculator::calculate()
@@ -83,57 +200,17 @@ qreal AxisVelocityCalculator::calculate()
     }
     updateIdleTime(); // consider the time elapsed since the last update and now
 
-    int lastIndex;
-    if (m_samplesWrite == 0) {
-        lastIndex = MAX_SAMPLES - 1;
-    } else {
-        lastIndex = m_samplesWrite - 1;
-    }
-
-    qint64 currTime = m_samples[lastIndex].time;
-
-    qreal totalTime = 0;
-    qreal totalDistance = 0;
-
-    int sampleIndex = (m_samplesRead + 1) % MAX_SAMPLES;
-    qint64 previousTime = m_samples[m_samplesRead].time;
-    while (sampleIndex != m_samplesWrite) {
-        // Skip this sample if it's too old
-        if (currTime - m_samples[sampleIndex].time <= AGE_OLDEST_SAMPLE) {
-            int deltaTime = m_samples[sampleIndex].time - previousTime;
-            totalDistance += m_samples[sampleIndex].mov;
-            totalTime += deltaTime;
-        }
-
-        previousTime = m_samples[sampleIndex].time;
-        sampleIndex = (sampleIndex + 1) % MAX_SAMPLES;
-    }
-
-    return totalDistance / totalTime;
+    return m_sampler.velocity(static_cast<AxisVelocitySampler::Estimator>(m_estimator));
 }
 
 void AxisVelocityCalculator::reset()
 {
-    m_samplesRead = -1;
-    m_samplesWrite = 0;
+    m_sampler.reset();
 }
 
 int AxisVelocityCalculator::numSamples() const
 {
-    if (m_samplesRead == -1) {
-        return 0;
-    } else {
-        if (m_samplesWrite == 0) {
-            /* consider only what's to the right of m_samplesRead (including himself) */
-            return MAX_SAMPLES - m_samplesRead;
-        } else if (m_samplesWrite == m_samplesRead) {
-            return MAX_SAMPLES; /* buffer is full */
-        } else if (m_samplesWrite < m_samplesRead) {
-            return (MAX_SAMPLES - m_samplesRead) + m_samplesWrite;
-        } else {
-            return m_samplesWrite - m_samplesRead;
-        }
-    }
+    return m_sampler.numSamples();
 }
 
 void AxisVelocityCalculator::setTimeSource(const SharedTimeSource &timeSource)
@@ -26,6 +26,81 @@
 #include <QtCore/QObject>
 #include <UbuntuGestures/private/timesource_p.h>
 
+/*
+  The movement samples of an axis and the velocity estimators working on them
+
+  It's what AxisVelocityCalculator is built on. C++ code that sees the touch
+  events itself, like TouchGestureArea, can feed one directly with the event
+  timestamps instead of going through an AxisVelocityCalculator and its QML
+  property.
+
+  Samples are kept in a circular buffer, as a structure of arrays so that the
+  estimators can go through them in tight loops.
+ */
+class UBUNTUGESTURESQML_EXPORT AxisVelocitySampler
+{
+public:
+    enum Estimator {
+        /* Total distance over total time of the recent samples */
+        Average,
+        /* Slope of a least-squares line fitted to the recent positions, with
+           newer ones weighing more */
+        WeightedLeastSquares
+    };
+
+    AxisVelocitySampler();
+
+    /*
+      Records that the position moved by movement at the given time, in milliseconds.
+      Times must not decrease between calls.
+    */
+    void addMovement(qreal movement, qint64 time);
+
+    /*
+      Calculates the velocity, in axis units/millisecond, from the samples taken
+      within AGE_OLDEST_SAMPLE of the newest one. Returns 0 if there are less than
+      MIN_SAMPLES_NEEDED samples.
+    */
+    qreal velocity(Estimator estimator = Average) const;
+
+    void reset();
+
+    int numSamples() const { return m_count; }
+
+    /*
+        The minimum amount of samples needed for a velocity calculation.
+     */
+    static const int MIN_SAMPLES_NEEDED = 2;
+
+    /*
+      Maximum number of movement samples stored
+    */
+    static const int MAX_SAMPLES = 50;
+
+    /*
+      Age of the oldest sample considered in the velocity calculations, in
+      milliseconds, compared to the most recent one.
+    */
+    static const int AGE_OLDEST_SAMPLE = 100;
+
+private:
+    /*
+      Chronological position of the oldest sample within AGE_OLDEST_SAMPLE of
+      the newest one, leaving out the very oldest sample as we don't know when
+      its movement started.
+    */
+    int firstRecentSample() const;
+    int bufferIndex(int position) const { return (m_first + position) % MAX_SAMPLES; }
+
+    qreal averageVelocity() const;
+    qreal leastSquaresVelocity() const;
+
+    qreal m_movements[MAX_SAMPLES]; /* movement distance since last sample */
+    qint64 m_times[MAX_SAMPLES]; /* time, in milliseconds */
+    int m_first; /* index of the oldest sample */
+    int m_count;
+};
+
 /*
   Estimates the current velocity of a finger based on recent movement along an axis
 
@@ -58,7 +133,17 @@ class UBUNTUGESTURESQML_EXPORT AxisVelocityCalculator : public QObject
      */
     Q_PROPERTY(qreal trackedPosition READ trackedPosition WRITE setTrackedPosition
                NOTIFY trackedPositionChanged)
+
+    /*
+        How calculate() estimates the velocity. Average by default.
+     */
+    Q_PROPERTY(Estimator estimator READ estimator WRITE setEstimator NOTIFY estimatorChanged)
 public:
+    enum Estimator {
+        Average = AxisVelocitySampler::Average,
+        WeightedLeastSquares = AxisVelocitySampler::WeightedLeastSquares
+    };
+    Q_ENUM(Estimator)
 
     /*
       Regular, simple, constructor
@@ -75,6 +160,9 @@ public:
     qreal trackedPosition() const;
     void setTrackedPosition(qreal value);
 
+    Estimator estimator() const;
+    void setEstimator(Estimator estimator);
+
     /*
       Calculates the finger velocity, in axis units/millisecond
     */
@@ -92,24 +180,13 @@ public:
      */
     void setTimeSource(const UG_PREPEND_NAMESPACE(SharedTimeSource) &timeSource);
 
-    /*
-        The minimum amount of samples needed for a velocity calculation.
-     */
-    static const int MIN_SAMPLES_NEEDED = 2;
-
-    /*
-      Maximum number of movement samples stored
-    */
-    static const int MAX_SAMPLES = 50;
-
-    /*
-      Age of the oldest sample considered in the velocity calculations, in
-      milliseconds, compared to the most recent one.
-    */
-    static const int AGE_OLDEST_SAMPLE = 100;
+    static const int MIN_SAMPLES_NEEDED = AxisVelocitySampler::MIN_SAMPLES_NEEDED;
+    static const int MAX_SAMPLES = AxisVelocitySampler::MAX_SAMPLES;
+    static const int AGE_OLDEST_SAMPLE = AxisVelocitySampler::AGE_OLDEST_SAMPLE;
 
 Q_SIGNALS:
     void trackedPositionChanged(qreal value);
+    void estimatorChanged();
 
 private:
 
@@ -126,17 +203,8 @@ private:
     */
     void processMovement(qreal movement);
 
-    class Sample
-    {
-        public:
-            qreal mov; /* movement distance since last sample */
-            qint64 time; /* time, in milliseconds */
-    };
-
-    /* a circular buffer of samples */
-    Sample m_samples[MAX_SAMPLES];
-    int m_samplesRead; /* index of the oldest sample available. -1 if buffer is empty */
-    int m_samplesWrite; /* index where the next sample will be written */
+    AxisVelocitySampler m_sampler;
+    Estimator m_estimator;
 
     UG_PREPEND_NAMESPACE(SharedTimeSource) m_timeSource;
 
@@ -17,7 +17,6 @@
 #include "TouchDispatcher.h"
 
 #include <QGuiApplication>
-#include <QScopedPointer>
 #include <QStyleHints>
 #include <private/qquickitem_p.h>
 
@@ -50,7 +49,7 @@ void TouchDispatcher::setTargetItem(QQuickItem *target)
 
 void TouchDispatcher::dispatch(QTouchDevice *device,
                                Qt::KeyboardModifiers modifiers,
-                               const QList<QTouchEvent::TouchPoint> &touchPoints,
+                               QList<QTouchEvent::TouchPoint> &touchPoints,
                                QWindow *window,
                                ulong timestamp)
 {
@@ -59,7 +58,7 @@ void TouchDispatcher::dispatch(QTouchDevice *device,
         return;
     }
 
-    QEvent::Type eventType = resolveEventType(touchPoints);
+    QEvent::Type eventType = resolveEventType(touchPointStates(touchPoints));
 
     if (eventType == QEvent::TouchBegin) {
         dispatchTouchBegin(device, modifiers, touchPoints, window, timestamp);
@@ -67,7 +66,7 @@ void TouchDispatcher::dispatch(QTouchDevice *device,
     } else if (eventType == QEvent::TouchUpdate || eventType == QEvent::TouchEnd) {
 
         if (m_status == DeliveringTouchEvents) {
-            dispatchAsTouch(eventType, device, modifiers, touchPoints, window, timestamp);
+            dispatchAsTouch(device, modifiers, touchPoints, window, timestamp);
         } else if (m_status == DeliveringMouseEvents) {
             dispatchAsMouse(device, modifiers, touchPoints, timestamp);
         } else {
@@ -93,7 +92,7 @@ void TouchDispatcher::dispatch(QTouchDevice *device,
 void TouchDispatcher::dispatchTouchBegin(
             QTouchDevice *device,
             Qt::KeyboardModifiers modifiers,
-            const QList<QTouchEvent::TouchPoint> &touchPoints,
+            QList<QTouchEvent::TouchPoint> &touchPoints,
             QWindow *window,
             ulong timestamp)
 {
@@ -106,44 +105,24 @@ void TouchDispatcher::dispatchTouchBegin(
     }
 
     // Map touch points to targetItem coordinates
-    QList<QTouchEvent::TouchPoint> targetTouchPoints = touchPoints;
-    transformTouchPoints(targetTouchPoints, QQuickItemPrivate::get(targetItem)->windowToItemTransform());
+    transformTouchPoints(touchPoints, QQuickItemPrivate::get(targetItem)->windowToItemTransform());
 
-    QScopedPointer<QTouchEvent> touchEvent(
-            createQTouchEvent(QEvent::TouchBegin, device, modifiers, targetTouchPoints, window, timestamp));
-
-
-    ugDebug("dispatching " << qPrintable(touchEventToString(touchEvent.data()))
-            << " to " << targetItem);
-    QCoreApplication::sendEvent(targetItem, touchEvent.data());
-
-
-    if (touchEvent->isAccepted()) {
+    if (sendTouchEvent(device, modifiers, touchPoints, window, timestamp)) {
         ugDebug("Item accepted the touch event.");
         setStatus(DeliveringTouchEvents);
     } else if (targetItem->acceptedMouseButtons() & Qt::LeftButton) {
         ugDebug("Item rejected the touch event. Trying a QMouseEvent");
         // NB: Arbitrarily chose the first touch point to emulate the mouse pointer
-        QScopedPointer<QMouseEvent> mouseEvent(
-                touchToMouseEvent(QEvent::MouseButtonPress, targetTouchPoints.at(0), timestamp,
-                                  modifiers, false /* transformNeeded */));
-        Q_ASSERT(targetTouchPoints.at(0).state() == Qt::TouchPointPressed);
-
-        ugDebug("dispatching " << qPrintable(mouseEventToString(mouseEvent.data()))
-                << " to " << m_targetItem.data());
-        QCoreApplication::sendEvent(targetItem, mouseEvent.data());
-        if (mouseEvent->isAccepted()) {
+        Q_ASSERT(touchPoints.at(0).state() == Qt::TouchPointPressed);
+        if (sendMouseEvent(QEvent::MouseButtonPress, touchPoints.at(0), timestamp,
+                           modifiers, false /* transformNeeded */)) {
             ugDebug("Item accepted the QMouseEvent.");
             setStatus(DeliveringMouseEvents);
-            m_touchMouseId = targetTouchPoints.at(0).id();
+            m_touchMouseId = touchPoints.at(0).id();
 
             if (checkIfDoubleClicked(timestamp)) {
-                QScopedPointer<QMouseEvent> doubleClickEvent(
-                        touchToMouseEvent(QEvent::MouseButtonDblClick, targetTouchPoints.at(0), timestamp,
-                                          modifiers, false /* transformNeeded */));
-                ugDebug("dispatching " << qPrintable(mouseEventToString(doubleClickEvent.data()))
-                        << " to " << m_targetItem.data());
-                QCoreApplication::sendEvent(targetItem, doubleClickEvent.data());
+                sendMouseEvent(QEvent::MouseButtonDblClick, touchPoints.at(0), timestamp,
+                               modifiers, false /* transformNeeded */);
             }
 
         } else {
@@ -156,26 +135,19 @@ void TouchDispatcher::dispatchTouchBegin(
     }
 }
 
-void TouchDispatcher::dispatchAsTouch(QEvent::Type eventType,
+void TouchDispatcher::dispatchAsTouch(
         QTouchDevice *device,
         Qt::KeyboardModifiers modifiers,
-        const QList<QTouchEvent::TouchPoint> &touchPoints,
+        QList<QTouchEvent::TouchPoint> &touchPoints,
         QWindow *window,
         ulong timestamp)
 {
     QQuickItem *targetItem = m_targetItem.data();
 
     // Map touch points to targetItem coordinates
-    QList<QTouchEvent::TouchPoint> targetTouchPoints = touchPoints;
-    transformTouchPoints(targetTouchPoints, QQuickItemPrivate::get(targetItem)->windowToItemTransform());
-
-    QScopedPointer<QTouchEvent> eventForTargetItem(
-            createQTouchEvent(eventType, device, modifiers, targetTouchPoints, window, timestamp));
-
+    transformTouchPoints(touchPoints, QQuickItemPrivate::get(targetItem)->windowToItemTransform());
 
-    ugDebug("dispatching " << qPrintable(touchEventToString(eventForTargetItem.data()))
-            << " to " << targetItem);
-    QCoreApplication::sendEvent(targetItem, eventForTargetItem.data());
+    sendTouchEvent(device, modifiers, touchPoints, window, timestamp);
 }
 
 void TouchDispatcher::dispatchAsMouse(
@@ -228,48 +200,31 @@ void TouchDispatcher::dispatchAsMouse(
             eventType = QEvent::MouseMove;
         }
 
-        QScopedPointer<QMouseEvent> mouseEvent(touchToMouseEvent(eventType, *touchMouse, timestamp, modifiers,
-                    true /* transformNeeded */));
-
-        ugDebug("dispatching " << qPrintable(mouseEventToString(mouseEvent.data()))
-                << " to " << m_targetItem.data());
-        QCoreApplication::sendEvent(m_targetItem.data(), mouseEvent.data());
+        sendMouseEvent(eventType, *touchMouse, timestamp, modifiers, true /* transformNeeded */);
     }
 }
 
-QTouchEvent *TouchDispatcher::createQTouchEvent(QEvent::Type eventType,
+bool TouchDispatcher::sendTouchEvent(
         QTouchDevice *device,
         Qt::KeyboardModifiers modifiers,
         const QList<QTouchEvent::TouchPoint> &touchPoints,
         QWindow *window,
         ulong timestamp)
 {
-    Qt::TouchPointStates eventStates = 0;
-    for (int i = 0; i < touchPoints.count(); i++)
-        eventStates |= touchPoints[i].state();
     // if all points have the same state, set the event type accordingly
-    switch (eventStates) {
-        case Qt::TouchPointPressed:
-            eventType = QEvent::TouchBegin;
-            break;
-        case Qt::TouchPointReleased:
-            eventType = QEvent::TouchEnd;
-            break;
-        default:
-            eventType = QEvent::TouchUpdate;
-            break;
-    }
-
-    QTouchEvent *touchEvent = new QTouchEvent(eventType);
-    touchEvent->setWindow(window);
-    touchEvent->setTarget(m_targetItem.data());
-    touchEvent->setDevice(device);
-    touchEvent->setModifiers(modifiers);
-    touchEvent->setTouchPoints(touchPoints);
-    touchEvent->setTouchPointStates(eventStates);
-    touchEvent->setTimestamp(timestamp);
-    touchEvent->accept();
-    return touchEvent;
+    Qt::TouchPointStates eventStates = touchPointStates(touchPoints);
+
+    // Delivery is synchronous, so there's no need for it to outlive this call
+    QTouchEvent touchEvent(resolveEventType(eventStates), device, modifiers, eventStates, touchPoints);
+    touchEvent.setWindow(window);
+    touchEvent.setTarget(m_targetItem.data());
+    touchEvent.setTimestamp(timestamp);
+    touchEvent.accept();
+
+    ugDebug("dispatching " << qPrintable(touchEventToString(&touchEvent))
+            << " to " << m_targetItem.data());
+    QCoreApplication::sendEvent(m_targetItem.data(), &touchEvent);
+    return touchEvent.isAccepted();
 }
 
 // NB: From QQuickWindow
@@ -286,7 +241,7 @@ void TouchDispatcher::transformTouchPoints(QList<QTouchEvent::TouchPoint> &touch
 }
 
 // Copied with minor modifications from qtdeclarative/src/quick/items/qquickwindow.cpp
-QMouseEvent *TouchDispatcher::touchToMouseEvent(
+bool TouchDispatcher::sendMouseEvent(
         QEvent::Type type, const QTouchEvent::TouchPoint &p,
         ulong timestamp, Qt::KeyboardModifiers modifiers,
         bool transformNeeded)
@@ -294,12 +249,12 @@ QMouseEvent *TouchDispatcher::touchToMouseEvent(
     QQuickItem *item = m_targetItem.data();
 
     // The touch point local position and velocity are not yet transformed.
-    QMouseEvent *me = new QMouseEvent(type, transformNeeded ? item->mapFromScene(p.scenePos()) : p.pos(),
-                                      p.scenePos(), p.screenPos(), Qt::LeftButton,
-                                      (type == QEvent::MouseButtonRelease ? Qt::NoButton : Qt::LeftButton),
-                                      modifiers);
-    me->setAccepted(true);
-    me->setTimestamp(timestamp);
+    QMouseEvent me(type, transformNeeded ? item->mapFromScene(p.scenePos()) : p.pos(),
+                   p.scenePos(), p.screenPos(), Qt::LeftButton,
+                   (type == QEvent::MouseButtonRelease ? Qt::NoButton : Qt::LeftButton),
+                   modifiers);
+    me.setAccepted(true);
+    me.setTimestamp(timestamp);
     QVector2D transformedVelocity = p.velocity();
     if (transformNeeded) {
         QQuickItemPrivate *itemPrivate = QQuickItemPrivate::get(item);
@@ -310,7 +265,10 @@ QMouseEvent *TouchDispatcher::touchToMouseEvent(
     // Add these later if needed:
     //QGuiApplicationPrivate::setMouseEventCapsAndVelocity(me, event->device()->capabilities(), transformedVelocity);
     //QGuiApplicationPrivate::setMouseEventSource(me, Qt::MouseEventSynthesizedByQt);
-    return me;
+
+    ugDebug("dispatching " << qPrintable(mouseEventToString(&me)) << " to " << item);
+    QCoreApplication::sendEvent(item, &me);
+    return me.isAccepted();
 }
 
 /*
@@ -374,13 +332,17 @@ void TouchDispatcher::reset()
     m_touchMousePressTimestamp =0;
 }
 
-QEvent::Type TouchDispatcher::resolveEventType(const QList<QTouchEvent::TouchPoint> &touchPoints)
+Qt::TouchPointStates TouchDispatcher::touchPointStates(const QList<QTouchEvent::TouchPoint> &touchPoints)
 {
-    QEvent::Type eventType;
-
     Qt::TouchPointStates eventStates = 0;
     for (int i = 0; i < touchPoints.count(); i++)
         eventStates |= touchPoints[i].state();
+    return eventStates;
+}
+
+QEvent::Type TouchDispatcher::resolveEventType(Qt::TouchPointStates eventStates)
+{
+    QEvent::Type eventType;
 
     switch (eventStates) {
         case Qt::TouchPointPressed:
@@ -28,6 +28,9 @@
 
    Also takes care of synthesizing mouse events in case the target
    doesn't work with touch events.
+
+   The touch points given to dispatch() are mapped to the target's coordinates
+   in place, so callers shouldn't expect them to be left untouched.
  */
 class UBUNTUGESTURESQML_EXPORT TouchDispatcher {
 public:
@@ -38,7 +41,7 @@ public:
 
     void dispatch(QTouchDevice *device,
             Qt::KeyboardModifiers modifiers,
-            const QList<QTouchEvent::TouchPoint> &touchPoints,
+            QList<QTouchEvent::TouchPoint> &touchPoints,
             QWindow *window,
             ulong timestamp);
 
@@ -54,13 +57,13 @@ private:
     void dispatchTouchBegin(
             QTouchDevice *device,
             Qt::KeyboardModifiers modifiers,
-            const QList<QTouchEvent::TouchPoint> &touchPoints,
+            QList<QTouchEvent::TouchPoint> &touchPoints,
             QWindow *window,
             ulong timestamp);
-    void dispatchAsTouch(QEvent::Type eventType,
+    void dispatchAsTouch(
             QTouchDevice *device,
             Qt::KeyboardModifiers modifiers,
-            const QList<QTouchEvent::TouchPoint> &touchPoints,
+            QList<QTouchEvent::TouchPoint> &touchPoints,
             QWindow *window,
             ulong timestamp);
     void dispatchAsMouse(
@@ -70,20 +73,21 @@ private:
             ulong timestamp);
 
     static void transformTouchPoints(QList<QTouchEvent::TouchPoint> &touchPoints, const QTransform &transform);
-    QTouchEvent *createQTouchEvent(QEvent::Type eventType,
-            QTouchDevice *device,
+    // Both return whether the target accepted the event
+    bool sendTouchEvent(QTouchDevice *device,
             Qt::KeyboardModifiers modifiers,
             const QList<QTouchEvent::TouchPoint> &touchPoints,
             QWindow *window,
             ulong timestamp);
-    QMouseEvent *touchToMouseEvent(QEvent::Type type, const QTouchEvent::TouchPoint &p,
+    bool sendMouseEvent(QEvent::Type type, const QTouchEvent::TouchPoint &p,
             ulong timestamp, Qt::KeyboardModifiers modifiers, bool transformNeeded = true);
 
     bool checkIfDoubleClicked(ulong newPressEventTimestamp);
 
     void setStatus(Status status);
 
-    static QEvent::Type resolveEventType(const QList<QTouchEvent::TouchPoint> &touchPoints);
+    static Qt::TouchPointStates touchPointStates(const QList<QTouchEvent::TouchPoint> &touchPoints);
+    static QEvent::Type resolveEventType(Qt::TouchPointStates eventStates);
 
     QPointer<QQuickItem> m_targetItem;
 
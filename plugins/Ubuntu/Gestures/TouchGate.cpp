@@ -15,11 +15,14 @@
  */
 
 #include "TouchGate.h"
+#include "inputlatencytracer.h"
 
 #include <QCoreApplication>
 #include <QDebug>
 #include <QQuickWindow>
 
+#include <utility>
+
 #include <UbuntuGestures/private/touchownershipevent_p.h>
 #include <UbuntuGestures/private/touchregistry_p.h>
 
@@ -52,10 +55,13 @@ bool TouchGate::event(QEvent *e)
 void TouchGate::touchEvent(QTouchEvent *event)
 {
     ugDebug("got touch event" << qPrintable(touchEventToString(event)));
+    InputLatencyTracer::mark(InputLatencyTracer::InputReceived, "TouchGate");
     event->accept();
 
     const QList<QTouchEvent::TouchPoint> &touchPoints = event->touchPoints();
-    QList<QTouchEvent::TouchPoint> validTouchPoints;
+    // Shares the event's points, so it's only copied if we drop some of them
+    QList<QTouchEvent::TouchPoint> validTouchPoints = touchPoints;
+    int validIndex = 0;
     bool ownsAllTouches = true;
     for (int i = 0; i < touchPoints.count(); ++i) {
         const QTouchEvent::TouchPoint &touchPoint = touchPoints[i];
@@ -65,19 +71,23 @@ void TouchGate::touchEvent(QTouchEvent *event)
 // that it's a bug in the mouse to touch conversion of the test environment
 // and not in the actual product. Still, it probably should be cleaned up eventually.
 //            Q_ASSERT(!m_touchInfoMap.contains(touchPoint.id()));
-            m_touchInfoMap[touchPoint.id()].ownership = OwnershipRequested;
-            m_touchInfoMap[touchPoint.id()].ended = false;
+            TouchInfo &touchInfo = m_touchInfoMap[touchPoint.id()];
+            touchInfo.ownership = OwnershipRequested;
+            touchInfo.ended = false;
             TouchRegistry::instance()->requestTouchOwnership(touchPoint.id(), this);
         }
 
-        if (m_touchInfoMap.contains(touchPoint.id())) {
-            validTouchPoints.append(touchPoint);
+        auto touchInfo = m_touchInfoMap.find(touchPoint.id());
+        if (touchInfo != m_touchInfoMap.end()) {
+            ++validIndex;
 
-            ownsAllTouches &= m_touchInfoMap[touchPoint.id()].ownership == OwnershipGranted;
+            ownsAllTouches &= touchInfo->ownership == OwnershipGranted;
 
             if (touchPoint.state() == Qt::TouchPointReleased) {
-                m_touchInfoMap[touchPoint.id()].ended = true;
+                touchInfo->ended = true;
             }
+        } else {
+            validTouchPoints.removeAt(validIndex);
         }
 
     }
@@ -91,6 +101,7 @@ void TouchGate::touchEvent(QTouchEvent *event)
         if (m_storedEvents.isEmpty()) {
             // let it pass through
             removeTouchInfoForEndedTouches(validTouchPoints);
+            InputLatencyTracer::mark(InputLatencyTracer::QmlDispatched, "TouchGate");
             m_dispatcher.dispatch(event->device(), event->modifiers(), validTouchPoints,
                     event->window(), event->timestamp());
         } else {
@@ -153,29 +164,26 @@ void TouchGate::storeTouchEvent(QTouchDevice *device,
             ulong timestamp)
 {
     ugDebug("Storing" << touchPoints);
-    TouchEvent event(device, modifiers, touchPoints, window, timestamp);
-    m_storedEvents.append(std::move(event));
+    TouchEvent &event = m_storedEvents.append();
+    event.device = device;
+    event.modifiers = modifiers;
+    event.touchPoints = touchPoints;
+    event.window = window;
+    event.timestamp = timestamp;
 }
 
 void TouchGate::removeTouchFromStoredEvents(int touchId)
 {
-    int i = 0;
-    while (i < m_storedEvents.count()) {
-        TouchEvent &event = m_storedEvents[i];
-        bool removed = event.removeTouch(touchId);
-
-        if (removed && event.touchPoints.isEmpty()) {
-            m_storedEvents.removeAt(i);
-        } else {
-            ++i;
-        }
-    }
+    m_storedEvents.removeTouch(touchId);
 }
 
 void TouchGate::dispatchFullyOwnedEvents()
 {
     while (!m_storedEvents.isEmpty() && eventIsFullyOwned(m_storedEvents.first())) {
-        TouchEvent event = m_storedEvents.takeFirst();
+        // Take it out first, dispatching might lead to more events being stored
+        TouchEvent event;
+        std::swap(event, m_storedEvents.first());
+        m_storedEvents.removeFirst();
         dispatchTouchEventToTarget(event);
     }
 }
@@ -224,9 +232,10 @@ void TouchGate::setTargetItem(QQuickItem *item)
     Q_EMIT targetItemChanged(item);
 }
 
-void TouchGate::dispatchTouchEventToTarget(const TouchEvent &event)
+void TouchGate::dispatchTouchEventToTarget(TouchEvent &event)
 {
     removeTouchInfoForEndedTouches(event.touchPoints);
+    InputLatencyTracer::mark(InputLatencyTracer::QmlDispatched, "TouchGate");
     m_dispatcher.dispatch(event.device,
             event.modifiers,
             event.touchPoints,
@@ -236,7 +245,7 @@ void TouchGate::dispatchTouchEventToTarget(const TouchEvent &event)
 
 void TouchGate::removeTouchInfoForEndedTouches(const QList<QTouchEvent::TouchPoint> &touchPoints)
 {
-    for (int i = 0; i < touchPoints.size(); ++i) {\
+    for (int i = 0; i < touchPoints.size(); ++i) {
         const QTouchEvent::TouchPoint &touchPoint = touchPoints.at(i);
 
         if (touchPoint.state() == Qt::TouchPointReleased) {
@@ -263,19 +272,6 @@ void TouchGate::reset()
     m_dispatcher.reset();
 }
 
-TouchGate::TouchEvent::TouchEvent(QTouchDevice *device,
-            Qt::KeyboardModifiers modifiers,
-            const QList<QTouchEvent::TouchPoint> &touchPoints,
-            QWindow *window,
-            ulong timestamp)
-    : device(device)
-    , modifiers(modifiers)
-    , touchPoints(touchPoints)
-    , window(window)
-    , timestamp(timestamp)
-{
-}
-
 bool TouchGate::TouchEvent::removeTouch(int touchId)
 {
     bool removed = false;
@@ -288,3 +284,63 @@ bool TouchGate::TouchEvent::removeTouch(int touchId)
 
     return removed;
 }
+
+TouchGate::TouchEventQueue::TouchEventQueue()
+    : m_slots(32)
+    , m_head(0)
+    , m_count(0)
+{
+}
+
+TouchGate::TouchEvent &TouchGate::TouchEventQueue::append()
+{
+    if (m_count == m_slots.count()) {
+        // Out of room. Lay the events out from the start of a bigger buffer.
+        QVector<TouchEvent> slots(m_slots.count() * 2);
+        for (int i = 0; i < m_count; ++i) {
+            std::swap(slots[i], m_slots[slotIndex(i)]);
+        }
+        m_slots.swap(slots);
+        m_head = 0;
+    }
+
+    ++m_count;
+    return m_slots[slotIndex(m_count - 1)];
+}
+
+void TouchGate::TouchEventQueue::removeFirst()
+{
+    Q_ASSERT(m_count > 0);
+    m_slots[m_head].touchPoints.clear();
+    m_head = (m_head + 1) % m_slots.count();
+    --m_count;
+}
+
+void TouchGate::TouchEventQueue::removeTouch(int touchId)
+{
+    // Compact the remaining events in a single pass
+    int kept = 0;
+    for (int i = 0; i < m_count; ++i) {
+        TouchEvent &event = at(i);
+        if (event.removeTouch(touchId) && event.touchPoints.isEmpty()) {
+            continue;
+        }
+        if (kept != i) {
+            std::swap(at(kept), event);
+        }
+        ++kept;
+    }
+    for (int i = kept; i < m_count; ++i) {
+        at(i).touchPoints.clear();
+    }
+    m_count = kept;
+}
+
+void TouchGate::TouchEventQueue::clear()
+{
+    for (int i = 0; i < m_count; ++i) {
+        at(i).touchPoints.clear();
+    }
+    m_head = 0;
+    m_count = 0;
+}
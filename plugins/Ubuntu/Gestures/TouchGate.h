@@ -24,6 +24,7 @@
 #include <QQuickItem>
 #include <QList>
 #include <QMap>
+#include <QVector>
 
 #define TOUCHGATE_DEBUG 0
 
@@ -68,11 +69,7 @@ private:
 
     class TouchEvent {
     public:
-        TouchEvent(QTouchDevice *device,
-            Qt::KeyboardModifiers modifiers,
-            const QList<QTouchEvent::TouchPoint> &touchPoints,
-            QWindow *window,
-            ulong timestamp);
+        TouchEvent() : device(nullptr), window(nullptr), timestamp(0) {}
 
         bool removeTouch(int touchId);
 
@@ -83,6 +80,40 @@ private:
         ulong timestamp;
     };
 
+    /*
+      Events held back until we own all their touches, oldest first.
+
+      A circular buffer over slots allocated upfront, so holding back events
+      doesn't hit the allocator on every touch update. Should more events pile
+      up than it has room for it grows, but it never drops any.
+     */
+    class TouchEventQueue {
+    public:
+        TouchEventQueue();
+
+        bool isEmpty() const { return m_count == 0; }
+        int count() const { return m_count; }
+
+        TouchEvent &first() { return m_slots[m_head]; }
+        const TouchEvent &first() const { return m_slots[m_head]; }
+        TouchEvent &at(int i) { return m_slots[slotIndex(i)]; }
+
+        TouchEvent &append();
+        void removeFirst();
+
+        // Removes the touch from all events, dropping the ones left without touches
+        void removeTouch(int touchId);
+
+        void clear();
+
+    private:
+        int slotIndex(int i) const { return (m_head + i) % m_slots.count(); }
+
+        QVector<TouchEvent> m_slots;
+        int m_head;
+        int m_count;
+    };
+
     void touchOwnershipEvent(UG_PREPEND_NAMESPACE(TouchOwnershipEvent) *event);
     bool isTouchPointOwned(int touchId) const;
     void storeTouchEvent(QTouchDevice *device,
@@ -94,7 +125,7 @@ private:
     void dispatchFullyOwnedEvents();
     bool eventIsFullyOwned(const TouchEvent &event) const;
 
-    void dispatchTouchEventToTarget(const TouchEvent &event);
+    void dispatchTouchEventToTarget(TouchEvent &event);
 
     void removeTouchInfoForEndedTouches(const QList<QTouchEvent::TouchPoint> &touchPoints);
 
@@ -102,7 +133,7 @@ private:
     QString oldestPendingTouchIdsString();
     #endif
 
-    QList<TouchEvent> m_storedEvents;
+    TouchEventQueue m_storedEvents;
 
     enum {
         OwnershipUndefined,
@@ -15,6 +15,7 @@
  */
 
 #include "TouchGestureArea.h"
+#include "inputlatencytracer.h"
 
 #include <UbuntuGestures/private/touchownershipevent_p.h>
 #include <UbuntuGestures/private/touchregistry_p.h>
@@ -145,10 +146,13 @@ TouchGestureArea::TouchGestureArea(QQuickItem* parent)
 TouchGestureArea::~TouchGestureArea()
 {
     clearTouchLists();
-    qDeleteAll(m_liveTouchPoints);
-    m_liveTouchPoints.clear();
-    qDeleteAll(m_cachedTouchPoints);
-    m_cachedTouchPoints.clear();
+    while (!m_liveTouchPoints.isEmpty()) {
+        delete m_liveTouchPoints.takeAt(0);
+    }
+    while (!m_cachedTouchPoints.isEmpty()) {
+        delete m_cachedTouchPoints.takeAt(0);
+    }
+    qDeleteAll(m_touchPointPool);
 }
 
 bool TouchGestureArea::event(QEvent *event)
@@ -193,6 +197,7 @@ void TouchGestureArea::touchEvent(QTouchEvent *event)
     }
 
     tgaDebug(QString("touchEvent(%1) %2").arg(statusToString(m_status)).arg(touchEventString(event)));
+    InputLatencyTracer::mark(InputLatencyTracer::InputReceived, "TouchGestureArea");
 
     switch (m_status) {
         case InternalStatus::WaitingForTouch:
@@ -463,39 +468,44 @@ void TouchGestureArea::updateTouchPoints(QTouchEvent *touchEvent)
         int touchId = touchPoint.id();
 
         if (touchPointState & Qt::TouchPointReleased) {
-            GestureTouchPoint* gtp = m_liveTouchPoints.value(touchId);
+            GestureTouchPoint* gtp = m_liveTouchPoints.take(touchId);
             if (!gtp) continue;
 
             gtp->setPos(touchPoint.pos());
             gtp->setPressed(false);
             m_releasedTouchPoints.append(gtp);
-            m_liveTouchPoints.remove(touchId);
 
             if (updateable) {
-                if (m_cachedTouchPoints.contains(touchId)) {
-                    GestureTouchPoint* cachedPoint = m_cachedTouchPoints.take(touchId);
-                    cachedPoint->deleteLater();
+                GestureTouchPoint* cachedPoint = m_cachedTouchPoints.take(touchId);
+                if (cachedPoint) {
+                    m_retiredTouchPoints.append(cachedPoint);
                 }
             }
             ended = true;
         } else {
-            GestureTouchPoint* gtp = m_liveTouchPoints.value(touchPoint.id(), nullptr);
+            GestureTouchPoint* gtp = m_liveTouchPoints.value(touchId);
             if (!gtp) {
                 gtp = addTouchPoint(&touchPoint);
+                if (!gtp) continue;
                 m_pressedTouchPoints.append(gtp);
 
                 if (updateable) {
-                    if (m_cachedTouchPoints.contains(touchId)) {
-                        m_cachedTouchPoints[touchId]->setPos(touchPoint.pos());
+                    GestureTouchPoint* cachedPoint = m_cachedTouchPoints.value(touchId);
+                    if (cachedPoint) {
+                        cachedPoint->setPos(touchPoint.pos());
                     } else {
-                        m_cachedTouchPoints[touchId] = new GestureTouchPoint(*gtp);
+                        cachedPoint = acquireTouchPoint();
+                        *cachedPoint = *gtp;
+                        if (!m_cachedTouchPoints.insert(cachedPoint)) {
+                            m_touchPointPool.append(cachedPoint);
+                        }
                     }
                 }
                 added = true;
             } else if (touchPointState & Qt::TouchPointMoved) {
+                const bool wasDragging = gtp->dragging();
+                const bool posChanged = gtp->x() != touchPoint.pos().x() || gtp->y() != touchPoint.pos().y();
                 gtp->setPos(touchPoint.pos());
-                m_movedTouchPoints.append(gtp);
-                moved = true;
 
                 const QPointF &currentPos = touchPoint.scenePos();
                 const QPointF &startPos = touchPoint.startScenePos();
@@ -514,11 +524,18 @@ void TouchGestureArea::updateTouchPoints(QTouchEvent *touchEvent)
                     gtp->setDragging(true);
                 }
 
+                // Only tell about the points that actually changed
+                if (posChanged || gtp->dragging() != wasDragging) {
+                    m_movedTouchPoints.append(gtp);
+                    moved = true;
+                }
+
                 if (updateable) {
-                    if (m_cachedTouchPoints.contains(touchId)) {
-                        m_cachedTouchPoints[touchId]->setPos(touchPoint.pos());
+                    GestureTouchPoint* cachedPoint = m_cachedTouchPoints.value(touchId);
+                    if (cachedPoint) {
+                        cachedPoint->setPos(touchPoint.pos());
                         if (overDragThreshold) {
-                            m_cachedTouchPoints[touchId]->setDragging(true);
+                            cachedPoint->setDragging(true);
                         }
                     }
                 }
@@ -529,8 +546,8 @@ void TouchGestureArea::updateTouchPoints(QTouchEvent *touchEvent)
     if (updateable) {
         if (!dragging() && m_status == InternalStatus::Recognized) {
             bool allWantDrag = !m_liveTouchPoints.isEmpty();
-            Q_FOREACH(const auto &point, m_liveTouchPoints) {
-                allWantDrag &= point->dragging();
+            for (int i = 0; i < m_liveTouchPoints.count(); ++i) {
+                allWantDrag &= m_liveTouchPoints.at(i)->dragging();
             }
             // only dragging if all points are dragging.
             if (allWantDrag) {
@@ -538,6 +555,9 @@ void TouchGestureArea::updateTouchPoints(QTouchEvent *touchEvent)
             }
         }
 
+        if (ended || added || moved) {
+            InputLatencyTracer::mark(InputLatencyTracer::QmlDispatched, "TouchGestureArea");
+        }
         if (ended) {
             if (m_liveTouchPoints.isEmpty()) {
                 if (!dragging()) Q_EMIT clicked();
@@ -563,11 +583,15 @@ void TouchGestureArea::updateTouchPoints(QTouchEvent *touchEvent)
 void TouchGestureArea::clearTouchLists()
 {
     Q_FOREACH (QObject *gtp, m_releasedTouchPoints) {
-        delete gtp;
+        m_touchPointPool.append(static_cast<GestureTouchPoint*>(gtp));
     }
-    m_releasedTouchPoints.clear();
-    m_pressedTouchPoints.clear();
-    m_movedTouchPoints.clear();
+    m_touchPointPool += m_retiredTouchPoints;
+    m_retiredTouchPoints.clear();
+
+    // erase() keeps the lists' storage around for the next event, unlike clear()
+    m_releasedTouchPoints.erase(m_releasedTouchPoints.begin(), m_releasedTouchPoints.end());
+    m_pressedTouchPoints.erase(m_pressedTouchPoints.begin(), m_pressedTouchPoints.end());
+    m_movedTouchPoints.erase(m_movedTouchPoints.begin(), m_movedTouchPoints.end());
 }
 
 void TouchGestureArea::setInternalStatus(uint newStatus)
@@ -595,6 +619,7 @@ void TouchGestureArea::setInternalStatus(uint newStatus)
             m_recognitionTimer->start();
             break;
         case InternalStatus::Recognized:
+            InputLatencyTracer::mark(InputLatencyTracer::GestureRecognized, "TouchGestureArea");
             resyncCachedTouchPoints();
             break;
         case InternalStatus::WaitingForRejection:
@@ -737,28 +762,31 @@ void TouchGestureArea::resyncCachedTouchPoints()
     bool moved = false;
 
     // list of deletes
-    QMutableHashIterator<int, GestureTouchPoint*> removeIter(m_cachedTouchPoints);
-    while(removeIter.hasNext()) {
-        removeIter.next();
-        if (!m_liveTouchPoints.contains(removeIter.key())) {
-            m_releasedTouchPoints.append(removeIter.value());
-            removeIter.remove();
+    for (int i = m_cachedTouchPoints.count() - 1; i >= 0; --i) {
+        if (!m_liveTouchPoints.contains(m_cachedTouchPoints.at(i)->id())) {
+            m_releasedTouchPoints.append(m_cachedTouchPoints.takeAt(i));
             ended = true;
         }
     }
 
     // list of adds/moves
-    Q_FOREACH(GestureTouchPoint* touchPoint, m_liveTouchPoints) {
-        if (m_cachedTouchPoints.contains(touchPoint->id())) {
-            GestureTouchPoint* cachedPoint = m_cachedTouchPoints[touchPoint->id()];
-
+    for (int i = 0; i < m_liveTouchPoints.count(); ++i) {
+        GestureTouchPoint* touchPoint = m_liveTouchPoints.at(i);
+        GestureTouchPoint* cachedPoint = m_cachedTouchPoints.value(touchPoint->id());
+        if (cachedPoint) {
             if (*cachedPoint != *touchPoint) {
                 *cachedPoint = *touchPoint;
                 m_movedTouchPoints.append(touchPoint);
                 moved = true;
             }
         } else {
-            m_cachedTouchPoints.insert(touchPoint->id(), new GestureTouchPoint(*touchPoint));
+            cachedPoint = acquireTouchPoint();
+            *cachedPoint = *touchPoint;
+            if (!m_cachedTouchPoints.insert(cachedPoint)) {
+                // can't happen, stale points were dropped above
+                m_touchPointPool.append(cachedPoint);
+                continue;
+            }
             m_pressedTouchPoints.append(touchPoint);
             added = true;
         }
@@ -792,19 +820,76 @@ int TouchGestureArea::touchPoint_count(QQmlListProperty<GestureTouchPoint> *list
 GestureTouchPoint *TouchGestureArea::touchPoint_at(QQmlListProperty<GestureTouchPoint> *list, int index)
 {
     TouchGestureArea *q = static_cast<TouchGestureArea*>(list->object);
-    return (q->m_cachedTouchPoints.begin()+index).value();
+    return q->m_cachedTouchPoints.at(index);
 }
 
 GestureTouchPoint* TouchGestureArea::addTouchPoint(QTouchEvent::TouchPoint const* tp)
 {
-    GestureTouchPoint* gtp = new GestureTouchPoint();
+    if (m_liveTouchPoints.count() == TouchPointSet::Capacity) {
+        qWarning("TouchGestureArea: Ignoring touch %d, already tracking %d touches.",
+                 tp->id(), (int)TouchPointSet::Capacity);
+        return nullptr;
+    }
+
+    GestureTouchPoint* gtp = acquireTouchPoint();
     gtp->setId(tp->id());
     gtp->setPressed(true);
+    gtp->setDragging(false);
     gtp->setPos(tp->pos());
-    m_liveTouchPoints.insert(tp->id(), gtp);
+    m_liveTouchPoints.insert(gtp);
+    return gtp;
+}
+
+GestureTouchPoint* TouchGestureArea::acquireTouchPoint()
+{
+    if (m_touchPointPool.isEmpty()) {
+        return new GestureTouchPoint();
+    }
+    GestureTouchPoint* gtp = m_touchPointPool.last();
+    m_touchPointPool.removeLast();
     return gtp;
 }
 
+GestureTouchPoint* TouchGestureArea::TouchPointSet::value(int touchId) const
+{
+    for (int i = 0; i < m_count; ++i) {
+        if (m_points[i]->id() == touchId) {
+            return m_points[i];
+        }
+    }
+    return nullptr;
+}
+
+bool TouchGestureArea::TouchPointSet::insert(GestureTouchPoint *point)
+{
+    if (m_count == Capacity) {
+        return false;
+    }
+    m_points[m_count++] = point;
+    return true;
+}
+
+GestureTouchPoint* TouchGestureArea::TouchPointSet::take(int touchId)
+{
+    for (int i = 0; i < m_count; ++i) {
+        if (m_points[i]->id() == touchId) {
+            return takeAt(i);
+        }
+    }
+    return nullptr;
+}
+
+GestureTouchPoint* TouchGestureArea::TouchPointSet::takeAt(int index)
+{
+    GestureTouchPoint *point = m_points[index];
+    // Keep the order, QML sees it through the touchPoints property
+    for (int i = index + 1; i < m_count; ++i) {
+        m_points[i - 1] = m_points[i];
+    }
+    --m_count;
+    return point;
+}
+
 void TouchGestureArea::itemChange(ItemChange change, const ItemChangeData &value)
 {
     if (change == QQuickItem::ItemSceneChange) {
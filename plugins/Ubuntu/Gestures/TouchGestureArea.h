@@ -20,6 +20,7 @@
 #include "UbuntuGesturesQmlGlobal.h"
 
 #include <QQuickItem>
+#include <QVector>
 
 #include <UbuntuGestures/ubuntugesturesglobal.h>
 #include <UbuntuGestures/private/timer_p.h>
@@ -199,6 +200,7 @@ private:
     void updateTouchPoints(QTouchEvent *event);
 
     GestureTouchPoint* addTouchPoint(const QTouchEvent::TouchPoint *tp);
+    GestureTouchPoint* acquireTouchPoint();
     void clearTouchLists();
     void setDragging(bool dragging);
     void setInternalStatus(uint status);
@@ -212,9 +214,40 @@ private:
     QSet<int> m_watchedTouches;
     UG_PREPEND_NAMESPACE(AbstractTimer) *m_recognitionTimer;
 
+    /*
+      The touch points being tracked, in a small array with no holes. Touchscreens
+      don't report more than a handful of touches, so a linear search by id beats
+      hashing them.
+     */
+    class TouchPointSet {
+    public:
+        static const int Capacity = 10;
+
+        TouchPointSet() : m_count(0) {}
+
+        int count() const { return m_count; }
+        bool isEmpty() const { return m_count == 0; }
+        GestureTouchPoint *at(int index) const { return m_points[index]; }
+        GestureTouchPoint *value(int touchId) const;
+        bool contains(int touchId) const { return value(touchId) != nullptr; }
+
+        // Returns false if the set is full
+        bool insert(GestureTouchPoint *point);
+        GestureTouchPoint *take(int touchId);
+        GestureTouchPoint *takeAt(int index);
+
+    private:
+        GestureTouchPoint *m_points[Capacity];
+        int m_count;
+    };
+
     bool m_dragging;
-    QHash<int, GestureTouchPoint*> m_liveTouchPoints;
-    QHash<int, GestureTouchPoint*> m_cachedTouchPoints;
+    TouchPointSet m_liveTouchPoints;
+    TouchPointSet m_cachedTouchPoints;
+    // GestureTouchPoints no longer in use, to be handed out again by acquireTouchPoint()
+    QVector<GestureTouchPoint*> m_touchPointPool;
+    // Dropped from m_cachedTouchPoints during this event, back into the pool with the next one
+    QVector<GestureTouchPoint*> m_retiredTouchPoints;
     QList<QObject*> m_releasedTouchPoints;
     QList<QObject*> m_pressedTouchPoints;
     QList<QObject*> m_movedTouchPoints;
@@ -28,10 +28,6 @@ public:
 
 public Q_SLOTS:
     void setCurrentScope(int index, bool animate, bool isSwipe);
-
-private:
-    QDBusAbstractInterface* createInterface(const QString &service, const QString &path,
-                                            const QString &interface, const QDBusConnection &connection) override;
 };
 
 #endif
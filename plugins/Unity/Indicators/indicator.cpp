@@ -33,12 +33,21 @@ Indicator::~Indicator()
 
 void Indicator::init(const QString& busName, const QSettings& settings)
 {
-    // Save all keys we care about from the QSettings object.  It's annoying
-    // that we can't just copy the object.
-    m_settings.clear();
+    // It's annoying that we can't just copy the object.
+    QVariantMap settingsMap;
     Q_FOREACH(const QString& key, settings.allKeys()) {
-        if (key.endsWith(QLatin1String("/Position")) || key.endsWith(QLatin1String("/ObjectPath"))) {
-            m_settings.insert(key, settings.value(key));
+        settingsMap.insert(key, settings.value(key));
+    }
+    init(busName, settingsMap);
+}
+
+void Indicator::init(const QString& busName, const QVariantMap& settings)
+{
+    // Save all keys we care about from the settings.
+    m_settings.clear();
+    for (auto it = settings.constBegin(); it != settings.constEnd(); ++it) {
+        if (it.key().endsWith(QLatin1String("/Position")) || it.key().endsWith(QLatin1String("/ObjectPath"))) {
+            m_settings.insert(it.key(), it.value());
         }
     }
 
@@ -86,9 +95,8 @@ void Indicator::setProfile(const QString& profile)
         pos = m_settings.value(QStringLiteral("Indicator Service/Position"), QVariant::fromValue(0));
     setPosition(pos.toInt());
 
-    const QString menuObjectPath = m_settings.value(profile + "/ObjectPath").toString();
     QVariantMap map = m_properties.toMap();
-    map.insert(QStringLiteral("menuObjectPath"), menuObjectPath);
+    map.insert(QStringLiteral("menuObjectPath"), menuObjectPath(profile));
     setIndicatorProperties(map);
 }
 
@@ -97,6 +105,11 @@ QVariant Indicator::indicatorProperties() const
     return m_properties;
 }
 
+QString Indicator::menuObjectPath(const QString& profile) const
+{
+    return m_settings.value(profile + "/ObjectPath").toString();
+}
+
 void Indicator::setIndicatorProperties(const QVariant &properties)
 {
     if (m_properties != properties)
@@ -36,10 +36,12 @@ public:
     virtual ~Indicator();
 
     void init(const QString& busName, const QSettings& settings);
+    void init(const QString& busName, const QVariantMap& settings);
 
     QString identifier() const;
     int position() const;
     QVariant indicatorProperties() const;
+    QString menuObjectPath(const QString& profile) const;
 
 public Q_SLOTS:
     void setProfile(const QString& profile);
@@ -15,12 +15,58 @@
  */
 
 #include "indicatorsmanager.h"
+#include "unitymenumodelcache.h"
 
+#include <QDateTime>
 #include <QSettings>
 #include <QDebug>
 
 #include <paths.h>
 
+// An indicator file as parsed, kept until the file changes.
+struct IndicatorDescriptor
+{
+    QDateTime lastModified;
+    qint64 size;
+    QVariantMap settings;
+};
+
+static QHash<QString, IndicatorDescriptor>& descriptorCache()
+{
+    static QHash<QString, IndicatorDescriptor> cache;
+    return cache;
+}
+
+static bool isUpToDate(const IndicatorDescriptor& descriptor, const QFileInfo& file_info)
+{
+    return descriptor.lastModified == file_info.lastModified() && descriptor.size == file_info.size();
+}
+
+static IndicatorDescriptor descriptorFor(const QFileInfo& file_info)
+{
+    QHash<QString, IndicatorDescriptor>& cache = descriptorCache();
+    const QString path = file_info.absoluteFilePath();
+
+    auto iter = cache.constFind(path);
+    if (iter != cache.constEnd() && isUpToDate(*iter, file_info))
+    {
+        return *iter;
+    }
+
+    IndicatorDescriptor descriptor;
+    descriptor.lastModified = file_info.lastModified();
+    descriptor.size = file_info.size();
+
+    QSettings settings(path, QSettings::IniFormat);
+    Q_FOREACH(const QString& key, settings.allKeys())
+    {
+        descriptor.settings.insert(key, settings.value(key));
+    }
+
+    cache.insert(path, descriptor);
+    return descriptor;
+}
+
 
 class IndicatorsManager::IndicatorData
 {
@@ -34,6 +80,7 @@ public:
 
     QString m_name;
     QFileInfo m_fileInfo;
+    IndicatorDescriptor m_descriptor;
 
     bool m_verified;
     Indicator::Ptr m_indicator;
@@ -103,6 +150,13 @@ void IndicatorsManager::loadDir(const QDir& dir)
     const QFileInfoList indicator_files = dir.entryInfoList(QStringList(), QDir::Files|QDir::NoDotAndDotDot);
     Q_FOREACH(const QFileInfo& indicator_file, indicator_files)
     {
+        // Only the files that were added or changed since the last time need loading
+        IndicatorData* data = dataForFile(indicator_file);
+        if (data && isUpToDate(data->m_descriptor, indicator_file))
+        {
+            data->m_verified = true;
+            continue;
+        }
         loadFile(indicator_file);
     }
 
@@ -111,8 +165,8 @@ void IndicatorsManager::loadDir(const QDir& dir)
 
 void IndicatorsManager::loadFile(const QFileInfo& file_info)
 {
-    QSettings indicator_settings(file_info.absoluteFilePath(), QSettings::IniFormat, this);
-    const QString name = indicator_settings.value(QStringLiteral("Indicator Service/Name")).toString();
+    const IndicatorDescriptor descriptor = descriptorFor(file_info);
+    const QString name = descriptor.settings.value(QStringLiteral("Indicator Service/Name")).toString();
 
     auto iter = m_indicatorsData.constFind(name);
     if (iter != m_indicatorsData.constEnd())
@@ -152,15 +206,24 @@ void IndicatorsManager::loadFile(const QFileInfo& file_info)
         if (file_info_location <= current_data_location &&
             file_info != currentData->m_fileInfo)
         {
+            m_indicatorsDataByPath.remove(currentData->m_fileInfo.absoluteFilePath());
+            m_indicatorsDataByPath.insert(file_info.absoluteFilePath(), currentData);
             currentData->m_fileInfo = file_info;
+            currentData->m_descriptor = descriptor;
             Q_EMIT indicatorLoaded(name);
         }
+        else if (file_info == currentData->m_fileInfo)
+        {
+            currentData->m_descriptor = descriptor;
+        }
     }
     else
     {
         IndicatorData* data = new IndicatorData(name, file_info);
+        data->m_descriptor = descriptor;
         data->m_verified = true;
         m_indicatorsData[name]= data;
+        m_indicatorsDataByPath[file_info.absoluteFilePath()] = data;
         Q_EMIT indicatorLoaded(name);
     }
 }
@@ -176,33 +239,35 @@ void IndicatorsManager::unload()
 
     qDeleteAll(m_indicatorsData);
     m_indicatorsData.clear();
+    m_indicatorsDataByPath.clear();
+    updatePinnedMenus();
 
     setLoaded(false);
 }
 
 void IndicatorsManager::unloadFile(const QFileInfo& file)
 {
-    QMutableHashIterator<QString, IndicatorData*> iter(m_indicatorsData);
-    while(iter.hasNext())
+    IndicatorData* data = dataForFile(file);
+    if (data && !data->m_verified)
     {
-        iter.next();
-        IndicatorData* data = iter.value();
-        if (data->m_fileInfo.absoluteFilePath() == file.absoluteFilePath())
-        {
-            if (!data->m_verified)
-            {
-                const QString name = data->m_name;
-                Q_EMIT indicatorAboutToBeUnloaded(name);
+        const QString name = data->m_name;
+        Q_EMIT indicatorAboutToBeUnloaded(name);
 
-                delete data;
-                iter.remove();
-            }
-        }
+        descriptorCache().remove(data->m_fileInfo.absoluteFilePath());
+        m_indicatorsDataByPath.remove(data->m_fileInfo.absoluteFilePath());
+        m_indicatorsData.remove(name);
+        delete data;
     }
+    updatePinnedMenus();
 
     setLoaded(m_indicatorsData.size() > 0);
 }
 
+IndicatorsManager::IndicatorData* IndicatorsManager::dataForFile(const QFileInfo& file_info) const
+{
+    return m_indicatorsDataByPath.value(file_info.absoluteFilePath());
+}
+
 void IndicatorsManager::setLoaded(bool loaded)
 {
     if (loaded != m_loaded)
@@ -220,8 +285,12 @@ QString IndicatorsManager::profile() const
 void IndicatorsManager::setProfile(const QString& profile)
 {
     if (m_profile != profile) {
+        // Gets the menus of the new profile going before the indicators switch over to them
+        prefetch(profile);
+
         m_profile = profile;
         Q_EMIT profileChanged(m_profile);
+        updatePinnedMenus();
     }
 }
 
@@ -253,11 +322,14 @@ void IndicatorsManager::endVerify(const QString& path)
                 const QString name = data->m_name;
                 Q_EMIT indicatorAboutToBeUnloaded(name);
 
+                descriptorCache().remove(data->m_fileInfo.absoluteFilePath());
+                m_indicatorsDataByPath.remove(data->m_fileInfo.absoluteFilePath());
                 delete data;
                 iter.remove();
             }
         }
     }
+    updatePinnedMenus();
 }
 
 Indicator::Ptr IndicatorsManager::indicator(const QString& indicator_name)
@@ -276,22 +348,12 @@ Indicator::Ptr IndicatorsManager::indicator(const QString& indicator_name)
 
     Indicator::Ptr new_indicator(new Indicator(this));
     data->m_indicator = new_indicator;
-    QSettings settings(data->m_fileInfo.absoluteFilePath(), QSettings::IniFormat, this);
-    new_indicator->init(data->m_fileInfo.fileName(), settings);
+    new_indicator->init(data->m_fileInfo.fileName(), data->m_descriptor.settings);
 
-    // convergence:
-    // 1) enable session indicator
-    // 2) enable keyboard indicator
-    //
-    // The rest of the indicators respect their default profile (which is "phone", even on desktop PCs)
-    if ((new_indicator->identifier() == QStringLiteral("indicator-session"))
-            || new_indicator->identifier() == QStringLiteral("indicator-keyboard")) {
-        new_indicator->setProfile(QString(m_profile).replace(QStringLiteral("phone"), QStringLiteral("desktop")));
-    } else {
-        new_indicator->setProfile(m_profile);
-    }
+    new_indicator->setProfile(profileFor(indicator_name, m_profile));
 
     QObject::connect(this, &IndicatorsManager::profileChanged, new_indicator.data(), &Indicator::setProfile);
+    updatePinnedMenus();
     return new_indicator;
 }
 
@@ -307,7 +369,82 @@ QVector<Indicator::Ptr> IndicatorsManager::indicators()
     return list;
 }
 
+QStringList IndicatorsManager::indicatorNames() const
+{
+    return m_indicatorsData.keys();
+}
+
+bool IndicatorsManager::isIndicatorInProfile(const QString& indicator_name) const
+{
+    IndicatorData* data = m_indicatorsData.value(indicator_name);
+    if (!data)
+        return false;
+
+    const QString profile = profileFor(indicator_name, m_profile);
+    return data->m_descriptor.settings.contains(profile + QStringLiteral("/ObjectPath"));
+}
+
 bool IndicatorsManager::isLoaded() const
 {
     return m_loaded;
 }
+
+void IndicatorsManager::prefetch(const QString& profile)
+{
+    UnityMenuModelCache* cache = UnityMenuModelCache::singleton();
+
+    // Straight from the indicator files, no need to create the indicators for this
+    Q_FOREACH(IndicatorData* data, m_indicatorsData)
+    {
+        const QVariantMap& settings = data->m_descriptor.settings;
+        const QString menuObjectPath = settings.value(profileFor(data->m_name, profile) + QStringLiteral("/ObjectPath")).toString();
+
+        QVariantMap actions;
+        actions.insert(QStringLiteral("indicator"), settings.value(QStringLiteral("Indicator Service/ObjectPath")));
+
+        cache->prefetch(menuObjectPath.toUtf8(), data->m_fileInfo.fileName().toUtf8(), actions);
+    }
+}
+
+QString IndicatorsManager::profileFor(const QString& indicator_name, const QString& profile) const
+{
+    // convergence:
+    // 1) enable session indicator
+    // 2) enable keyboard indicator
+    //
+    // The rest of the indicators respect their default profile (which is "phone", even on desktop PCs)
+    if ((indicator_name == QStringLiteral("indicator-session"))
+            || indicator_name == QStringLiteral("indicator-keyboard")) {
+        return QString(profile).replace(QStringLiteral("phone"), QStringLiteral("desktop"));
+    }
+    return profile;
+}
+
+void IndicatorsManager::updatePinnedMenus()
+{
+    QSet<QByteArray> menuPaths;
+    Q_FOREACH(IndicatorData* data, m_indicatorsData)
+    {
+        if (!data->m_indicator)
+            continue;
+
+        const QVariantMap properties = data->m_indicator->indicatorProperties().toMap();
+        const QByteArray menuObjectPath = properties.value(QStringLiteral("menuObjectPath")).toByteArray();
+        if (!menuObjectPath.isEmpty())
+            menuPaths.insert(menuObjectPath);
+    }
+
+    if (menuPaths == m_pinnedMenuPaths)
+        return;
+
+    UnityMenuModelCache* cache = UnityMenuModelCache::singleton();
+    Q_FOREACH(const QByteArray& path, menuPaths - m_pinnedMenuPaths)
+    {
+        cache->pin(path);
+    }
+    Q_FOREACH(const QByteArray& path, m_pinnedMenuPaths - menuPaths)
+    {
+        cache->unpin(path);
+    }
+    m_pinnedMenuPaths = menuPaths;
+}
@@ -27,6 +27,7 @@
 #include <QFileSystemWatcher>
 #include <QDir>
 #include <QHash>
+#include <QSet>
 #include <QSharedPointer>
 
 class UNITYINDICATORS_EXPORT IndicatorsManager : public QObject
@@ -48,8 +49,15 @@ public:
 
     QVector<Indicator::Ptr> indicators();
 
+    QStringList indicatorNames() const;
+    // Whether the indicator has a menu in the current profile
+    bool isIndicatorInProfile(const QString& indicator_name) const;
+
     bool isLoaded() const;
 
+    // Gets the indicator menus of profile ready ahead of switching to it
+    Q_INVOKABLE void prefetch(const QString& profile);
+
 Q_SIGNALS:
     void loadedChanged(bool);
     void profileChanged(const QString&);
@@ -72,10 +80,19 @@ private:
     void setLoaded(bool);
 
     class IndicatorData;
+    IndicatorData* dataForFile(const QFileInfo& file_info) const;
+
+    QString profileFor(const QString& indicator_name, const QString& profile) const;
+    void updatePinnedMenus();
+
     QHash<QString, IndicatorData*> m_indicatorsData;
+    // The same data, keyed by the absolute path of the indicator file
+    QHash<QString, IndicatorData*> m_indicatorsDataByPath;
     QSharedPointer<QFileSystemWatcher> m_fsWatcher;
     bool m_loaded;
     QString m_profile;
+    // The menus of the active profile, kept in the UnityMenuModelCache
+    QSet<QByteArray> m_pinnedMenuPaths;
 };
 
 #endif // INDICATORS_MANAGER_H
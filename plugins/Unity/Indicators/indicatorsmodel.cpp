@@ -57,6 +57,7 @@ IndicatorsModel::IndicatorsModel(QObject *parent)
     QObject::connect(m_manager, &IndicatorsManager::indicatorLoaded, this, &IndicatorsModel::onIndicatorLoaded);
     QObject::connect(m_manager, &IndicatorsManager::indicatorAboutToBeUnloaded, this, &IndicatorsModel::onIndicatorAboutToBeUnloaded);
     QObject::connect(m_manager, &IndicatorsManager::profileChanged, this, &IndicatorsModel::profileChanged);
+    QObject::connect(m_manager, &IndicatorsManager::profileChanged, this, &IndicatorsModel::onProfileChanged);
 
     QObject::connect(this, &IndicatorsModel::rowsInserted, this, &IndicatorsModel::countChanged);
     QObject::connect(this, &IndicatorsModel::rowsRemoved, this, &IndicatorsModel::countChanged);
@@ -124,9 +125,25 @@ void IndicatorsModel::unload()
     m_manager->unload();
 }
 
+/*!
+    \qmlmethod IndicatorsModel::prefetch(profile)
+
+    Get the indicator menus of profile ready ahead of switching to it.
+*/
+void IndicatorsModel::prefetch(const QString& profile)
+{
+    m_manager->prefetch(profile);
+}
+
 /*! \internal */
 void IndicatorsModel::onIndicatorLoaded(const QString& indicator_name)
 {
+    // Indicators are only created once there's a menu to show for them
+    if (!m_manager->isIndicatorInProfile(indicator_name))
+    {
+        return;
+    }
+
     Indicator::Ptr indicator = m_manager->indicator(indicator_name);
     if (!indicator)
     {
@@ -160,17 +177,12 @@ void IndicatorsModel::onIndicatorLoaded(const QString& indicator_name)
 /*! \internal */
 void IndicatorsModel::onIndicatorAboutToBeUnloaded(const QString& indicator_name)
 {
-    Indicator::Ptr indicator = m_manager->indicator(indicator_name);
-    if (!indicator)
-    {
-        return;
-    }
-
+    // Not through the manager, which would create the indicator if it's not in the model
     int i = 0;
     QMutableListIterator<Indicator::Ptr> iter(m_indicators);
     while(iter.hasNext())
     {
-        if (indicator == iter.next())
+        if (iter.next()->identifier() == indicator_name)
         {
             beginRemoveRows(QModelIndex(), i, i);
             iter.remove();
@@ -182,6 +194,30 @@ void IndicatorsModel::onIndicatorAboutToBeUnloaded(const QString& indicator_name
 
 }
 
+/*! \internal */
+void IndicatorsModel::onProfileChanged()
+{
+    // Drop the indicators the new profile has no menu for
+    for (int i = m_indicators.count() - 1; i >= 0; i--)
+    {
+        Indicator::Ptr indicator = m_indicators.at(i);
+        if (!m_manager->isIndicatorInProfile(indicator->identifier()))
+        {
+            QObject::disconnect(indicator.data(), 0, this, 0);
+
+            beginRemoveRows(QModelIndex(), i, i);
+            m_indicators.removeAt(i);
+            endRemoveRows();
+        }
+    }
+
+    // Add the indicators the new profile shows that the old one didn't
+    Q_FOREACH(const QString& indicator_name, m_manager->indicatorNames())
+    {
+        onIndicatorLoaded(indicator_name);
+    }
+}
+
 /*! \internal */
 void IndicatorsModel::onIdentifierChanged()
 {
@@ -42,6 +42,7 @@ public:
 
     Q_INVOKABLE void load();
     Q_INVOKABLE void unload();
+    Q_INVOKABLE void prefetch(const QString& profile);
 
     Q_INVOKABLE QVariant data(int row, int role) const;
 
@@ -66,6 +67,7 @@ private Q_SLOTS:
     void onIndicatorPropertiesChanged();
     void onIndicatorLoaded(const QString& indicator);
     void onIndicatorAboutToBeUnloaded(const QString& indicator);
+    void onProfileChanged();
 
 private:
     IndicatorsManager *m_manager;
@@ -18,6 +18,19 @@
 
  #include "menucontentactivator.h"
 
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QQuickWindow>
+#include <QVector>
+
+// How far ahead the panel position is predicted
+static const int LookAheadMsecs = 250;
+// Frames taking longer than this hold off activations
+static const int FrameBudgetMsecs = 20;
+// No frames for this long means nothing's animating
+static const int IdleFrameGapMsecs = 100;
+static const int MaxActivationsPerTick = 3;
+
 // Essentially a QTimer wrapper
 class ContentTimer : public UnityIndicators::AbstractTimer
 {
@@ -45,6 +58,10 @@ public:
         m_baseIndex(0),
         m_delta(0),
         m_count(0),
+        m_position(0),
+        m_velocity(0),
+        m_lastFrameMsecs(-1),
+        m_skippedTick(false),
         m_timer(nullptr),
         q(parent)
     {}
@@ -55,7 +72,9 @@ public:
         m_content.clear();
     }
 
-    int findNextInactiveDelta(bool* finished = nullptr);
+    MenuContentState* state(int index) const;
+    int findNextInactiveIndex() const;
+    int activationBudget();
 
     static int content_count(QQmlListProperty<MenuContentState> *prop);
     static MenuContentState* content_at(QQmlListProperty<MenuContentState> *prop, int index);
@@ -64,8 +83,15 @@ public:
     int m_baseIndex;
     int m_delta;
     int m_count;
+    qreal m_position;
+    qreal m_velocity;
+    int m_lastFrameMsecs; // -1 if there's no feedback
+    bool m_skippedTick;
+    QPointer<QQuickWindow> m_window;
+    QElapsedTimer m_frameClock;
     UnityIndicators::AbstractTimer* m_timer;
-    QMap<int, MenuContentState*> m_content;
+    // Indexed by menu, null until first asked for
+    QVector<MenuContentState*> m_content;
     MenuContentActivator* q;
 };
 
@@ -91,9 +117,7 @@ void MenuContentActivator::restart()
     setDelta(0);
 
     // check if we've finished before starting the timer.
-    bool finished = false;
-    d->findNextInactiveDelta(&finished);
-    if (!finished) {
+    if (d->findNextInactiveIndex() != -1) {
         d->m_timer->start();
     } else {
         d->m_timer->stop();
@@ -116,8 +140,10 @@ void MenuContentActivator::stop()
 
 void MenuContentActivator::clear()
 {
-    qDeleteAll(d->m_content);
-    d->m_content.clear();
+    // QML might still hold on to them, so they're kept for reuse
+    Q_FOREACH(MenuContentState* content, d->m_content) {
+        if (content) content->setActive(false);
+    }
 
     setDelta(0);
     d->m_timer->stop();
@@ -127,9 +153,8 @@ void MenuContentActivator::clear()
 
 bool MenuContentActivator::isMenuContentActive(int index) const
 {
-    if (d->m_content.contains(index))
-        return d->m_content[index]->isActive();
-    return false;
+    MenuContentState* content = d->state(index);
+    return content && content->isActive();
 }
 
 void MenuContentActivator::setRunning(bool running)
@@ -150,6 +175,7 @@ void MenuContentActivator::setBaseIndex(int index)
 {
     if (d->m_baseIndex != index) {
         d->m_baseIndex = index;
+        setPosition(index);
 
         if (isRunning()) {
             restart();
@@ -194,6 +220,72 @@ int MenuContentActivator::delta() const
     return d->m_delta;
 }
 
+void MenuContentActivator::setPosition(qreal position)
+{
+    if (d->m_position != position) {
+        d->m_position = position;
+        Q_EMIT positionChanged(position);
+    }
+}
+
+qreal MenuContentActivator::position() const
+{
+    return d->m_position;
+}
+
+void MenuContentActivator::setVelocity(qreal velocity)
+{
+    if (d->m_velocity != velocity) {
+        d->m_velocity = velocity;
+        Q_EMIT velocityChanged(velocity);
+    }
+}
+
+qreal MenuContentActivator::velocity() const
+{
+    return d->m_velocity;
+}
+
+void MenuContentActivator::setWindow(QQuickWindow* window)
+{
+    if (d->m_window == window) {
+        return;
+    }
+
+    if (d->m_window) {
+        disconnect(d->m_window, &QQuickWindow::frameSwapped, this, &MenuContentActivator::onFrameSwapped);
+    }
+    d->m_window = window;
+    d->m_frameClock.invalidate();
+    d->m_lastFrameMsecs = -1;
+
+    if (d->m_window) {
+        // Emitted from the render thread, so this ends up queued
+        connect(d->m_window, &QQuickWindow::frameSwapped, this, &MenuContentActivator::onFrameSwapped);
+    }
+    Q_EMIT windowChanged(window);
+}
+
+QQuickWindow* MenuContentActivator::window() const
+{
+    return d->m_window;
+}
+
+void MenuContentActivator::reportFrameTime(int msecs)
+{
+    d->m_lastFrameMsecs = msecs;
+}
+
+void MenuContentActivator::onFrameSwapped()
+{
+    if (d->m_frameClock.isValid()) {
+        const qint64 elapsed = d->m_frameClock.restart();
+        reportFrameTime(elapsed > IdleFrameGapMsecs ? 0 : elapsed);
+    } else {
+        d->m_frameClock.start();
+    }
+}
+
 QQmlListProperty<MenuContentState> MenuContentActivator::content()
 {
     return QQmlListProperty<MenuContentState>(this,
@@ -204,14 +296,16 @@ QQmlListProperty<MenuContentState> MenuContentActivator::content()
 
 void MenuContentActivator::onTimeout()
 {
-    bool finished = false;
-    int tempDelta = d->findNextInactiveDelta(&finished);
-    if (!finished) {
-        setMenuContentState(d->m_baseIndex + tempDelta, true);
-        setDelta(tempDelta);
+    for (int budget = d->activationBudget(); budget > 0; --budget) {
+        int index = d->findNextInactiveIndex();
+        if (index == -1) {
+            break;
+        }
+        setMenuContentState(index, true);
+        setDelta(index - d->m_baseIndex);
     }
 
-    if (finished) {
+    if (d->findNextInactiveIndex() == -1) {
         d->m_timer->stop();
     }
 }
@@ -241,64 +335,71 @@ void MenuContentActivator::setContentTimer(UnityIndicators::AbstractTimer *timer
 
 void MenuContentActivator::setMenuContentState(int index, bool active)
 {
-    if (d->m_content.contains(index)) {
-        d->m_content[index]->setActive(active);
+    if (index < 0) {
+        return;
+    }
+
+    if (MenuContentState* content = d->state(index)) {
+        content->setActive(active);
     } else {
+        if (index >= d->m_content.count()) {
+            d->m_content.resize(index + 1);
+        }
         d->m_content[index] = new MenuContentState(active);
         Q_EMIT contentChanged();
     }
 }
 
-int MenuContentActivatorPrivate::findNextInactiveDelta(bool* finished)
+MenuContentState* MenuContentActivatorPrivate::state(int index) const
+{
+    if (index < 0 || index >= m_content.count()) {
+        return nullptr;
+    }
+    return m_content[index];
+}
+
+int MenuContentActivatorPrivate::findNextInactiveIndex() const
 {
     if (m_count == 0 || m_baseIndex >= m_count) {
-        if (finished) *finished = true;
-        return 0;
+        return -1;
     }
 
-    int tmpDelta = m_delta;
-    bool topReached = false, bottomReached = false;
-    while(true) {
-
-        // prechecks for bottom and top limits.
-        if (tmpDelta > 0 && bottomReached) tmpDelta = -tmpDelta;
-        if (tmpDelta < 0 && topReached) tmpDelta = (-tmpDelta) + 1;
-
-        if (tmpDelta > 0) {
-            // negative of baseIndex
-            tmpDelta = -tmpDelta;
-            // reached the bottom?
-            if (m_baseIndex + tmpDelta < 0) {
-                bottomReached = true;
-                // if we've reached the top as well, then we know we're done.
-                if (topReached) {
-                    if (finished) *finished = true;
-                    return 0;
-                }
-                continue;
-            }
-        } else {
-            // positive of baseIndex
-            tmpDelta = (-tmpDelta) + 1;
-            // reached the top?
-            if (m_baseIndex + tmpDelta >= m_count) {
-                topReached = true;
-                // if we've reached the bottom as well, then we know we're done.
-                if (bottomReached) {
-                    if (finished) *finished = true;
-                    return 0;
-                }
-                continue;
-            }
-        }
+    // Closest to where the panel is heading first. On a tie, the one in the
+    // direction it's heading, or the next one up when it's not moving.
+    const qreal predicted = m_position + m_velocity * LookAheadMsecs / 1000;
+    const bool preferHigher = m_velocity >= 0;
 
-        if (q->isMenuContentActive(m_baseIndex + tmpDelta)) {
+    int next = -1;
+    qreal nextDistance = 0;
+    for (int index = 0; index < m_count; ++index) {
+        if (q->isMenuContentActive(index)) {
             continue;
         }
-        break;
+
+        const qreal distance = qAbs(index - predicted);
+        if (next == -1 || distance < nextDistance - 0.0001 ||
+                (preferHigher && distance <= nextDistance + 0.0001)) {
+            next = index;
+            nextDistance = distance;
+        }
+    }
+    return next;
+}
+
+int MenuContentActivatorPrivate::activationBudget()
+{
+    if (m_lastFrameMsecs < 0) {
+        return 1;
     }
-    if (finished) *finished = false;
-    return tmpDelta;
+
+    if (m_lastFrameMsecs > FrameBudgetMsecs) {
+        // Sit this one out while frames are slow, but don't starve the content
+        m_skippedTick = !m_skippedTick;
+        return m_skippedTick ? 0 : 1;
+    }
+
+    m_skippedTick = false;
+    return MaxActivationsPerTick;
 }
 
 int MenuContentActivatorPrivate::content_count(QQmlListProperty<MenuContentState> *prop)
@@ -313,13 +414,19 @@ MenuContentState* MenuContentActivatorPrivate::content_at(QQmlListProperty<MenuC
     MenuContentActivator *p = qobject_cast<MenuContentActivator*>(prop->object);
     MenuContentActivatorPrivate *d = p->d;
 
-    if (!d->m_content.contains(index)) {
-        MenuContentState* content = new MenuContentState(false);
-        d->m_content[index] = content;
-        return content;
+    if (index < 0) {
+        return nullptr;
     }
 
-    return d->m_content[index];
+    MenuContentState* content = d->state(index);
+    if (!content) {
+        if (index >= d->m_content.count()) {
+            d->m_content.resize(index + 1);
+        }
+        content = new MenuContentState(false);
+        d->m_content[index] = content;
+    }
+    return content;
 }
 
 MenuContentState::MenuContentState(bool active)
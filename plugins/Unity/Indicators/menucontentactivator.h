@@ -25,6 +25,8 @@
 #include <QTimer>
 #include <QQmlListProperty>
 
+class QQuickWindow;
+
 
 namespace UnityIndicators {
 /* Defines an interface for a Timer. */
@@ -63,12 +65,22 @@ private:
 
 class MenuContentActivatorPrivate;
 
+/*
+ * Activates the menu content one by one, most likely to be seen first.
+ *
+ * That's the content closest to where the panel is predicted to be shortly,
+ * going by its position and velocity (both in menu indexes). How many get
+ * activated at a time depends on how long the window's frames are taking.
+ */
 class UNITYINDICATORS_EXPORT MenuContentActivator : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(int baseIndex READ baseIndex WRITE setBaseIndex NOTIFY baseIndexChanged)
     Q_PROPERTY(bool running READ isRunning WRITE setRunning NOTIFY runningChanged)
     Q_PROPERTY(int count READ count WRITE setCount NOTIFY countChanged)
+    Q_PROPERTY(qreal position READ position WRITE setPosition NOTIFY positionChanged)
+    Q_PROPERTY(qreal velocity READ velocity WRITE setVelocity NOTIFY velocityChanged)
+    Q_PROPERTY(QQuickWindow* window READ window WRITE setWindow NOTIFY windowChanged)
     Q_PROPERTY(QQmlListProperty<MenuContentState> content READ content NOTIFY contentChanged DESIGNABLE false)
 public:
     MenuContentActivator(QObject* parent = nullptr);
@@ -91,6 +103,16 @@ public:
     void setDelta(int index);
     int delta() const;
 
+    // Setting the base index moves the position there too
+    void setPosition(qreal position);
+    qreal position() const;
+
+    void setVelocity(qreal velocity);
+    qreal velocity() const;
+
+    void setWindow(QQuickWindow* window);
+    QQuickWindow* window() const;
+
     QQmlListProperty<MenuContentState> content();
 
     // Replaces the existing Timer with the given one.
@@ -99,15 +121,23 @@ public:
     void setContentTimer(UnityIndicators::AbstractTimer *timer);
     void setMenuContentState(int index, bool active);
 
+    // Feeds back how long the last frame took. Done automatically with a window set,
+    // useful when testing.
+    void reportFrameTime(int msecs);
+
 Q_SIGNALS:
     void baseIndexChanged(int baseIndex);
     void deltaChanged(int delta);
     void runningChanged(bool running);
     void countChanged(int count);
+    void positionChanged(qreal position);
+    void velocityChanged(qreal velocity);
+    void windowChanged(QQuickWindow* window);
     void contentChanged();
 
 private Q_SLOTS:
     void onTimeout();
+    void onFrameSwapped();
 
 private:
     MenuContentActivatorPrivate* d;
@@ -139,13 +139,19 @@ void ModelActionRootState::updateActionState()
 
     if (m_menu && m_menu->rowCount() > 0) {
         ActionStateParser* oldParser = m_menu->actionStateParser();
-        m_menu->setActionStateParser(&m_parser);
+        m_menu->setActionStateParser(&m_deferredParser);
 
-        QVariantMap state = m_menu->get(0, "actionState").toMap();
+        QVariant state = m_menu->get(0, "actionState");
 
         m_menu->setActionStateParser(oldParser);
 
-        setCurrentState(state);
+        // The conversion is left to a worker thread, unless the menu didn't go through the parser
+        GVariant* rawState = m_deferredParser.takeState();
+        if (rawState) {
+            setCurrentStateAsync(rawState);
+        } else {
+            setCurrentState(state.toMap());
+        }
     } else if (!m_menu) {
         setCurrentState(QVariantMap());
     }
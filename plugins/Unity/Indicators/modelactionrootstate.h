@@ -63,6 +63,7 @@ private:
     void updateOtherActions();
 
     UnityMenuModel* m_menu;
+    DeferredRootStateParser m_deferredParser;
     QString m_secondaryAction;
     QString m_scrollAction;
     QString m_submenuAction;
@@ -16,11 +16,33 @@
 
 #include "rootstateparser.h"
 
+#include <QCache>
+#include <QFutureWatcher>
+#include <QMutex>
+#include <QThreadPool>
+#include <QtConcurrent>
+
 extern "C" {
 #include <glib.h>
 #include <gio/gio.h>
 }
 
+// Each indicator sends the same handful of icons over and over
+static const int MaxCachedIcons = 64;
+
+// Keyed on the serialized icon, which saves deserializing and base64 encoding it again.
+class IconUriCache
+{
+public:
+    IconUriCache() : hits(0) { uris.setMaxCost(MaxCachedIcons); }
+
+    QMutex mutex;
+    // Drops the least recently used icons once full
+    QCache<QByteArray, QString> uris;
+    int hits;
+};
+Q_GLOBAL_STATIC(IconUriCache, iconUriCache)
+
 RootStateParser::RootStateParser(QObject* parent)
     : ActionStateParser(parent)
 {
@@ -72,6 +94,47 @@ static QString iconUri(GIcon *icon)
     return uri;
 }
 
+static bool cachedIconUri(GVariant *serializedIcon, QString *uri)
+{
+    IconUriCache *cache = iconUriCache();
+
+    QByteArray key(g_variant_get_type_string(serializedIcon));
+    key.append('\0');
+    const gsize size = g_variant_get_size(serializedIcon);
+    if (size > 0) {
+        key.append(static_cast<const char*>(g_variant_get_data(serializedIcon)), size);
+    }
+
+    {
+        QMutexLocker locker(&cache->mutex);
+        QString *cachedUri = cache->uris.object(key);
+        if (cachedUri) {
+            *uri = *cachedUri;
+            ++cache->hits;
+            return true;
+        }
+    }
+
+    // FIXME - should be sending a url.
+    GIcon *gicon = g_icon_deserialize (serializedIcon);
+    if (!gicon) {
+        return false;
+    }
+    *uri = iconUri(gicon);
+    g_object_unref (gicon);
+
+    QMutexLocker locker(&cache->mutex);
+    cache->uris.insert(key, new QString(*uri));
+    return true;
+}
+
+int RootStateParser::iconCacheHits()
+{
+    IconUriCache *cache = iconUriCache();
+    QMutexLocker locker(&cache->mutex);
+    return cache->hits;
+}
+
 QVariant RootStateParser::toQVariant(GVariant* state) const
 {
     if (!state) {
@@ -90,12 +153,9 @@ QVariant RootStateParser::toQVariant(GVariant* state) const
             QString str = QString::fromUtf8(key);
             if (str == QLatin1String("icon") && !qmap.contains(QStringLiteral("icons"))) {
                 QStringList icons;
-
-                // FIXME - should be sending a url.
-                GIcon *gicon = g_icon_deserialize (vvalue);
-                if (gicon) {
-                    icons << iconUri(gicon);
-                    g_object_unref (gicon);
+                QString uri;
+                if (cachedIconUri(vvalue, &uri)) {
+                    icons << uri;
                 }
                 qmap.insert(QStringLiteral("icons"), icons);
 
@@ -109,11 +169,9 @@ QVariant RootStateParser::toQVariant(GVariant* state) const
                     g_variant_iter_init (&iter, vvalue);
                     while (g_variant_iter_loop (&iter, "v", &val))
                     {
-                        // FIXME - should be sending a url.
-                        GIcon *gicon = g_icon_deserialize (val);
-                        if (gicon) {
-                            icons << iconUri(gicon);
-                            g_object_unref (gicon);
+                        QString uri;
+                        if (cachedIconUri(val, &uri)) {
+                            icons << uri;
                         }
                     }
                 }
@@ -134,8 +192,6 @@ QVariant RootStateParser::toQVariant(GVariant* state) const
         char* icon;
         char* accessible_name;
         gboolean visible;
-        GIcon *gicon;
-
         g_variant_get(state, "(sssb)", &label,
                                        &icon,
                                        &accessible_name,
@@ -145,11 +201,13 @@ QVariant RootStateParser::toQVariant(GVariant* state) const
         qmap[QStringLiteral("accessible-desc")] = accessible_name ? QString::fromUtf8(accessible_name) : QLatin1String("");
         qmap[QStringLiteral("visible")] = visible;
 
-        gicon = g_icon_new_for_string (icon, nullptr);
-        if (gicon) {
-            qmap[QStringLiteral("icons")] = QStringList() << iconUri(gicon);
-            g_object_unref (gicon);
+        // Deserializing a string variant is the same as g_icon_new_for_string()
+        GVariant *serializedIcon = g_variant_ref_sink (g_variant_new_string (icon ? icon : ""));
+        QString uri;
+        if (cachedIconUri(serializedIcon, &uri)) {
+            qmap[QStringLiteral("icons")] = QStringList() << uri;
         }
+        g_variant_unref (serializedIcon);
 
         if (label) g_free(label);
         if (icon) g_free(icon);
@@ -160,10 +218,84 @@ QVariant RootStateParser::toQVariant(GVariant* state) const
     return ActionStateParser::toQVariant(state);
 }
 
+DeferredRootStateParser::DeferredRootStateParser(QObject* parent)
+    : ActionStateParser(parent)
+    , m_state(nullptr)
+{
+}
+
+DeferredRootStateParser::~DeferredRootStateParser()
+{
+    if (m_state) g_variant_unref(m_state);
+}
+
+QVariant DeferredRootStateParser::toQVariant(GVariant* state) const
+{
+    if (m_state) g_variant_unref(m_state);
+    m_state = state ? g_variant_ref(state) : nullptr;
+    return QVariant();
+}
+
+GVariant* DeferredRootStateParser::takeState()
+{
+    GVariant* state = m_state;
+    m_state = nullptr;
+    return state;
+}
+
+class ConversionPool : public QThreadPool
+{
+public:
+    ConversionPool()
+    {
+        // Keeps the icon cache warm for whoever comes next, and conversions are quick anyway
+        setMaxThreadCount(1);
+        // Created first so it's destroyed last, conversions still running at exit use it
+        iconUriCache();
+    }
+
+    ~ConversionPool()
+    {
+        waitForDone();
+    }
+};
+Q_GLOBAL_STATIC(ConversionPool, conversionPool)
+
+static RootStateChanges convertRootState(GVariant* state, const QVariantMap& oldState, quint64 generation)
+{
+    RootStateParser parser;
+    const QVariantMap newState = parser.toQVariant(state).toMap();
+    g_variant_unref(state);
+
+    RootStateChanges changes;
+    changes.generation = generation;
+    for (auto it = newState.constBegin(); it != newState.constEnd(); ++it) {
+        auto oldIt = oldState.constFind(it.key());
+        if (oldIt == oldState.constEnd() || oldIt.value() != it.value()) {
+            changes.changed.insert(it.key(), it.value());
+        }
+    }
+    for (auto it = oldState.constBegin(); it != oldState.constEnd(); ++it) {
+        if (!newState.contains(it.key())) {
+            changes.removed << it.key();
+        }
+    }
+    return changes;
+}
 
 RootStateObject::RootStateObject(QObject* parent)
     : QObject(parent)
+    , m_generation(0)
+    , m_convertedState(nullptr)
+    , m_pendingState(nullptr)
+    , m_conversion(nullptr)
+{
+}
+
+RootStateObject::~RootStateObject()
 {
+    if (m_convertedState) g_variant_unref(m_convertedState);
+    if (m_pendingState) g_variant_unref(m_pendingState);
 }
 
 QString RootStateObject::title() const
@@ -210,6 +342,17 @@ bool RootStateObject::indicatorVisible() const
 
 void RootStateObject::setCurrentState(const QVariantMap& newState)
 {
+    // Whatever is still being converted is older than this
+    ++m_generation;
+    if (m_convertedState) {
+        g_variant_unref(m_convertedState);
+        m_convertedState = nullptr;
+    }
+    if (m_pendingState) {
+        g_variant_unref(m_pendingState);
+        m_pendingState = nullptr;
+    }
+
     QString oldTitle = title();
     QString oldLeftLabel = leftLabel();
     QString oldRightLabel = rightLabel();
@@ -229,3 +372,88 @@ void RootStateObject::setCurrentState(const QVariantMap& newState)
         if (oldIndicatorVisible != indicatorVisible()) Q_EMIT indicatorVisibleChanged();
     }
 }
+
+void RootStateObject::setCurrentStateAsync(GVariant* state)
+{
+    if (!state) {
+        setCurrentState(QVariantMap());
+        return;
+    }
+
+    // Indicators like battery and network resend the same state a lot
+    GVariant* latestState = m_pendingState ? m_pendingState : m_convertedState;
+    if (latestState && g_variant_equal(latestState, state)) {
+        g_variant_unref(state);
+        return;
+    }
+
+    if (m_conversion) {
+        // Only the latest state matters, convert it once this one's done
+        if (m_pendingState) g_variant_unref(m_pendingState);
+        m_pendingState = state;
+        return;
+    }
+
+    startConversion(state);
+}
+
+void RootStateObject::startConversion(GVariant* state)
+{
+    if (m_convertedState) g_variant_unref(m_convertedState);
+    m_convertedState = state;
+
+    m_conversion = new QFutureWatcher<RootStateChanges>(this);
+    connect(m_conversion, &QFutureWatcher<RootStateChanges>::finished, this, &RootStateObject::onStateConverted);
+    m_conversion->setFuture(QtConcurrent::run(conversionPool(), convertRootState,
+                                              g_variant_ref(state), m_currentState, m_generation));
+}
+
+void RootStateObject::onStateConverted()
+{
+    const RootStateChanges changes = m_conversion->result();
+    m_conversion->deleteLater();
+    m_conversion = nullptr;
+
+    // Otherwise the state was set directly in the meantime, and the changes are against an old one
+    if (changes.generation == m_generation) {
+        applyStateChanges(changes);
+    }
+
+    if (m_pendingState) {
+        GVariant* state = m_pendingState;
+        m_pendingState = nullptr;
+        startConversion(state);
+    }
+}
+
+void RootStateObject::applyStateChanges(const RootStateChanges& changes)
+{
+    if (changes.changed.isEmpty() && changes.removed.isEmpty()) {
+        return;
+    }
+
+    const bool wasValid = valid();
+    QString oldTitle = title();
+    QString oldLeftLabel = leftLabel();
+    QString oldRightLabel = rightLabel();
+    QStringList oldIcons = icons();
+    QString oldAccessibleName = accessibleName();
+    bool oldIndicatorVisible = indicatorVisible();
+
+    for (auto it = changes.changed.constBegin(); it != changes.changed.constEnd(); ++it) {
+        m_currentState.insert(it.key(), it.value());
+    }
+    Q_FOREACH(const QString& key, changes.removed) {
+        m_currentState.remove(key);
+    }
+    Q_EMIT updated();
+
+    // Only what changed, so bindings on the rest don't get re-evaluated
+    if (wasValid != valid()) Q_EMIT validChanged();
+    if (oldTitle != title()) Q_EMIT titleChanged();
+    if (oldLeftLabel != leftLabel()) Q_EMIT leftLabelChanged();
+    if (oldRightLabel != rightLabel()) Q_EMIT rightLabelChanged();
+    if (oldIcons != icons()) Q_EMIT iconsChanged();
+    if (oldAccessibleName != accessibleName()) Q_EMIT accessibleNameChanged();
+    if (oldIndicatorVisible != indicatorVisible()) Q_EMIT indicatorVisibleChanged();
+}
@@ -21,12 +21,44 @@
 
 #include <actionstateparser.h>
 
+#include <QStringList>
+#include <QVariantMap>
+
+template <typename T> class QFutureWatcher;
+
 class UNITYINDICATORS_EXPORT RootStateParser : public ActionStateParser
 {
 Q_OBJECT
 public:
     RootStateParser(QObject* parent = nullptr);
     virtual QVariant toQVariant(GVariant* state) const override;
+
+    // for tests use
+    static int iconCacheHits();
+};
+
+// Holds on to the state instead of converting it, so that can be done off the GUI thread.
+class UNITYINDICATORS_EXPORT DeferredRootStateParser : public ActionStateParser
+{
+Q_OBJECT
+public:
+    DeferredRootStateParser(QObject* parent = nullptr);
+    ~DeferredRootStateParser();
+
+    virtual QVariant toQVariant(GVariant* state) const override;
+
+    // The last state seen, or null. The caller gets the reference.
+    GVariant* takeState();
+
+private:
+    mutable GVariant* m_state;
+};
+
+struct RootStateChanges
+{
+    quint64 generation;
+    QVariantMap changed;
+    QStringList removed;
 };
 
 class UNITYINDICATORS_EXPORT RootStateObject : public QObject
@@ -42,6 +74,7 @@ class UNITYINDICATORS_EXPORT RootStateObject : public QObject
     Q_PROPERTY(bool indicatorVisible READ indicatorVisible NOTIFY indicatorVisibleChanged)
 public:
     RootStateObject(QObject* parent = 0);
+    ~RootStateObject();
 
     virtual bool valid() const = 0;
 
@@ -67,8 +100,22 @@ Q_SIGNALS:
     void indicatorVisibleChanged();
 
 protected:
+    // Converts state on a worker thread, then applies what changed. Takes the reference to state.
+    void setCurrentStateAsync(GVariant* state);
+
     RootStateParser m_parser;
     QVariantMap m_currentState;
+
+private:
+    void startConversion(GVariant* state);
+    void onStateConverted();
+    void applyStateChanges(const RootStateChanges& changes);
+
+    // Bumped whenever the state is set directly, so conversions still running get dropped
+    quint64 m_generation;
+    GVariant* m_convertedState;
+    GVariant* m_pendingState;
+    QFutureWatcher<RootStateChanges>* m_conversion;
 };
 
 #endif // ROOTSTATEPARSER_H
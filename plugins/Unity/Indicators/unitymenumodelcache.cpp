@@ -34,26 +34,30 @@ UnityMenuModelCache* UnityMenuModelCache::singleton()
 
 UnityMenuModelCache::UnityMenuModelCache(QObject* parent)
     : QObject(parent)
+    , m_capacity(30)
 {
 }
 
 QSharedPointer<UnityMenuModel> UnityMenuModelCache::model(const QByteArray& path)
 {
-    if (m_registry.contains(path))
-        return m_registry[path];
+    QSharedPointer<UnityMenuModel> menuModel = m_registry.value(path).toStrongRef();
+    if (menuModel) {
+        retain(path, menuModel);
+        return menuModel;
+    }
 
     UnityMenuModel* model = new UnityMenuModel;
     QQmlEngine::setObjectOwnership(model, QQmlEngine::CppOwnership);
 
-    QSharedPointer<UnityMenuModel> menuModel(model);
+    menuModel = QSharedPointer<UnityMenuModel>(model);
 
-    // Keep a shared pointer (rather than weak pointer which would cause the
-    // model to be deleted when all shared pointers we give out are deleted).
-    // We want to keep all models cached because when we switch indicator
-    // profiles, we will be switching paths often.  And we want to keep the
-    // old model around, ready to be used.  Otherwise the UI might momentarily
-    // wait as we populate the model from DBus yet again.
+    // Keep a shared pointer (rather than only a weak pointer which would cause
+    // the model to be deleted when all shared pointers we give out are deleted).
+    // When we switch indicator profiles, we will be switching paths often.  And
+    // we want to keep the old model around, ready to be used.  Otherwise the UI
+    // might momentarily wait as we populate the model from DBus yet again.
     m_registry[path] = menuModel;
+    retain(path, menuModel);
 
     menuModel->setMenuObjectPath(path);
     return menuModel;
@@ -61,5 +65,91 @@ QSharedPointer<UnityMenuModel> UnityMenuModelCache::model(const QByteArray& path
 
 bool UnityMenuModelCache::contains(const QByteArray& path)
 {
-    return m_registry.contains(path);
+    return !m_registry.value(path).isNull();
+}
+
+void UnityMenuModelCache::prefetch(const QByteArray& path, const QByteArray& busName, const QVariantMap& actions)
+{
+    if (path.isEmpty() || busName.isEmpty() || actions.isEmpty()) {
+        return;
+    }
+
+    QSharedPointer<UnityMenuModel> menuModel = model(path);
+    if (menuModel->busName() != busName) menuModel->setBusName(busName);
+    if (menuModel->actions() != actions) menuModel->setActions(actions);
+}
+
+void UnityMenuModelCache::pin(const QByteArray& path)
+{
+    ++m_pins[path];
+}
+
+void UnityMenuModelCache::unpin(const QByteArray& path)
+{
+    auto it = m_pins.find(path);
+    if (it == m_pins.end()) {
+        return;
+    }
+    if (--it.value() == 0) {
+        m_pins.erase(it);
+        evict(m_capacity);
+    }
+}
+
+int UnityMenuModelCache::capacity() const
+{
+    return m_capacity;
+}
+
+void UnityMenuModelCache::setCapacity(int capacity)
+{
+    m_capacity = qMax(0, capacity);
+    evict(m_capacity);
+}
+
+void UnityMenuModelCache::trim()
+{
+    evict(0);
+}
+
+void UnityMenuModelCache::retain(const QByteArray& path, const QSharedPointer<UnityMenuModel>& model)
+{
+    if (m_retained.contains(path)) {
+        m_recentlyUsed.removeOne(path);
+    } else {
+        m_retained.insert(path, model);
+    }
+    m_recentlyUsed.append(path);
+
+    evict(m_capacity);
+}
+
+void UnityMenuModelCache::evict(int keep)
+{
+    int unpinned = 0;
+    Q_FOREACH(const QByteArray& path, m_recentlyUsed) {
+        if (!m_pins.contains(path)) ++unpinned;
+    }
+
+    // Oldest first. Models still in use elsewhere live on, we just stop keeping them alive.
+    auto it = m_recentlyUsed.begin();
+    while (unpinned > keep && it != m_recentlyUsed.end()) {
+        if (m_pins.contains(*it)) {
+            ++it;
+            continue;
+        }
+        m_retained.remove(*it);
+        it = m_recentlyUsed.erase(it);
+        --unpinned;
+    }
+
+    // Forget about the models that went away
+    auto registryIt = m_registry.begin();
+    while (registryIt != m_registry.end()) {
+        if (registryIt.value().isNull()) {
+            registryIt = m_registry.erase(registryIt);
+        } else {
+            ++registryIt;
+        }
+    }
 }
@@ -24,11 +24,22 @@
 
 #include <QObject>
 #include <QHash>
+#include <QList>
 #include <QPointer>
 #include <QSharedPointer>
+#include <QVariantMap>
 
 class UnityMenuModel;
 
+/*
+ * Hands out the UnityMenuModels, one per menu object path.
+ *
+ * Models nobody uses anymore are kept around for a while, as they're likely
+ * to be asked for again when switching indicator profiles, and repopulating
+ * one from DBus makes the UI wait. Only the capacity() most recently asked
+ * for are kept though, the rest let go of along with their DBus subscriptions.
+ * Models for pinned paths are always kept.
+ */
 class UNITYINDICATORS_EXPORT UnityMenuModelCache : public QObject
 {
     Q_OBJECT
@@ -42,8 +53,31 @@ public:
     // for tests use
     Q_INVOKABLE virtual bool contains(const QByteArray& path);
 
+    // Sets up the model for path now, so it's populated by the time someone asks for it
+    void prefetch(const QByteArray& path, const QByteArray& busName, const QVariantMap& actions);
+
+    // Pins are counted, each pin() needs its unpin()
+    void pin(const QByteArray& path);
+    void unpin(const QByteArray& path);
+
+    int capacity() const;
+    void setCapacity(int capacity);
+
+    // Let go of all the models kept around that aren't pinned
+    void trim();
+
 protected:
-    QHash<QByteArray, QSharedPointer<UnityMenuModel>> m_registry;
+    void retain(const QByteArray& path, const QSharedPointer<UnityMenuModel>& model);
+    void evict(int keep);
+
+    // Every model alive, whether we or someone else keeps it so
+    QHash<QByteArray, QWeakPointer<UnityMenuModel>> m_registry;
+    // The models we keep alive, least recently asked for first
+    QHash<QByteArray, QSharedPointer<UnityMenuModel>> m_retained;
+    QList<QByteArray> m_recentlyUsed;
+    QHash<QByteArray, int> m_pins;
+    int m_capacity;
+
     static QPointer<UnityMenuModelCache> theCache;
 };
 
@@ -16,23 +16,199 @@
 
 #include "appdrawermodel.h"
 #include "ualwrapper.h"
+#include "usagetracker.h"
 
 #include <QDebug>
-#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
 
-AppDrawerModel::AppDrawerModel(QObject *parent):
-    AppDrawerModelInterface(parent)
+static const int snapshotVersion = 1;
+
+void AppDrawerLoader::abort()
+{
+    m_aborted.store(1);
+}
+
+void AppDrawerLoader::load()
 {
-    Q_FOREACH (const QString &appId, UalWrapper::installedApps()) {
+    const QStringList appIds = UalWrapper::installedApps();
+    QStringList validAppIds;
+    QList<App> batch;
+
+    Q_FOREACH (const QString &appId, appIds) {
+        if (m_aborted.load()) {
+            return;
+        }
+
         UalWrapper::AppInfo info = UalWrapper::getApplicationInfo(appId);
         if (!info.valid) {
             qWarning() << "Failed to get app info for app" << appId;
             continue;
         }
-        m_list.append(new LauncherItem(appId, info.name, info.icon, this));
-        m_list.last()->setKeywords(info.keywords);
+
+        App app;
+        app.appId = appId;
+        app.name = info.name;
+        app.icon = info.icon;
+        app.keywords = info.keywords;
+        batch.append(app);
+        validAppIds.append(appId);
+
+        if (batch.count() == BatchSize) {
+            Q_EMIT appsLoaded(batch);
+            batch.clear();
+        }
+    }
+
+    if (!batch.isEmpty()) {
+        Q_EMIT appsLoaded(batch);
+    }
+    Q_EMIT finished(validAppIds);
+}
+
+AppDrawerModel::AppDrawerModel(QObject *parent):
+    AppDrawerModelInterface(parent),
+    m_loader(new AppDrawerLoader)
+{
+    qRegisterMetaType<QList<AppDrawerLoader::App>>();
+
+    loadSnapshot();
+
+    m_loader->moveToThread(&m_loaderThread);
+    connect(&m_loaderThread, &QThread::finished, m_loader, &QObject::deleteLater);
+    connect(m_loader, &AppDrawerLoader::appsLoaded, this, &AppDrawerModel::onAppsLoaded);
+    connect(m_loader, &AppDrawerLoader::finished, this, &AppDrawerModel::onLoadingFinished);
+    m_loaderThread.start(QThread::LowPriority);
+    QMetaObject::invokeMethod(m_loader, "load", Qt::QueuedConnection);
+
+    connect(UsageTracker::instance(), &UsageTracker::usageChanged, this, &AppDrawerModel::onUsageChanged);
+}
+
+AppDrawerModel::~AppDrawerModel()
+{
+    m_loader->abort();
+    m_loaderThread.quit();
+    m_loaderThread.wait();
+}
+
+QString AppDrawerModel::snapshotPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/unity8/appdrawer.json");
+}
+
+void AppDrawerModel::loadSnapshot()
+{
+    QFile file(snapshotPath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    // A snapshot of another version is silently ignored and left on disk,
+    // saveSnapshot() replaces it once the loader is done.
+    const QJsonObject snapshot = QJsonDocument::fromJson(file.readAll()).object();
+    if (snapshot.value(QStringLiteral("version")).toInt() != snapshotVersion) {
+        return;
+    }
+
+    Q_FOREACH (const QJsonValue &value, snapshot.value(QStringLiteral("apps")).toArray()) {
+        const QJsonObject app = value.toObject();
+        const QString appId = app.value(QStringLiteral("appId")).toString();
+        if (appId.isEmpty() || m_items.contains(appId)) {
+            continue;
+        }
+
+        LauncherItem *item = new LauncherItem(appId, app.value(QStringLiteral("name")).toString(),
+                                              app.value(QStringLiteral("icon")).toString(), this);
+        QStringList keywords;
+        Q_FOREACH (const QJsonValue &keyword, app.value(QStringLiteral("keywords")).toArray()) {
+            keywords.append(keyword.toString());
+        }
+        item->setKeywords(keywords);
+        m_list.append(item);
+        m_items.insert(appId, item);
+    }
+}
+
+void AppDrawerModel::saveSnapshot() const
+{
+    QJsonArray apps;
+    Q_FOREACH (LauncherItem *item, m_list) {
+        QJsonObject app;
+        app.insert(QStringLiteral("appId"), item->appId());
+        app.insert(QStringLiteral("name"), item->name());
+        app.insert(QStringLiteral("icon"), item->icon());
+        app.insert(QStringLiteral("keywords"), QJsonArray::fromStringList(item->keywords()));
+        apps.append(app);
+    }
+
+    QJsonObject snapshot;
+    snapshot.insert(QStringLiteral("version"), snapshotVersion);
+    snapshot.insert(QStringLiteral("apps"), apps);
+
+    QDir().mkpath(QFileInfo(snapshotPath()).absolutePath());
+    QSaveFile file(snapshotPath());
+    if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(snapshot).toJson(QJsonDocument::Compact)) < 0 || !file.commit()) {
+        qWarning() << "Failed to write app drawer snapshot" << snapshotPath() << file.errorString();
+    }
+}
+
+void AppDrawerModel::onAppsLoaded(const QList<AppDrawerLoader::App> &apps)
+{
+    QList<LauncherItem*> newItems;
+
+    Q_FOREACH (const AppDrawerLoader::App &app, apps) {
+        LauncherItem *item = m_items.value(app.appId);
+        if (!item) {
+            item = new LauncherItem(app.appId, app.name, app.icon, this);
+            item->setKeywords(app.keywords);
+            m_items.insert(app.appId, item);
+            newItems.append(item);
+        } else if (item->name() != app.name || item->icon() != app.icon || item->keywords() != app.keywords) {
+            item->setName(app.name);
+            item->setIcon(app.icon);
+            item->setKeywords(app.keywords);
+            const QModelIndex changed = index(m_list.indexOf(item));
+            Q_EMIT dataChanged(changed, changed);
+        }
+    }
+
+    if (!newItems.isEmpty()) {
+        beginInsertRows(QModelIndex(), m_list.count(), m_list.count() + newItems.count() - 1);
+        m_list.append(newItems);
+        endInsertRows();
+    }
+}
+
+void AppDrawerModel::onLoadingFinished(const QStringList &appIds)
+{
+    const QSet<QString> installed = appIds.toSet();
+
+    for (int i = m_list.count() - 1; i >= 0; --i) {
+        if (!installed.contains(m_list.at(i)->appId())) {
+            beginRemoveRows(QModelIndex(), i, i);
+            LauncherItem *item = m_list.takeAt(i);
+            m_items.remove(item->appId());
+            endRemoveRows();
+            item->deleteLater();
+        }
+    }
+
+    saveSnapshot();
+}
+
+void AppDrawerModel::onUsageChanged(const QString &appId)
+{
+    LauncherItem *item = m_items.value(appId);
+    if (item) {
+        const QModelIndex changed = index(m_list.indexOf(item));
+        Q_EMIT dataChanged(changed, changed, {RoleUsage});
     }
-    qsrand(QDateTime::currentMSecsSinceEpoch() / 100);
 }
 
 int AppDrawerModel::rowCount(const QModelIndex &parent) const
@@ -53,9 +229,7 @@ QVariant AppDrawerModel::data(const QModelIndex &index, int role) const
     case RoleKeywords:
         return m_list.at(index.row())->keywords();
     case RoleUsage:
-        // FIXME: u-a-l needs to provide API for usage stats.
-        // don't forget to drop the qsrand() call in the ctor when dropping this.
-        return qrand();
+        return UsageTracker::instance()->usage(m_list.at(index.row())->appId());
     }
 
     return QVariant();
@@ -17,17 +17,76 @@
 
 #include <unity/shell/launcher/AppDrawerModelInterface.h>
 
+#include <QAtomicInt>
+#include <QHash>
+#include <QThread>
+
 #include "launcheritem.h"
 
+// Asks ubuntu-app-launch about the installed apps, in a thread of its own
+class AppDrawerLoader: public QObject
+{
+    Q_OBJECT
+public:
+    struct App {
+        QString appId;
+        QString name;
+        QString icon;
+        QStringList keywords;
+    };
+
+    // Number of apps per appsLoaded()
+    static const int BatchSize = 20;
+
+    // Thread safe
+    void abort();
+
+public Q_SLOTS:
+    void load();
+
+Q_SIGNALS:
+    void appsLoaded(const QList<AppDrawerLoader::App> &apps);
+    void finished(const QStringList &appIds);
+
+private:
+    QAtomicInt m_aborted;
+};
+
+Q_DECLARE_METATYPE(QList<AppDrawerLoader::App>)
+
+/*
+ * The installed apps.
+ *
+ * The apps of the previous session are read from a snapshot right away,
+ * while AppDrawerLoader goes through the installed apps in the background.
+ * The apps it finds are added or updated as they come, and the ones that
+ * are gone are removed once it's done.
+ */
 class AppDrawerModel: public AppDrawerModelInterface
 {
     Q_OBJECT
 public:
     AppDrawerModel(QObject* parent = nullptr);
+    ~AppDrawerModel();
 
     int rowCount(const QModelIndex &parent) const override;
     QVariant data(const QModelIndex &index, int role) const override;
 
+private Q_SLOTS:
+    void onAppsLoaded(const QList<AppDrawerLoader::App> &apps);
+    void onLoadingFinished(const QStringList &appIds);
+    void onUsageChanged(const QString &appId);
+
 private:
+    static QString snapshotPath();
+    void loadSnapshot();
+    void saveSnapshot() const;
+
     QList<LauncherItem*> m_list;
+    QHash<QString, LauncherItem*> m_items;
+
+    AppDrawerLoader *m_loader;
+    QThread m_loaderThread;
+
+    friend class AppDrawerModelTest;
 };
@@ -20,6 +20,8 @@
 
 #include <glib.h>
 
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <QDebug>
 
 ASAdapter::ASAdapter()
@@ -30,26 +32,89 @@ ASAdapter::ASAdapter()
 
     if (m_user.isEmpty()) {
         qWarning() << "username not valid. Account Service integration will not work.";
+    } else {
+        // Look the user up now, so our first sync doesn't have to wait for it
+        m_accounts->prefetchUser(m_user);
     }
+
+    m_structuralTimer.setSingleShot(true);
+    m_structuralTimer.setInterval(StructuralDelay);
+    QObject::connect(&m_structuralTimer, &QTimer::timeout, [this]() { flush(); });
+
+    m_progressTimer.setSingleShot(true);
+    m_progressTimer.setInterval(ProgressInterval);
+    QObject::connect(&m_progressTimer, &QTimer::timeout, [this]() { flush(); });
 }
 
 ASAdapter::~ASAdapter()
 {
+    flush();
     m_accounts->deleteLater();
 }
 
 void ASAdapter::syncItems(const QList<LauncherItem*> &list)
 {
+    setPending(list);
+
+    // Not restarted, so that a steady stream of changes still gets through
+    if (!m_structuralTimer.isActive()) {
+        m_structuralTimer.start();
+    }
+}
+
+void ASAdapter::syncProgress(const QList<LauncherItem*> &list)
+{
+    setPending(list);
+
+    if (!m_structuralTimer.isActive() && !m_progressTimer.isActive()) {
+        m_progressTimer.start();
+    }
+}
+
+void ASAdapter::setPending(const QList<LauncherItem*> &list)
+{
+    // Only remember which items to send, their details are taken in flush()
+    m_pendingItems.clear();
+    m_pendingItems.reserve(list.count());
+    Q_FOREACH(LauncherItem *item, list) {
+        m_pendingItems << item;
+    }
+    m_dirty = true;
+}
+
+void ASAdapter::flush()
+{
+    m_structuralTimer.stop();
+    m_progressTimer.stop();
+
+    if (!m_dirty) {
+        return;
+    }
+    m_dirty = false;
+
     if (m_accounts && !m_user.isEmpty()) {
         QList<QVariantMap> items;
-        items.reserve(list.count());
-
-        Q_FOREACH(LauncherItem *item, list) {
-            items << itemToVariant(item);
+        items.reserve(m_pendingItems.count());
+        Q_FOREACH(LauncherItem *item, m_pendingItems) {
+            if (item) {
+                items << itemToVariant(item);
+            }
         }
 
-        m_accounts->setUserPropertyAsync(m_user, QStringLiteral("com.canonical.unity.AccountsService"), QStringLiteral("LauncherItems"), QVariant::fromValue(items));
+        QByteArray payload;
+        QDataStream stream(&payload, QIODevice::WriteOnly);
+        stream << items;
+        const QByteArray hash = QCryptographicHash::hash(payload, QCryptographicHash::Sha1);
+        if (hash != m_sentHash) {
+            m_sentHash = hash;
+            AccountsServiceDBusAdaptor *accounts = m_accounts;
+            const QString user = m_user;
+            m_accounts->whenUserFound(user, m_accounts, [accounts, user, items]() {
+                accounts->setUserPropertyAsync(user, QStringLiteral("com.canonical.unity.AccountsService"), QStringLiteral("LauncherItems"), QVariant::fromValue(items));
+            });
+        }
     }
+    m_pendingItems.clear();
 }
 
 QVariantMap ASAdapter::itemToVariant(LauncherItem *item) const
@@ -17,11 +17,24 @@
 #ifndef ASADAPTER_H
 #define ASADAPTER_H
 
+#include <QByteArray>
+#include <QPointer>
+#include <QTimer>
 #include <QVariantMap>
 
 class LauncherItem;
 class AccountsServiceDBusAdaptor;
 
+/*
+ * Keeps the LauncherItems property of AccountsService in sync with the launcher.
+ *
+ * Syncs are not sent right away: structural changes (items added, removed,
+ * moved, pinned...) are sent after StructuralDelay, so that a burst of them
+ * ends up in a single write, while count and progress updates are sent at
+ * most once every ProgressInterval. Either way the latest list is sent, and
+ * only if it differs from the one sent last. The items are only looked at
+ * when sending, so updates in between just mark the list as dirty.
+ */
 class ASAdapter
 {
 public:
@@ -31,15 +44,31 @@ public:
     ASAdapter(const ASAdapter&) = delete;
     ASAdapter& operator=(const ASAdapter&) = delete;
 
+    static const int StructuralDelay = 100;
+    static const int ProgressInterval = 1000;
+
     void syncItems(const QList<LauncherItem*> &list);
+    void syncProgress(const QList<LauncherItem*> &list);
+
+    // Sends what's pending now
+    void flush();
 
 private:
     QVariantMap itemToVariant(LauncherItem *item) const;
+    void setPending(const QList<LauncherItem*> &list);
 
 private:
     AccountsServiceDBusAdaptor *m_accounts;
     QString m_user;
 
+    // Guarded, the items may be gone by the time we send them
+    QList<QPointer<LauncherItem>> m_pendingItems;
+    bool m_dirty = false;
+    QByteArray m_sentHash;
+
+    QTimer m_structuralTimer;
+    QTimer m_progressTimer;
+
     friend class LauncherModelTest;
 };
 
@@ -20,6 +20,7 @@
 #include "dbusinterface.h"
 #include "asadapter.h"
 #include "ualwrapper.h"
+#include "usagetracker.h"
 
 #include <unity/shell/application/ApplicationInfoInterface.h>
 #include <unity/shell/application/MirSurfaceListInterface.h>
@@ -27,6 +28,9 @@
 
 #include <QDesktopServices>
 #include <QDebug>
+#include <QSet>
+
+#include <algorithm>
 
 using namespace unity::shell::application;
 
@@ -120,14 +124,7 @@ void LauncherModel::move(int oldIndex, int newIndex)
         return;
     }
 
-    // QList's and QAbstractItemModel's move implementation differ when moving an item up the list :/
-    // While QList needs the index in the resulting list, beginMoveRows expects it to be in the current list
-    // adjust the model's index by +1 in case we're moving upwards
-    int newModelIndex = newIndex > oldIndex ? newIndex+1 : newIndex;
-
-    beginMoveRows(QModelIndex(), oldIndex, oldIndex, QModelIndex(), newModelIndex);
-    m_list.move(oldIndex, newIndex);
-    endMoveRows();
+    moveItem(oldIndex, newIndex);
 
     if (!m_list.at(newIndex)->pinned()) {
         pin(m_list.at(newIndex)->appId());
@@ -161,14 +158,12 @@ void LauncherModel::pin(const QString &appId, int index)
             return;
         }
 
-        beginInsertRows(QModelIndex(), index, index);
         LauncherItem *item = new LauncherItem(appId,
                                               appInfo.name,
                                               appInfo.icon,
                                               this);
         item->setPinned(true);
-        m_list.insert(index, item);
-        endInsertRows();
+        insertItem(index, item);
     }
 
     storeAppList();
@@ -263,20 +258,12 @@ void LauncherModel::setApplicationManager(unity::shell::application::Application
         disconnect(this, &LauncherModel::focusedAppIdChanged, 0, nullptr);
 
         // remove any recent/running apps from the launcher
-        QList<int> recentAppIndices;
-        for (int i = 0; i < m_list.count(); ++i) {
+        for (int i = m_list.count() - 1; i >= 0; --i) {
             if (m_list.at(i)->recent()) {
-                recentAppIndices << i;
+                removeItem(i);
             }
         }
-        int run = 0;
-        while (recentAppIndices.count() > 0) {
-            beginRemoveRows(QModelIndex(), recentAppIndices.first() - run, recentAppIndices.first() - run);
-            m_list.takeAt(recentAppIndices.first() - run)->deleteLater();
-            endRemoveRows();
-            recentAppIndices.takeFirst();
-            ++run;
-        }
+        m_focusedAppId.clear();
     }
 
     m_appManager = appManager;
@@ -327,21 +314,52 @@ void LauncherModel::unpin(const QString &appId)
             Q_EMIT dataChanged(modelIndex, modelIndex, {RolePinned});
         }
     } else {
-        beginRemoveRows(QModelIndex(), index, index);
-        m_list.takeAt(index)->deleteLater();
-        endRemoveRows();
+        removeItem(index);
     }
 }
 
-int LauncherModel::findApplication(const QString &appId)
+void LauncherModel::insertItem(int index, LauncherItem *item)
 {
-    for (int i = 0; i < m_list.count(); ++i) {
-        LauncherItem *item = m_list.at(i);
-        if (item->appId() == appId) {
-            return i;
-        }
+    beginInsertRows(QModelIndex(), index, index);
+    m_list.insert(index, item);
+    updateRows(index);
+    endInsertRows();
+}
+
+void LauncherModel::removeItem(int index)
+{
+    beginRemoveRows(QModelIndex(), index, index);
+    LauncherItem *item = m_list.takeAt(index);
+    m_rows.remove(item->appId());
+    updateRows(index);
+    endRemoveRows();
+    item->deleteLater();
+}
+
+void LauncherModel::moveItem(int from, int to)
+{
+    // QList's and QAbstractItemModel's move implementation differ when moving an item up the list :/
+    // While QList needs the index in the resulting list, beginMoveRows expects it to be in the current list
+    // adjust the model's index by +1 in case we're moving upwards
+    beginMoveRows(QModelIndex(), from, from, QModelIndex(), to > from ? to + 1 : to);
+    m_list.move(from, to);
+    updateRows(qMin(from, to), qMax(from, to));
+    endMoveRows();
+}
+
+void LauncherModel::updateRows(int from, int to)
+{
+    if (to < 0 || to >= m_list.count()) {
+        to = m_list.count() - 1;
+    }
+    for (int i = from; i <= to; ++i) {
+        m_rows[m_list.at(i)->appId()] = i;
     }
-    return -1;
+}
+
+int LauncherModel::findApplication(const QString &appId)
+{
+    return m_rows.value(appId, -1);
 }
 
 void LauncherModel::progressChanged(const QString &appId, int progress)
@@ -350,6 +368,7 @@ void LauncherModel::progressChanged(const QString &appId, int progress)
     if (idx >= 0) {
         LauncherItem *item = m_list.at(idx);
         item->setProgress(progress);
+        m_asAdapter->syncProgress(m_list);
         Q_EMIT dataChanged(index(idx), index(idx), {RoleProgress});
     }
 }
@@ -365,7 +384,7 @@ void LauncherModel::countChanged(const QString &appId, int count)
             changedRoles << RoleAlerting;
             item->setAlerting(true);
         }
-        m_asAdapter->syncItems(m_list);
+        m_asAdapter->syncProgress(m_list);
         Q_EMIT dataChanged(index(idx), index(idx), changedRoles);
     }
 }
@@ -385,9 +404,7 @@ void LauncherModel::countVisibleChanged(const QString &appId, bool countVisible)
 
         // If countVisible goes to false, and the item is neither pinned nor recent we can drop it
         if (!countVisible && !item->pinned() && !item->recent()) {
-            beginRemoveRows(QModelIndex(), idx, idx);
-            m_list.takeAt(idx)->deleteLater();
-            endRemoveRows();
+            removeItem(idx);
         }
     } else {
         // Need to create a new LauncherItem and show the highlight
@@ -398,9 +415,7 @@ void LauncherModel::countVisibleChanged(const QString &appId, bool countVisible)
                                                   appInfo.icon,
                                                   this);
             item->setCountVisible(true);
-            beginInsertRows(QModelIndex(), m_list.count(), m_list.count());
-            m_list.append(item);
-            endInsertRows();
+            insertItem(m_list.count(), item);
         }
     }
     m_asAdapter->syncItems(m_list);
@@ -408,87 +423,121 @@ void LauncherModel::countVisibleChanged(const QString &appId, bool countVisible)
 
 void LauncherModel::refresh()
 {
+    const QStringList storedApplications = m_settings->storedApplications();
+    const QSet<QString> stored = storedApplications.toSet();
+
     // First walk through all the existing items and see if we need to remove something
-    QList<LauncherItem*> toBeRemoved;
-    Q_FOREACH (LauncherItem* item, m_list) {
+    QStringList toBeRemoved;
+    for (int idx = 0; idx < m_list.count(); ++idx) {
+        LauncherItem *item = m_list.at(idx);
         UalWrapper::AppInfo appInfo = UalWrapper::getApplicationInfo(item->appId());
         if (!appInfo.valid) {
             // Application no longer available => drop it!
-            toBeRemoved << item;
-        } else if (!m_settings->storedApplications().contains(item->appId())) {
+            toBeRemoved << item->appId();
+        } else if (!stored.contains(item->appId())) {
             // Item not in settings any more => drop it!
-            toBeRemoved << item;
+            toBeRemoved << item->appId();
         } else {
-            int idx = m_list.indexOf(item);
             item->setName(appInfo.name);
             item->setPinned(item->pinned()); // update pinned text if needed
             item->setRunning(item->running());
-            Q_EMIT dataChanged(index(idx), index(idx), {RoleName, RoleRunning});
 
-            const QString oldIcon = item->icon();
-            if (oldIcon == appInfo.icon) { // same icon file, perhaps different contents, simulate changing the icon name to force reload
+            if (item->icon() == appInfo.icon) { // same icon file, perhaps different contents, simulate changing the icon name to force reload
                 item->setIcon(QString());
                 Q_EMIT dataChanged(index(idx), index(idx), {RoleIcon});
             }
 
             // now set the icon for real
             item->setIcon(appInfo.icon);
-            Q_EMIT dataChanged(index(idx), index(idx), {RoleIcon});
+            Q_EMIT dataChanged(index(idx), index(idx), {RoleName, RoleRunning, RoleIcon});
         }
     }
 
-    Q_FOREACH (LauncherItem* item, toBeRemoved) {
-        unpin(item->appId());
+    Q_FOREACH (const QString &appId, toBeRemoved) {
+        unpin(appId);
     }
 
     bool changed = toBeRemoved.count() > 0;
 
-    // This brings the Launcher into sync with the settings backend again. There's an issue though:
-    // If we can't find a .desktop file for an entry we need to skip it. That makes our settingsIndex
-    // go out of sync with the actual index of items. So let's also use an addedIndex which reflects
-    // the settingsIndex minus the skipped items.
-    int addedIndex = 0;
-
-    // Now walk through settings and see if we need to add something
-    for (int settingsIndex = 0; settingsIndex < m_settings->storedApplications().count(); ++settingsIndex) {
-        const QString entry = m_settings->storedApplications().at(settingsIndex);
-        int itemIndex = -1;
-        for (int i = 0; i < m_list.count(); ++i) {
-            if (m_list.at(i)->appId() == entry) {
-                itemIndex = i;
-                break;
-            }
+    // This brings the Launcher into sync with the settings backend again: the stored apps come
+    // first, in the order of the settings, followed by the remaining items in their current order.
+    // If we can't find a .desktop file for a new entry we need to skip it.
+    QList<LauncherItem*> target;
+    QSet<QString> seen;
+    Q_FOREACH (const QString &entry, storedApplications) {
+        if (seen.contains(entry)) {
+            continue;
         }
+        seen.insert(entry);
 
-        if (itemIndex == -1) {
-            // Need to add it. Just add it into the addedIndex to keep same ordering as the list
-            // in the settings.
-            UalWrapper::AppInfo appInfo = UalWrapper::getApplicationInfo(entry);
-            if (!appInfo.valid) {
-                continue;
-            }
+        const int itemIndex = findApplication(entry);
+        if (itemIndex >= 0) {
+            target << m_list.at(itemIndex);
+            continue;
+        }
 
-            LauncherItem *item = new LauncherItem(entry,
-                                                  appInfo.name,
-                                                  appInfo.icon,
-                                                  this);
-            item->setPinned(true);
-            beginInsertRows(QModelIndex(), addedIndex, addedIndex);
-            m_list.insert(addedIndex, item);
-            endInsertRows();
-            changed = true;
-        } else if (itemIndex != addedIndex) {
-            // The item is already there, but it is in a different place than in the settings.
-            // Move it to the addedIndex
-            beginMoveRows(QModelIndex(), itemIndex, itemIndex, QModelIndex(), addedIndex);
-            m_list.move(itemIndex, addedIndex);
-            endMoveRows();
-            changed = true;
+        UalWrapper::AppInfo appInfo = UalWrapper::getApplicationInfo(entry);
+        if (!appInfo.valid) {
+            continue;
         }
 
-        // Just like settingsIndex, this will increase with every item, except the ones we
-        // skipped with the "continue" call above.
-        addedIndex++;
+        LauncherItem *item = new LauncherItem(entry,
+                                              appInfo.name,
+                                              appInfo.icon,
+                                              this);
+        item->setPinned(true);
+        target << item;
+    }
+    Q_FOREACH (LauncherItem *item, m_list) {
+        if (!seen.contains(item->appId())) {
+            target << item;
+        }
+    }
+
+    // The items that are already in the right order relative to each other (the longest
+    // increasing run of their current rows) stay where they are, everything else gets moved
+    // or inserted right after the item preceding it in the target order. That's the fewest
+    // moves that get us there.
+    QVector<int> tails;         // target index of the last item of the best run of each length
+    QVector<int> previous(target.count(), -1);
+    for (int i = 0; i < target.count(); ++i) {
+        const int row = findApplication(target.at(i)->appId());
+        if (row < 0) {
+            continue;
+        }
+        auto it = std::lower_bound(tails.begin(), tails.end(), row, [this, &target](int t, int r) {
+            return findApplication(target.at(t)->appId()) < r;
+        });
+        if (it != tails.begin()) {
+            previous[i] = *(it - 1);
+        }
+        if (it == tails.end()) {
+            tails.append(i);
+        } else {
+            *it = i;
+        }
+    }
+    QSet<LauncherItem*> inPlace;
+    for (int i = tails.isEmpty() ? -1 : tails.last(); i >= 0; i = previous.at(i)) {
+        inPlace.insert(target.at(i));
+    }
+
+    for (int i = 0; i < target.count(); ++i) {
+        LauncherItem *item = target.at(i);
+        if (inPlace.contains(item)) {
+            continue;
+        }
+
+        const int row = findApplication(item->appId());
+        const int after = i == 0 ? -1 : findApplication(target.at(i - 1)->appId());
+        if (row < 0) {
+            insertItem(after + 1, item);
+        } else if (row != after + 1) {
+            moveItem(row, row < after ? after : after + 1);
+        } else {
+            continue;
+        }
+        changed = true;
     }
 
     if (changed) {
@@ -525,6 +574,8 @@ void LauncherModel::applicationAdded(const QModelIndex &parent, int row)
         return;
     }
 
+    UsageTracker::instance()->recordUse(app->appId());
+
     const int itemIndex = findApplication(app->appId());
     if (itemIndex != -1) {
         LauncherItem *item = m_list.at(itemIndex);
@@ -538,9 +589,10 @@ void LauncherModel::applicationAdded(const QModelIndex &parent, int row)
         item->setRecent(true);
         item->setRunning(true);
         item->setFocused(app->focused());
-        beginInsertRows(QModelIndex(), m_list.count(), m_list.count());
-        m_list.append(item);
-        endInsertRows();
+        insertItem(m_list.count(), item);
+    }
+    if (app->focused()) {
+        m_focusedAppId = app->appId();
     }
     connect(app, &ApplicationInfoInterface::surfaceCountChanged, this, &LauncherModel::updateSurfaceList);
     m_asAdapter->syncItems(m_list);
@@ -594,14 +646,7 @@ void LauncherModel::applicationRemoved(const QModelIndex &parent, int row)
     Q_UNUSED(parent)
 
     ApplicationInfoInterface *app = m_appManager->get(row);
-    int appIndex = -1;
-    for (int i = 0; i < m_list.count(); ++i) {
-        if (m_list.at(i)->appId() == app->appId()) {
-            appIndex = i;
-            break;
-        }
-    }
-
+    const int appIndex = findApplication(app->appId());
     if (appIndex < 0) {
         qWarning() << Q_FUNC_INFO << "appIndex not found";
         return;
@@ -612,9 +657,7 @@ void LauncherModel::applicationRemoved(const QModelIndex &parent, int row)
     LauncherItem * item = m_list.at(appIndex);
 
     if (!item->pinned()) {
-        beginRemoveRows(QModelIndex(), appIndex, appIndex);
-        m_list.takeAt(appIndex)->deleteLater();
-        endRemoveRows();
+        removeItem(appIndex);
         m_asAdapter->syncItems(m_list);
     } else {
         QVector<int> changedRoles = {RoleRunning};
@@ -630,20 +673,25 @@ void LauncherModel::applicationRemoved(const QModelIndex &parent, int row)
 void LauncherModel::focusedAppIdChanged()
 {
     const QString appId = m_appManager->focusedApplicationId();
-    for (int i = 0; i < m_list.count(); ++i) {
-        LauncherItem *item = m_list.at(i);
-        if (!item->focused() && item->appId() == appId) {
-            QVector<int> changedRoles;
-            changedRoles << RoleFocused;
-            item->setFocused(true);
-            if (item->alerting()) {
-                changedRoles << RoleAlerting;
-                item->setAlerting(false);
-            }
-            Q_EMIT dataChanged(index(i), index(i), changedRoles);
-        } else if (item->focused() && item->appId() != appId) {
-            item->setFocused(false);
-            Q_EMIT dataChanged(index(i), index(i), {RoleFocused});
+
+    const int oldIndex = findApplication(m_focusedAppId);
+    if (oldIndex >= 0 && m_focusedAppId != appId && m_list.at(oldIndex)->focused()) {
+        m_list.at(oldIndex)->setFocused(false);
+        Q_EMIT dataChanged(index(oldIndex), index(oldIndex), {RoleFocused});
+    }
+    m_focusedAppId = appId;
+
+    const int newIndex = findApplication(appId);
+    if (newIndex >= 0 && !m_list.at(newIndex)->focused()) {
+        LauncherItem *item = m_list.at(newIndex);
+        QVector<int> changedRoles;
+        changedRoles << RoleFocused;
+        item->setFocused(true);
+        UsageTracker::instance()->recordUse(appId);
+        if (item->alerting()) {
+            changedRoles << RoleAlerting;
+            item->setAlerting(false);
         }
+        Q_EMIT dataChanged(index(newIndex), index(newIndex), changedRoles);
     }
 }
@@ -21,6 +21,7 @@
 #include <unity/shell/application/ApplicationManagerInterface.h>
 
 #include <QAbstractListModel>
+#include <QHash>
 
 class LauncherItem;
 class GSettings;
@@ -67,6 +68,12 @@ private:
 
     void unpin(const QString &appId);
 
+    // All changes to m_list go through these, so that m_rows stays in sync
+    void insertItem(int index, LauncherItem *item);
+    void removeItem(int index);
+    void moveItem(int from, int to);
+    void updateRows(int from, int to = -1);
+
 private Q_SLOTS:
     void countChanged(const QString &appId, int count);
     void countVisibleChanged(const QString &appId, bool count);
@@ -82,6 +89,11 @@ private Q_SLOTS:
 private:
     QList<LauncherItem*> m_list;
 
+    // Row of each item in m_list, by appId
+    QHash<QString, int> m_rows;
+
+    QString m_focusedAppId;
+
     GSettings *m_settings;
     DBusInterface *m_dbusIface;
     ASAdapter *m_asAdapter;
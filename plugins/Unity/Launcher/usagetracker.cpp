@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "usagetracker.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <cmath>
+
+static const int snapshotVersion = 1;
+
+// Scores this small are forgotten when loading
+static const double minimumScore = 0.01;
+
+UsageTracker::UsageTracker(const QString &directory, QObject *parent)
+    : QObject(parent)
+    , m_directory(directory)
+    , m_log(directory + QStringLiteral("/usage.log"))
+{
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(FlushDelay);
+    connect(&m_flushTimer, &QTimer::timeout, this, [this]() { m_log.flush(); });
+
+    load();
+}
+
+UsageTracker::~UsageTracker()
+{
+    m_log.close();
+}
+
+UsageTracker *UsageTracker::instance()
+{
+    static UsageTracker *tracker = new UsageTracker(
+        QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/unity8"),
+        QCoreApplication::instance());
+    return tracker;
+}
+
+void UsageTracker::recordUse(const QString &appId)
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    addUse(appId, now);
+
+    if (m_log.isOpen()) {
+        m_log.write(QString(QStringLiteral("%1\t%2\n")).arg(now).arg(appId).toUtf8());
+        if (++m_logCount >= CompactThreshold) {
+            compact();
+        } else if (!m_flushTimer.isActive()) {
+            m_flushTimer.start();
+        }
+    }
+
+    const double score = m_scores.value(appId);
+    const double published = m_published.value(appId);
+    if (std::abs(score - published) > published * ChangeThreshold) {
+        m_published[appId] = score;
+        Q_EMIT usageChanged(appId);
+    }
+}
+
+double UsageTracker::usage(const QString &appId) const
+{
+    return m_published.value(appId);
+}
+
+void UsageTracker::addUse(const QString &appId, qint64 timestamp)
+{
+    m_scores[appId] += std::exp2(double(timestamp - m_base) / HalfLife);
+}
+
+void UsageTracker::load()
+{
+    m_base = QDateTime::currentMSecsSinceEpoch();
+
+    QFile snapshotFile(m_directory + QStringLiteral("/usage.json"));
+    if (snapshotFile.open(QIODevice::ReadOnly)) {
+        const QJsonObject snapshot = QJsonDocument::fromJson(snapshotFile.readAll()).object();
+        if (snapshot.value(QStringLiteral("version")).toInt() == snapshotVersion) {
+            // Bring the scores of the snapshot to our base
+            const qint64 base = snapshot.value(QStringLiteral("base")).toDouble();
+            const double factor = std::exp2(double(base - m_base) / HalfLife);
+            const QJsonObject scores = snapshot.value(QStringLiteral("scores")).toObject();
+            for (auto it = scores.constBegin(); it != scores.constEnd(); ++it) {
+                m_scores.insert(it.key(), it.value().toDouble() * factor);
+            }
+        }
+    }
+
+    if (m_log.open(QIODevice::ReadOnly)) {
+        while (!m_log.atEnd()) {
+            const QList<QByteArray> fields = m_log.readLine().trimmed().split('\t');
+            bool ok = false;
+            const qint64 timestamp = fields.first().toLongLong(&ok);
+            if (ok && fields.count() == 2) {
+                addUse(QString::fromUtf8(fields.last()), timestamp);
+            }
+        }
+        m_log.close();
+    }
+
+    for (auto it = m_scores.begin(); it != m_scores.end();) {
+        if (it.value() < minimumScore) {
+            it = m_scores.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_published = m_scores;
+
+    compact();
+}
+
+void UsageTracker::compact()
+{
+    QJsonObject scores;
+    for (auto it = m_scores.constBegin(); it != m_scores.constEnd(); ++it) {
+        scores.insert(it.key(), it.value());
+    }
+
+    QJsonObject snapshot;
+    snapshot.insert(QStringLiteral("version"), snapshotVersion);
+    snapshot.insert(QStringLiteral("base"), double(m_base));
+    snapshot.insert(QStringLiteral("scores"), scores);
+
+    QDir().mkpath(m_directory);
+    QSaveFile snapshotFile(m_directory + QStringLiteral("/usage.json"));
+    if (!snapshotFile.open(QIODevice::WriteOnly)
+            || snapshotFile.write(QJsonDocument(snapshot).toJson(QJsonDocument::Compact)) < 0
+            || !snapshotFile.commit()) {
+        // Keep appending to the log we have, it still has all the uses
+        qWarning() << "UsageTracker: failed to write" << snapshotFile.fileName() << snapshotFile.errorString();
+        if (!m_log.isOpen() && !m_log.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            qWarning() << "UsageTracker: failed to open" << m_log.fileName() << m_log.errorString();
+        }
+        m_logCount = 0;
+        return;
+    }
+
+    m_flushTimer.stop();
+    m_log.close();
+    if (!m_log.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "UsageTracker: failed to open" << m_log.fileName() << m_log.errorString();
+    }
+    m_logCount = 0;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QFile>
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+
+/*
+ * How much each app gets used, as told by the LauncherModel.
+ *
+ * Every launch or focus of an app adds to its score, and older uses count
+ * less and less: the weight of a use halves every HalfLife. Scores are kept
+ * relative to the time they were loaded at, so they don't need to be
+ * updated as time goes by.
+ *
+ * Uses are appended to a log in $XDG_CACHE_HOME/unity8/, which is folded
+ * into a snapshot of the scores when loading and every CompactThreshold
+ * uses. The log is written out at most every FlushDelay, so that a burst of
+ * focus changes doesn't hit the disk every time.
+ *
+ * usage() returns the score as of the last usageChanged(), which is only
+ * emitted once a score moved by more than ChangeThreshold, so that models
+ * sorted by it don't re-sort on every focus change.
+ */
+class UsageTracker: public QObject
+{
+    Q_OBJECT
+public:
+    explicit UsageTracker(const QString &directory, QObject *parent = nullptr);
+    ~UsageTracker();
+
+    // The one the LauncherModel feeds
+    static UsageTracker *instance();
+
+    static const qint64 HalfLife = 7 * 24 * 60 * 60 * 1000;
+    static const int CompactThreshold = 200;
+    static const int FlushDelay = 1000;
+    static constexpr double ChangeThreshold = 0.1;
+
+    void recordUse(const QString &appId);
+
+    double usage(const QString &appId) const;
+
+Q_SIGNALS:
+    void usageChanged(const QString &appId);
+
+private:
+    void load();
+    void compact();
+    void addUse(const QString &appId, qint64 timestamp);
+
+    QString m_directory;
+    QFile m_log;
+    int m_logCount = 0;
+    QTimer m_flushTimer;
+
+    // Scores are relative to a use at m_base
+    qint64 m_base = 0;
+    QHash<QString, double> m_scores;
+    QHash<QString, double> m_published;
+};
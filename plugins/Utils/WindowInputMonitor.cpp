@@ -15,6 +15,7 @@
  */
 
 #include "WindowInputMonitor.h"
+#include "inputlatencytracer.h"
 
 #include <QQuickWindow>
 
@@ -64,6 +65,17 @@ bool WindowInputMonitor::eventFilter(QObject *watched, QEvent *event)
 
 void WindowInputMonitor::update(QEvent *event)
 {
+    switch (event->type()) {
+    case QEvent::KeyPress:
+    case QEvent::TouchBegin:
+    case QEvent::TouchUpdate:
+    case QEvent::TouchEnd:
+        InputLatencyTracer::mark(InputLatencyTracer::InputReceived, "WindowInputMonitor");
+        break;
+    default:
+        break;
+    }
+
     if (event->type() == QEvent::KeyPress) {
         QKeyEvent *keyEvent = static_cast<QKeyEvent*>(event);
 
@@ -20,6 +20,8 @@
 
 #include <QDebug>
 
+#include <algorithm>
+
 AppDrawerProxyModel::AppDrawerProxyModel(QObject *parent):
     QSortFilterProxyModel(parent)
 {
@@ -40,11 +42,29 @@ QAbstractItemModel *AppDrawerProxyModel::source() const
 void AppDrawerProxyModel::setSource(QAbstractItemModel *source)
 {
     if (m_source != source) {
+        if (m_source) {
+            disconnect(m_source, nullptr, this, nullptr);
+        }
         m_source = source;
+
+        // Connected before setSourceModel(), so that the index is up to date by the time
+        // QSortFilterProxyModel asks us about the new or changed rows
+        if (m_source) {
+            connect(m_source, &QAbstractItemModel::rowsInserted, this, &AppDrawerProxyModel::onSourceRowsInserted);
+            connect(m_source, &QAbstractItemModel::rowsRemoved, this, &AppDrawerProxyModel::onSourceRowsRemoved);
+            connect(m_source, &QAbstractItemModel::dataChanged, this, &AppDrawerProxyModel::onSourceDataChanged);
+            connect(m_source, &QAbstractItemModel::modelReset, this, &AppDrawerProxyModel::rebuildIndex);
+            connect(m_source, &QAbstractItemModel::rowsMoved, this, &AppDrawerProxyModel::rebuildIndex);
+            connect(m_source, &QAbstractItemModel::layoutChanged, this, &AppDrawerProxyModel::rebuildIndex);
+        }
+        rebuildIndex();
+
         setSourceModel(m_source);
         setSortRole(m_sortBy == SortByAToZ ? AppDrawerModelInterface::RoleName : AppDrawerModelInterface::RoleUsage);
-        connect(m_source, &QAbstractItemModel::rowsRemoved, this, &AppDrawerProxyModel::invalidate);
-        connect(m_source, &QAbstractItemModel::rowsInserted, this, &AppDrawerProxyModel::invalidate);
+        if (m_source) {
+            connect(m_source, &QAbstractItemModel::rowsRemoved, this, &AppDrawerProxyModel::invalidate);
+            connect(m_source, &QAbstractItemModel::rowsInserted, this, &AppDrawerProxyModel::invalidate);
+        }
         Q_EMIT sourceChanged();
     }
 }
@@ -72,6 +92,7 @@ void AppDrawerProxyModel::setFilterLetter(const QString &filterLetter)
 {
     if (m_filterLetter != filterLetter) {
         m_filterLetter = filterLetter;
+        m_lowerFilterLetter = filterLetter.toLower();
         Q_EMIT filterLetterChanged();
         invalidateFilter();
     }
@@ -86,6 +107,7 @@ void AppDrawerProxyModel::setFilterString(const QString &filterString)
 {
     if (m_filterString != filterString) {
         m_filterString = filterString;
+        updateMatches();
         Q_EMIT filterStringChanged();
         invalidateFilter();
     }
@@ -135,39 +157,177 @@ bool AppDrawerProxyModel::filterAcceptsRow(int source_row, const QModelIndex &so
 {
     Q_UNUSED(source_parent)
 
+    if (source_row >= m_rows.count()) {
+        qWarning() << "AppDrawerProxyModel: index out of sync with the source model";
+        return true;
+    }
+
     if (m_group == GroupByAToZ && source_row > 0) {
-        QString currentName = m_source->data(m_source->index(source_row, 0), AppDrawerModelInterface::RoleName).toString();
-        QChar currentLetter = currentName.length() > 0 ? currentName.at(0) : QChar();
-        QString previousName = m_source->data(m_source->index(source_row - 1,0 ), AppDrawerModelInterface::RoleName).toString();
-        QChar previousLetter = previousName.length() > 0 ? previousName.at(0) : QChar();
-        if (currentLetter.toLower() == previousLetter.toLower()) {
+        if (m_rows[source_row].letter == m_rows[source_row - 1].letter) {
             return false;
         }
     } else if(m_group == GroupByAll && source_row > 0) {
         return false;
     }
     if (!m_filterLetter.isEmpty()) {
-        QString currentName = m_source->data(m_source->index(source_row, 0), AppDrawerModelInterface::RoleName).toString();
-        QString currentLetter = currentName.length() > 0 ? QString(currentName.at(0)) : QString();
-        if (currentLetter.toLower() != m_filterLetter.toLower()) {
+        if (QString(m_rows[source_row].letter) != m_lowerFilterLetter) {
             return false;
         }
     }
-    if (!m_filterString.isEmpty()) {
-        QStringList allWords = m_source->data(m_source->index(source_row, 0), AppDrawerModelInterface::RoleKeywords).toStringList();
-        allWords.prepend(m_source->data(m_source->index(source_row, 0), AppDrawerModelInterface::RoleName).toString());
-        bool found = false;
-        Q_FOREACH (const QString &currentWord, allWords) {
-            if (currentWord.startsWith(m_filterString, Qt::CaseInsensitive)) {
-                found = true;
-                break;
+    if (!m_matchedFilter.isEmpty() && !m_matches[source_row]) {
+        return false;
+    }
+    return true;
+}
+
+QString AppDrawerProxyModel::foldString(const QString &string)
+{
+    // Decompose, so that accents become marks of their own we can drop
+    const QString decomposed = string.normalized(QString::NormalizationForm_KD);
+    QString stripped;
+    stripped.reserve(decomposed.length());
+    for (const QChar c : decomposed) {
+        if (!c.isMark()) {
+            stripped.append(c);
+        }
+    }
+    return stripped.toCaseFolded();
+}
+
+AppDrawerProxyModel::IndexedRow AppDrawerProxyModel::indexRow(int sourceRow) const
+{
+    const QModelIndex index = m_source->index(sourceRow, 0);
+    const QString name = m_source->data(index, AppDrawerModelInterface::RoleName).toString();
+
+    IndexedRow row;
+    row.letter = name.length() > 0 ? name.at(0).toLower() : QChar();
+    row.words.append(foldString(name));
+    Q_FOREACH (const QString &keyword, m_source->data(index, AppDrawerModelInterface::RoleKeywords).toStringList()) {
+        row.words.append(foldString(keyword));
+    }
+    return row;
+}
+
+void AppDrawerProxyModel::addWords(int sourceRow)
+{
+    Q_FOREACH (const QString &word, m_rows[sourceRow].words) {
+        const auto entry = qMakePair(word, sourceRow);
+        m_words.insert(std::lower_bound(m_words.begin(), m_words.end(), entry), entry);
+    }
+}
+
+void AppDrawerProxyModel::removeWords(int first, int last)
+{
+    auto end = std::remove_if(m_words.begin(), m_words.end(), [first, last](const QPair<QString, int> &entry) {
+        return entry.second >= first && entry.second <= last;
+    });
+    m_words.erase(end, m_words.end());
+}
+
+bool AppDrawerProxyModel::rowMatches(int sourceRow, const QString &foldedFilter) const
+{
+    Q_FOREACH (const QString &word, m_rows[sourceRow].words) {
+        if (word.startsWith(foldedFilter)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void AppDrawerProxyModel::updateMatches()
+{
+    const QString filter = foldString(m_filterString);
+
+    if (filter.isEmpty()) {
+        m_matches.clear();
+    } else if (!m_matchedFilter.isEmpty() && filter.startsWith(m_matchedFilter)) {
+        // A longer filter can only narrow down what matched before
+        for (int i = 0; i < m_matches.count(); ++i) {
+            if (m_matches[i]) {
+                m_matches[i] = rowMatches(i, filter);
             }
         }
-        if (!found) {
-            return false;
+    } else {
+        m_matches.fill(false, m_rows.count());
+        auto it = std::lower_bound(m_words.constBegin(), m_words.constEnd(), qMakePair(filter, -1));
+        for (; it != m_words.constEnd() && it->first.startsWith(filter); ++it) {
+            m_matches[it->second] = true;
+        }
+    }
+
+    m_matchedFilter = filter;
+}
+
+void AppDrawerProxyModel::rebuildIndex()
+{
+    m_rows.clear();
+    m_words.clear();
+
+    const int rowCount = m_source ? m_source->rowCount() : 0;
+    m_rows.reserve(rowCount);
+    for (int i = 0; i < rowCount; ++i) {
+        m_rows.append(indexRow(i));
+        Q_FOREACH (const QString &word, m_rows[i].words) {
+            m_words.append(qMakePair(word, i));
+        }
+    }
+    std::sort(m_words.begin(), m_words.end());
+
+    m_matchedFilter.clear();
+    updateMatches();
+}
+
+void AppDrawerProxyModel::onSourceRowsInserted(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent)
+    const int count = last - first + 1;
+
+    for (auto &entry : m_words) {
+        if (entry.second >= first) {
+            entry.second += count;
+        }
+    }
+
+    for (int i = first; i <= last; ++i) {
+        m_rows.insert(i, indexRow(i));
+        addWords(i);
+        if (!m_matchedFilter.isEmpty()) {
+            m_matches.insert(i, rowMatches(i, m_matchedFilter));
+        }
+    }
+}
+
+void AppDrawerProxyModel::onSourceRowsRemoved(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent)
+    const int count = last - first + 1;
+
+    removeWords(first, last);
+    for (auto &entry : m_words) {
+        if (entry.second > last) {
+            entry.second -= count;
+        }
+    }
+
+    m_rows.remove(first, count);
+    if (!m_matchedFilter.isEmpty()) {
+        m_matches.remove(first, count);
+    }
+}
+
+void AppDrawerProxyModel::onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    const int first = topLeft.row();
+    const int last = bottomRight.row();
+
+    removeWords(first, last);
+    for (int i = first; i <= last; ++i) {
+        m_rows[i] = indexRow(i);
+        addWords(i);
+        if (!m_matchedFilter.isEmpty()) {
+            m_matches[i] = rowMatches(i, m_matchedFilter);
         }
     }
-    return true;
 }
 
 QString AppDrawerProxyModel::appId(int index) const
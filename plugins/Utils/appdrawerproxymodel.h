@@ -15,11 +15,20 @@
  */
 
 #include <QSortFilterProxyModel>
+#include <QVector>
 
 #include <unity/shell/launcher/AppDrawerModelInterface.h>
 
 using namespace unity::shell::launcher;
 
+/*
+ * Filters and groups the apps of the drawer.
+ *
+ * What the filters look at is indexed once per source row, so that filtering
+ * doesn't go through data() for every row on every keystroke. Searching uses a
+ * sorted list of all the case-folded, accent-stripped words, and typing one
+ * more character only rechecks the rows that matched before.
+ */
 class AppDrawerProxyModel: public QSortFilterProxyModel
 {
     Q_OBJECT
@@ -78,10 +87,37 @@ Q_SIGNALS:
     void sortByChanged();
     void countChanged();
 
+private Q_SLOTS:
+    void onSourceRowsInserted(const QModelIndex &parent, int first, int last);
+    void onSourceRowsRemoved(const QModelIndex &parent, int first, int last);
+    void onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void rebuildIndex();
+
 private:
+    struct IndexedRow {
+        QChar letter; // lower case first letter of the name
+        QStringList words; // folded name and keywords
+    };
+
+    static QString foldString(const QString &string);
+    IndexedRow indexRow(int sourceRow) const;
+    void addWords(int sourceRow);
+    void removeWords(int first, int last);
+    bool rowMatches(int sourceRow, const QString &foldedFilter) const;
+    void updateMatches();
+
     QAbstractItemModel* m_source = nullptr;
     GroupBy m_group = GroupByNone;
     QString m_filterLetter;
+    QString m_lowerFilterLetter;
     QString m_filterString;
     SortBy m_sortBy = SortByAToZ;
+
+    // One per source row
+    QVector<IndexedRow> m_rows;
+    // All the words of all the rows, sorted, with the row they belong to
+    QVector<QPair<QString, int>> m_words;
+    // Which source rows match m_matchedFilter, the folded m_filterString
+    QVector<bool> m_matches;
+    QString m_matchedFilter;
 };
@@ -18,183 +18,274 @@
 
 #include <QtConcurrent>
 #include <QDebug>
-#include <QFutureSynchronizer>
+#include <QScopedPointer>
+#include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
-#include <QSqlResult>
-#include <QRect>
 #include <unity/shell/application/ApplicationInfoInterface.h>
 
-QMutex WindowStateStorage::s_mutex;
-
-inline QString sanitiseString(QString string) {
-    return string.remove(QLatin1Char('\"'))
-                 .remove(QLatin1Char('\''))
-                 .remove(QLatin1Char('\\'));
-}
-
-WindowStateStorage::WindowStateStorage(QObject *parent):
-    QObject(parent)
+class WindowStateDatabase
 {
-    const QString dbPath = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/unity8/");
-    m_db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"));
-    QDir dir;
-    dir.mkpath(dbPath);
-    m_db.setDatabaseName(dbPath + "windowstatestorage.sqlite");
-    initdb();
-}
+public:
+    WindowStateDatabase(const QString &connectionName, const QString &path)
+        : m_connectionName(connectionName)
+        , m_path(path)
+    {
+    }
 
-WindowStateStorage::~WindowStateStorage()
+    // Opens the database and reads everything into states, geometries and stages
+    void open();
+    void write(const QHash<QString, WindowStateStorage::WindowState> &states,
+               const QHash<QString, QRect> &geometries,
+               const QHash<QString, int> &stages);
+    void close();
+
+    QHash<QString, WindowStateStorage::WindowState> states;
+    QHash<QString, QRect> geometries;
+    QHash<QString, int> stages;
+
+private:
+    void exec(QSqlQuery *query);
+
+    QString m_connectionName;
+    QString m_path;
+    QSqlDatabase m_db;
+    QScopedPointer<QSqlQuery> m_saveState;
+    QScopedPointer<QSqlQuery> m_saveGeometry;
+    QScopedPointer<QSqlQuery> m_saveStage;
+};
+
+void WindowStateDatabase::open()
 {
-    QFutureSynchronizer<void> futureSync;
-    for (int i = 0; i < m_asyncQueries.count(); ++i) {
-        futureSync.addFuture(m_asyncQueries[i]);
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+    m_db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), m_connectionName);
+    m_db.setDatabaseName(m_path);
+    if (!m_db.open()) {
+        qWarning() << "Error opening state database:" << m_db.lastError().driverText() << m_db.lastError().databaseText();
+        return;
     }
-    futureSync.waitForFinished();
-    m_db.close();
-}
 
-void WindowStateStorage::saveState(const QString &windowId, WindowStateStorage::WindowState state)
-{
-    const QString queryString = QStringLiteral("INSERT OR REPLACE INTO state (windowId, state) values ('%1', '%2');")
-            .arg(sanitiseString(windowId))
-            .arg((int)state);
+    QSqlQuery query(m_db);
+    if (!m_db.tables().contains(QStringLiteral("geometry"))) {
+        query.exec(QStringLiteral("CREATE TABLE geometry(windowId TEXT UNIQUE, x INTEGER, y INTEGER, width INTEGER, height INTEGER);"));
+    }
 
-    saveValue(queryString);
-}
+    if (!m_db.tables().contains(QStringLiteral("state"))) {
+        query.exec(QStringLiteral("CREATE TABLE state(windowId TEXT UNIQUE, state INTEGER);"));
+    }
 
-WindowStateStorage::WindowState WindowStateStorage::getState(const QString &windowId, WindowStateStorage::WindowState defaultValue) const
-{
-    const QString queryString = QStringLiteral("SELECT state FROM state WHERE windowId = '%1';")
-            .arg(sanitiseString(windowId));
+    if (!m_db.tables().contains(QStringLiteral("stage"))) {
+        query.exec(QStringLiteral("CREATE TABLE stage(appId TEXT UNIQUE, stage INTEGER);"));
+    }
 
-    QSqlQuery query = getValue(queryString);
+    if (query.exec(QStringLiteral("SELECT windowId, state FROM state;"))) {
+        while (query.next()) {
+            states.insert(query.value(0).toString(), (WindowStateStorage::WindowState)query.value(1).toInt());
+        }
+    }
 
-    if (!query.first()) {
-        return defaultValue;
+    if (query.exec(QStringLiteral("SELECT windowId, x, y, width, height FROM geometry;"))) {
+        while (query.next()) {
+            geometries.insert(query.value(0).toString(), QRect(query.value(1).toInt(), query.value(2).toInt(),
+                                                               query.value(3).toInt(), query.value(4).toInt()));
+        }
     }
-    return (WindowState)query.value(QStringLiteral("state")).toInt();
-}
 
-void WindowStateStorage::saveGeometry(const QString &windowId, const QRect &rect)
-{
-    const QString queryString = QStringLiteral("INSERT OR REPLACE INTO geometry (windowId, x, y, width, height) values ('%1', '%2', '%3', '%4', '%5');")
-            .arg(sanitiseString(windowId))
-            .arg(rect.x())
-            .arg(rect.y())
-            .arg(rect.width())
-            .arg(rect.height());
+    if (query.exec(QStringLiteral("SELECT appId, stage FROM stage;"))) {
+        while (query.next()) {
+            stages.insert(query.value(0).toString(), query.value(1).toInt());
+        }
+    }
 
-    saveValue(queryString);
+    m_saveState.reset(new QSqlQuery(m_db));
+    m_saveState->prepare(QStringLiteral("INSERT OR REPLACE INTO state (windowId, state) values (?, ?);"));
+    m_saveGeometry.reset(new QSqlQuery(m_db));
+    m_saveGeometry->prepare(QStringLiteral("INSERT OR REPLACE INTO geometry (windowId, x, y, width, height) values (?, ?, ?, ?, ?);"));
+    m_saveStage.reset(new QSqlQuery(m_db));
+    m_saveStage->prepare(QStringLiteral("INSERT OR REPLACE INTO stage (appId, stage) values (?, ?);"));
 }
 
-void WindowStateStorage::saveStage(const QString &appId, int stage)
+void WindowStateDatabase::write(const QHash<QString, WindowStateStorage::WindowState> &states,
+                                const QHash<QString, QRect> &geometries,
+                                const QHash<QString, int> &stages)
 {
-    const QString queryString = QStringLiteral("INSERT OR REPLACE INTO stage (appId, stage) values ('%1', '%2');")
-            .arg(sanitiseString(appId))
-            .arg(stage);
+    if (!m_db.isOpen()) {
+        return;
+    }
 
-    saveValue(queryString);
-}
+    m_db.transaction();
 
-int WindowStateStorage::getStage(const QString &appId, int defaultValue) const
-{
-    const QString queryString = QStringLiteral("SELECT stage FROM stage WHERE appId = '%1';")
-            .arg(sanitiseString(appId));
+    for (auto it = states.constBegin(); it != states.constEnd(); ++it) {
+        m_saveState->bindValue(0, it.key());
+        m_saveState->bindValue(1, (int)it.value());
+        exec(m_saveState.data());
+    }
 
-    QSqlQuery query = getValue(queryString);
+    for (auto it = geometries.constBegin(); it != geometries.constEnd(); ++it) {
+        m_saveGeometry->bindValue(0, it.key());
+        m_saveGeometry->bindValue(1, it->x());
+        m_saveGeometry->bindValue(2, it->y());
+        m_saveGeometry->bindValue(3, it->width());
+        m_saveGeometry->bindValue(4, it->height());
+        exec(m_saveGeometry.data());
+    }
+
+    for (auto it = stages.constBegin(); it != stages.constEnd(); ++it) {
+        m_saveStage->bindValue(0, it.key());
+        m_saveStage->bindValue(1, it.value());
+        exec(m_saveStage.data());
+    }
 
-    if (!query.first()) {
-        return defaultValue;
+    if (!m_db.commit()) {
+        qWarning() << "Error writing window states:" << m_db.lastError().driverText() << m_db.lastError().databaseText();
     }
-    return query.value("stage").toInt();
 }
 
-void WindowStateStorage::executeAsyncQuery(const QString &queryString)
+void WindowStateDatabase::exec(QSqlQuery *query)
 {
-    QMutexLocker l(&s_mutex);
-    QSqlQuery query;
-
-    bool ok = query.exec(queryString);
-    if (!ok) {
-        qWarning() << "Error executing query" << queryString
-                   << "Driver error:" << query.lastError().driverText()
-                   << "Database error:" << query.lastError().databaseText();
+    if (!query->exec()) {
+        qWarning() << "Error executing query" << query->lastQuery()
+                   << "Driver error:" << query->lastError().driverText()
+                   << "Database error:" << query->lastError().databaseText();
     }
 }
 
-QRect WindowStateStorage::getGeometry(const QString &windowId, const QRect &defaultValue) const
+void WindowStateDatabase::close()
 {
-    QString queryString = QStringLiteral("SELECT * FROM geometry WHERE windowId = '%1';")
-            .arg(sanitiseString(windowId));
-
-    QSqlQuery query = getValue(queryString);
+    m_saveState.reset();
+    m_saveGeometry.reset();
+    m_saveStage.reset();
+    m_db.close();
+    m_db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(m_connectionName);
+}
 
-    if (!query.first()) {
-        return defaultValue;
-    }
+WindowStateStorage::WindowStateStorage(QObject *parent):
+    QObject(parent),
+    m_loaded(false)
+{
+    const QString dbPath = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/unity8/");
+    m_database = new WindowStateDatabase(QStringLiteral("WindowStateStorage-%1").arg((quintptr)this),
+                                         dbPath + "windowstatestorage.sqlite");
+
+    m_dbThread.setMaxThreadCount(1);
+    m_dbThread.setExpiryTimeout(-1);
+    m_loading = QtConcurrent::run(&m_dbThread, [this]() { m_database->open(); });
+
+    // Don't wait for the first read if we can help it
+    auto loadingWatcher = new QFutureWatcher<void>(this);
+    connect(loadingWatcher, &QFutureWatcher<void>::finished, this, [this, loadingWatcher]() {
+        mergeLoaded();
+        loadingWatcher->deleteLater();
+    });
+    loadingWatcher->setFuture(m_loading);
+
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(FlushInterval);
+    connect(&m_flushTimer, &QTimer::timeout, this, &WindowStateStorage::flush);
+}
 
-    const QRect result(query.value(QStringLiteral("x")).toInt(), query.value(QStringLiteral("y")).toInt(),
-                       query.value(QStringLiteral("width")).toInt(), query.value(QStringLiteral("height")).toInt());
+WindowStateStorage::~WindowStateStorage()
+{
+    flush();
+    QtConcurrent::run(&m_dbThread, [this]() { m_database->close(); });
+    m_dbThread.waitForDone();
+    delete m_database;
+}
 
-    if (result.isValid()) {
-        return result;
+void WindowStateStorage::ensureLoaded() const
+{
+    if (!m_loaded) {
+        m_loading.waitForFinished();
+        mergeLoaded();
     }
-
-    return defaultValue;
 }
 
-void WindowStateStorage::initdb()
+void WindowStateStorage::mergeLoaded() const
 {
-    m_db.open();
-    if (!m_db.open()) {
-        qWarning() << "Error opening state database:" << m_db.lastError().driverText() << m_db.lastError().databaseText();
+    if (m_loaded) {
         return;
     }
+    m_loaded = true;
 
-    if (!m_db.tables().contains(QStringLiteral("geometry"))) {
-        QSqlQuery query;
-        query.exec(QStringLiteral("CREATE TABLE geometry(windowId TEXT UNIQUE, x INTEGER, y INTEGER, width INTEGER, height INTEGER);"));
+    // Anything saved while we were loading is newer than what's in the database
+    for (auto it = m_database->states.constBegin(); it != m_database->states.constEnd(); ++it) {
+        if (!m_states.contains(it.key()))
+            m_states.insert(it.key(), it.value());
     }
-
-    if (!m_db.tables().contains(QStringLiteral("state"))) {
-        QSqlQuery query;
-        query.exec(QStringLiteral("CREATE TABLE state(windowId TEXT UNIQUE, state INTEGER);"));
+    for (auto it = m_database->geometries.constBegin(); it != m_database->geometries.constEnd(); ++it) {
+        if (!m_geometries.contains(it.key()))
+            m_geometries.insert(it.key(), it.value());
+    }
+    for (auto it = m_database->stages.constBegin(); it != m_database->stages.constEnd(); ++it) {
+        if (!m_stages.contains(it.key()))
+            m_stages.insert(it.key(), it.value());
     }
+}
 
-    if (!m_db.tables().contains(QStringLiteral("stage"))) {
-        QSqlQuery query;
-        query.exec(QStringLiteral("CREATE TABLE stage(appId TEXT UNIQUE, stage INTEGER);"));
+void WindowStateStorage::flush()
+{
+    m_flushTimer.stop();
+    if (m_dirtyStates.isEmpty() && m_dirtyGeometries.isEmpty() && m_dirtyStages.isEmpty()) {
+        return;
     }
+
+    auto database = m_database;
+    const auto states = m_dirtyStates;
+    const auto geometries = m_dirtyGeometries;
+    const auto stages = m_dirtyStages;
+    QtConcurrent::run(&m_dbThread, [database, states, geometries, stages]() {
+        database->write(states, geometries, stages);
+    });
+
+    m_dirtyStates.clear();
+    m_dirtyGeometries.clear();
+    m_dirtyStages.clear();
 }
 
-void WindowStateStorage::saveValue(const QString &queryString)
+void WindowStateStorage::saveState(const QString &windowId, WindowStateStorage::WindowState state)
 {
-    QMutexLocker mutexLocker(&s_mutex);
+    m_states.insert(windowId, state);
+    m_dirtyStates.insert(windowId, state);
+    m_flushTimer.start();
+}
 
-    QFuture<void> future = QtConcurrent::run(&m_threadPool, executeAsyncQuery, queryString);
-    m_asyncQueries.append(future);
+WindowStateStorage::WindowState WindowStateStorage::getState(const QString &windowId, WindowStateStorage::WindowState defaultValue) const
+{
+    ensureLoaded();
+    return m_states.value(windowId, defaultValue);
+}
 
-    QFutureWatcher<void> *futureWatcher = new QFutureWatcher<void>();
-    futureWatcher->setFuture(future);
-    connect(futureWatcher, &QFutureWatcher<void>::finished,
-            this,
-            [=](){ m_asyncQueries.removeAll(futureWatcher->future());
-        futureWatcher->deleteLater(); });
+void WindowStateStorage::saveGeometry(const QString &windowId, const QRect &rect)
+{
+    m_geometries.insert(windowId, rect);
+    m_dirtyGeometries.insert(windowId, rect);
+    m_flushTimer.start();
 }
 
-QSqlQuery WindowStateStorage::getValue(const QString &queryString) const
+void WindowStateStorage::saveStage(const QString &appId, int stage)
 {
-    QMutexLocker l(&s_mutex);
-    QSqlQuery query;
+    m_stages.insert(appId, stage);
+    m_dirtyStages.insert(appId, stage);
+    m_flushTimer.start();
+}
 
-    bool ok = query.exec(queryString);
-    if (!ok) {
-        qWarning() << "Error retrieving database query:" << queryString
-                   << "Driver error:" << query.lastError().driverText()
-                   << "Database error:" << query.lastError().databaseText();
+int WindowStateStorage::getStage(const QString &appId, int defaultValue) const
+{
+    ensureLoaded();
+    return m_stages.value(appId, defaultValue);
+}
+
+QRect WindowStateStorage::getGeometry(const QString &windowId, const QRect &defaultValue) const
+{
+    ensureLoaded();
+    const QRect result = m_geometries.value(windowId);
+
+    if (result.isValid()) {
+        return result;
     }
-    return query;
+
+    return defaultValue;
 }
 
 Mir::State WindowStateStorage::toMirState(WindowState state) const
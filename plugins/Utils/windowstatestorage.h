@@ -15,14 +15,25 @@
  */
 
 #include <QObject>
-#include <QSqlDatabase>
-#include <QMutex>
 #include <QFuture>
+#include <QHash>
+#include <QRect>
 #include <QThreadPool>
+#include <QTimer>
 
 // unity-api
 #include <unity/shell/application/Mir.h>
 
+class WindowStateDatabase;
+
+/*
+ * Remembers the state, geometry and stage of windows across sessions.
+ *
+ * Everything is kept in memory, loaded from the database when we start
+ * and written back in batches: changes are coalesced per window and
+ * written in a single transaction after FlushInterval or on destruction.
+ * The database is only ever touched from a thread of its own.
+ */
 class WindowStateStorage: public QObject
 {
     Q_OBJECT
@@ -60,18 +71,30 @@ public:
 
     Q_INVOKABLE Mir::State toMirState(WindowState state) const;
 
+    static const int FlushInterval = 1000; // ms
+
+private Q_SLOTS:
+    void flush();
+
 private:
-    void initdb();
+    void ensureLoaded() const;
+    void mergeLoaded() const;
 
-    void saveValue(const QString &queryString);
-    QSqlQuery getValue(const QString &queryString) const;
+    // Only used from m_dbThread
+    WindowStateDatabase *m_database;
 
-    static void executeAsyncQuery(const QString &queryString);
-    static QMutex s_mutex;
+    // A single thread that is kept around, database connections can't move between threads
+    QThreadPool m_dbThread;
 
-    // NB: This is accessed from threads. Make sure to mutex it.
-    QSqlDatabase m_db;
+    mutable QFuture<void> m_loading;
+    mutable bool m_loaded;
+    mutable QHash<QString, WindowState> m_states;
+    mutable QHash<QString, QRect> m_geometries;
+    mutable QHash<QString, int> m_stages;
 
-    QList<QFuture<void>> m_asyncQueries;
-    QThreadPool m_threadPool;
+    // Changes not yet written to the database
+    QHash<QString, WindowState> m_dirtyStates;
+    QHash<QString, QRect> m_dirtyGeometries;
+    QHash<QString, int> m_dirtyStages;
+    QTimer m_flushTimer;
 };
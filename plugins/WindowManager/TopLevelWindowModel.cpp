@@ -56,6 +56,8 @@ void TopLevelWindowModel::setApplicationManager(unityapi::ApplicationManagerInte
 
     if (m_applicationManager) {
         m_windowModel.clear();
+        m_pendingRaises.clear();
+        clearIndex();
         disconnect(m_applicationManager, 0, this, 0);
     }
 
@@ -197,6 +199,9 @@ void TopLevelWindowModel::prependSurfaceHelper(unityapi::MirSurfaceInterface *su
 
 void TopLevelWindowModel::prependWindow(Window *window, unityapi::ApplicationInfoInterface *application)
 {
+    // Whatever was raised before this window came up goes below it
+    applyPendingRaises();
+
     if (m_modelState == IdleState) {
         m_modelState = InsertingState;
         beginInsertRows(QModelIndex(), 0 /*first*/, 0 /*last*/);
@@ -206,6 +211,8 @@ void TopLevelWindowModel::prependWindow(Window *window, unityapi::ApplicationInf
     }
 
     m_windowModel.prepend(ModelEntry(window, application));
+    updateRows(0, m_windowModel.count() - 1);
+    indexSurface(0);
 
     if (m_modelState == InsertingState) {
         endInsertRows();
@@ -217,6 +224,14 @@ void TopLevelWindowModel::prependWindow(Window *window, unityapi::ApplicationInf
 
 void TopLevelWindowModel::connectWindow(Window *window)
 {
+    connect(window, &Window::surfaceChanged, this, [this, window]() {
+        const int index = indexForId(window->id());
+        if (index != -1) {
+            unindexSurface(index);
+            indexSurface(index);
+        }
+    });
+
     connect(window, &Window::focusRequested, this, [this, window]() {
         if (!window->surface()) {
             activateEmptyWindow(window);
@@ -422,7 +437,10 @@ void TopLevelWindowModel::removeAt(int index)
         window->setFocused(false);
     }
 
+    unindexSurface(index);
+    m_rowForId.remove(window->id());
     m_windowModel.removeAt(index);
+    updateRows(index, m_windowModel.count() - 1);
 
     if (m_modelState == RemovingState) {
         endRemoveRows();
@@ -460,13 +478,50 @@ void TopLevelWindowModel::removeInputMethodWindow()
 void TopLevelWindowModel::onSurfacesRaised(const QVector<unityapi::MirSurfaceInterface*> &surfaces)
 {
     DEBUG_MSG << "(" << surfaces << ")";
-    const int raiseCount = surfaces.size();
-    for (int i = 0; i < raiseCount; i++) {
-        int fromIndex = findIndexOf(surfaces[i]);
-        if (fromIndex != -1) {
-            move(fromIndex, 0);
+    for (auto surface : surfaces) {
+        m_pendingRaises.append(surface);
+    }
+    if (!m_modificationsInProgress) {
+        applyPendingRaises();
+    }
+}
+
+void TopLevelWindowModel::applyPendingRaises()
+{
+    if (m_pendingRaises.isEmpty() || m_modelState != IdleState) {
+        return;
+    }
+
+    // Final order of the raised windows, top-most first
+    QVector<int> raisedIds;
+    for (int i = m_pendingRaises.count() - 1; i >= 0; --i) {
+        int index = indexOf(m_pendingRaises[i]);
+        if (index != -1 && !raisedIds.contains(idAt(index))) {
+            raisedIds.append(idAt(index));
         }
     }
+    m_pendingRaises.clear();
+
+    // The bottom of that stack might already be at the top of the list, those don't need to move
+    const int raisedCount = raisedIds.count();
+    int inPlace = 0;
+    for (int count = raisedCount; count > 0 && inPlace == 0; --count) {
+        bool matches = true;
+        for (int i = 0; i < count && matches; ++i) {
+            matches = idAt(i) == raisedIds[raisedCount - count + i];
+        }
+        if (matches) {
+            inPlace = count;
+        }
+    }
+
+    for (int i = raisedCount - inPlace - 1; i >= 0; --i) {
+        move(indexForId(raisedIds[i]), 0, false /* notifyListChanged */);
+    }
+
+    if (inPlace < raisedCount) {
+        Q_EMIT listChanged();
+    }
 }
 
 int TopLevelWindowModel::rowCount(const QModelIndex &/*parent*/) const
@@ -489,16 +544,6 @@ QVariant TopLevelWindowModel::data(const QModelIndex& index, int role) const
     }
 }
 
-int TopLevelWindowModel::findIndexOf(const unityapi::MirSurfaceInterface *surface) const
-{
-    for (int i=0; i<m_windowModel.count(); i++) {
-        if (m_windowModel[i].window->surface() == surface) {
-            return i;
-        }
-    }
-    return -1;
-}
-
 int TopLevelWindowModel::generateId()
 {
     int id = m_nextId;
@@ -519,7 +564,8 @@ int TopLevelWindowModel::nextFreeId(int candidateId, const int latestId)
 {
     int firstCandidateId = candidateId;
 
-    while (indexForId(candidateId) != -1 || candidateId == latestId) {
+    // Ids only get reused once we wrap around m_maxId, so this is normally a single lookup
+    while (m_rowForId.contains(candidateId) || candidateId == latestId) {
         candidateId = nextId(candidateId);
 
         if (candidateId == firstCandidateId) {
@@ -550,24 +596,53 @@ QString TopLevelWindowModel::toString()
     return str;
 }
 
-int TopLevelWindowModel::indexOf(unityapi::MirSurfaceInterface *surface)
+int TopLevelWindowModel::indexOf(const unityapi::MirSurfaceInterface *surface) const
 {
-    for (int i = 0; i < m_windowModel.count(); ++i) {
-        if (m_windowModel.at(i).window->surface() == surface) {
-            return i;
-        }
+    auto it = m_idForSurface.constFind(surface);
+    if (it == m_idForSurface.constEnd()) {
+        return -1;
     }
-    return -1;
+    return indexForId(it.value());
 }
 
 int TopLevelWindowModel::indexForId(int id) const
 {
-    for (int i = 0; i < m_windowModel.count(); ++i) {
-        if (m_windowModel[i].window->id() == id) {
-            return i;
+    return m_rowForId.value(id, -1);
+}
+
+void TopLevelWindowModel::updateRows(int first, int last)
+{
+    for (int i = first; i <= last; ++i) {
+        m_rowForId[m_windowModel[i].window->id()] = i;
+    }
+}
+
+void TopLevelWindowModel::indexSurface(int index)
+{
+    ModelEntry &entry = m_windowModel[index];
+    Q_ASSERT(!entry.indexedSurface);
+    entry.indexedSurface = entry.window->surface();
+    if (entry.indexedSurface) {
+        m_idForSurface[entry.indexedSurface] = entry.window->id();
+    }
+}
+
+void TopLevelWindowModel::unindexSurface(int index)
+{
+    ModelEntry &entry = m_windowModel[index];
+    if (entry.indexedSurface) {
+        auto it = m_idForSurface.find(entry.indexedSurface);
+        if (it != m_idForSurface.end() && it.value() == entry.window->id()) {
+            m_idForSurface.erase(it);
         }
+        entry.indexedSurface = nullptr;
     }
-    return -1;
+}
+
+void TopLevelWindowModel::clearIndex()
+{
+    m_rowForId.clear();
+    m_idForSurface.clear();
 }
 
 Window *TopLevelWindowModel::windowAt(int index) const
@@ -624,6 +699,8 @@ void TopLevelWindowModel::raiseId(int id)
 
 void TopLevelWindowModel::doRaiseId(int id)
 {
+    applyPendingRaises();
+
     int fromIndex = indexForId(id);
     // can't raise something that doesn't exist or that it's already on top
     if (fromIndex != -1 && fromIndex != 0) {
@@ -665,7 +742,7 @@ Window* TopLevelWindowModel::focusedWindow() const
     return m_focusedWindow;
 }
 
-void TopLevelWindowModel::move(int from, int to)
+void TopLevelWindowModel::move(int from, int to, bool notifyListChanged)
 {
     if (from == to) return;
     DEBUG_MSG << " from=" << from << " to=" << to;
@@ -686,9 +763,12 @@ void TopLevelWindowModel::move(int from, int to)
 #else
         m_windowModel.move(from, to);
 #endif
+        updateRows(qMin(from, to), qMax(from, to));
         endMoveRows();
 
-        Q_EMIT listChanged();
+        if (notifyListChanged) {
+            Q_EMIT listChanged();
+        }
         m_modelState = IdleState;
 
         INFO_MSG << " after " << toString();
@@ -696,10 +776,14 @@ void TopLevelWindowModel::move(int from, int to)
 }
 void TopLevelWindowModel::onModificationsStarted()
 {
+    m_modificationsInProgress = true;
 }
 
 void TopLevelWindowModel::onModificationsEnded()
 {
+    m_modificationsInProgress = false;
+    applyPendingRaises();
+
     if (m_focusedWindowChanged) {
         setFocusedWindow(m_newlyFocusedWindow);
     }
@@ -712,10 +796,12 @@ void TopLevelWindowModel::activateTopMostWindowWithoutId(int forbiddenId)
 {
     DEBUG_MSG << "(" << forbiddenId << ")";
 
-    for (int i = 0; i < m_windowModel.count(); ++i) {
+    // The top-most window is the first one, unless that's the forbidden one
+    for (int i = 0; i < qMin(2, m_windowModel.count()); ++i) {
         Window *window = m_windowModel[i].window;
         if (window->id() != forbiddenId) {
             window->activate();
+            break;
         }
     }
 }
@@ -193,12 +193,11 @@ private:
     int nextFreeId(int candidateId, const int latestId);
     int nextId(int id) const;
     QString toString();
-    int indexOf(unity::shell::application::MirSurfaceInterface *surface);
+    int indexOf(const unity::shell::application::MirSurfaceInterface *surface) const;
 
     void setInputMethodWindow(Window *window);
     void setFocusedWindow(Window *window);
     void removeInputMethodWindow();
-    int findIndexOf(const unity::shell::application::MirSurfaceInterface *surface) const;
     void deleteAt(int index);
     void removeAt(int index);
 
@@ -218,7 +217,14 @@ private:
     void onSurfaceDied(unity::shell::application::MirSurfaceInterface *surface);
     void onSurfaceDestroyed(unity::shell::application::MirSurfaceInterface *surface);
 
-    void move(int from, int to);
+    void move(int from, int to, bool notifyListChanged = true);
+    void applyPendingRaises();
+
+    // Keep the lookup tables in sync with m_windowModel
+    void updateRows(int first, int last);
+    void indexSurface(int index);
+    void unindexSurface(int index);
+    void clearIndex();
 
     void activateEmptyWindow(Window *window);
 
@@ -234,9 +240,16 @@ private:
         Window *window{nullptr};
         unity::shell::application::ApplicationInfoInterface *application{nullptr};
         bool removeOnceSurfaceDestroyed{false};
+        // The surface this entry is found under in m_idForSurface
+        const unity::shell::application::MirSurfaceInterface *indexedSurface{nullptr};
     };
 
     QVector<ModelEntry> m_windowModel;
+
+    // Window id -> row in m_windowModel
+    QHash<int, int> m_rowForId;
+    // Surface -> id of the window in m_windowModel showing it
+    QHash<const unity::shell::application::MirSurfaceInterface*, int> m_idForSurface;
     Window* m_inputMethodWindow{nullptr};
     Window* m_focusedWindow{nullptr};
 
@@ -259,8 +272,13 @@ private:
     ModelState m_modelState{IdleState};
 
     // Valid between modificationsStarted and modificationsEnded
+    bool m_modificationsInProgress{false};
     bool m_focusedWindowChanged{false};
     Window *m_newlyFocusedWindow{nullptr};
+
+    // Surfaces raised but not yet moved, in the order they were raised.
+    // Applied together so that each window moves at most once.
+    QVector<const unity::shell::application::MirSurfaceInterface*> m_pendingRaises;
 };
 
 #endif // TOPLEVELWINDOWMODEL_H
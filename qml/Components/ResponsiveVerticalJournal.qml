@@ -48,6 +48,7 @@ Item {
     property alias model: verticalJournalView.model
     property alias delegate: verticalJournalView.delegate
     property alias cacheBuffer: verticalJournalView.cacheBuffer
+    property alias delegatePoolSize: verticalJournalView.delegatePoolSize
     property real displayMarginBeginning: 0
     property real displayMarginEnd: 0
 
@@ -60,6 +60,8 @@ DashRenderer {
         columnWidth: cardTool.cardWidth
 
         cacheBuffer: root.cacheBuffer
+        // Keep some cards around so flicking back and forth doesn't recreate them
+        delegatePoolSize: 16
         displayMarginBeginning: root.displayMarginBeginning
         displayMarginEnd: root.displayMarginEnd
 
@@ -17,8 +17,11 @@
  */
 
 #include "DebuggingController.h"
+#include "inputlatencytracer.h"
 
+#include <QDir>
 #include <QGuiApplication>
+#include <QStandardPaths>
 #include <QWindow>
 #include <private/qquickwindow_p.h>
 #include <private/qabstractanimationjob_p.h>
@@ -90,3 +93,43 @@ void DebuggingController::SetLoggingFilterRules(const QString &filterRules)
 {
     QLoggingCategory::setFilterRules(filterRules);
 }
+
+void DebuggingController::SetInputLatencyTracing(bool enabled)
+{
+    Q_FOREACH (const QMetaObject::Connection &connection, m_frameSwappedConnections) {
+        disconnect(connection);
+    }
+    m_frameSwappedConnections.clear();
+
+    InputLatencyTracer *tracer = InputLatencyTracer::instance();
+    if (enabled) {
+        tracer->clear();
+
+        Q_FOREACH (QWindow *window, QGuiApplication::allWindows()) {
+            QQuickWindow* qquickWindow = qobject_cast<QQuickWindow*>(window);
+            if (qquickWindow) {
+                // Emitted from the render thread, right after the swap
+                m_frameSwappedConnections << connect(qquickWindow, &QQuickWindow::frameSwapped, this, []() {
+                    InputLatencyTracer::mark(InputLatencyTracer::FrameSwapped, "QQuickWindow");
+                }, Qt::DirectConnection);
+            }
+        }
+    }
+    tracer->setEnabled(enabled);
+}
+
+QString DebuggingController::GetInputLatencyHistograms()
+{
+    return InputLatencyTracer::instance()->histograms();
+}
+
+QString DebuggingController::WriteInputLatencyTrace()
+{
+    // Not a path of the caller's choosing, anyone on the bus can call this
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/unity8");
+    const QString path = dir + QStringLiteral("/input-latency.json");
+    if (!QDir().mkpath(dir) || !InputLatencyTracer::instance()->writeTrace(path)) {
+        return QString();
+    }
+    return path;
+}
@@ -53,5 +53,25 @@ public Q_SLOTS:
       */
     Q_SCRIPTABLE void SetLoggingFilterRules(const QString &filterRules);
 
+    /**
+      * Start or stop measuring the latency from input events to the frames
+      * showing them. Starting over clears what was measured before.
+      */
+    Q_SCRIPTABLE void SetInputLatencyTracing(bool enabled);
+
+    /**
+      * Per-stage histograms of the input latency measured so far.
+      */
+    Q_SCRIPTABLE QString GetInputLatencyHistograms();
+
+    /**
+      * Write the input latency trace in the Chrome trace event format, to
+      * input-latency.json in the shell's cache directory. Returns the path
+      * of the file, or an empty string if it couldn't be written.
+      */
+    Q_SCRIPTABLE QString WriteInputLatencyTrace();
+
+private:
+    QList<QMetaObject::Connection> m_frameSwappedConnections;
 };
 #endif // DEBUGGINGCONTROLLER_H
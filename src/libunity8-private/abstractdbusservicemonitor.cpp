@@ -19,11 +19,52 @@
 
 #include "abstractdbusservicemonitor.h"
 
-#include <QDBusInterface>
+#include <QDBusAbstractInterface>
 #include <QDBusServiceWatcher>
 #include <QDBusConnection>
 #include <QDBusConnectionInterface>
-#include <QDBusReply>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QHash>
+
+/*
+ * QDBusInterface synchronously introspects the service on construction, which will block the GUI
+ * thread of this process if the service is busy. QDBusAbstractInterface does not perform this
+ * introspection, so let's subclass that and avoid the blocking scenario.
+ *
+ * However we lose Qt's wrapping of the DBus service with a MetaObject, with the result that we
+ * cannot easily connect to DBus signals with the usual connect() calls. That's what
+ * AbstractDBusServiceMonitor::connectToSignal() is for.
+ */
+class AsyncDBusInterface : public QDBusAbstractInterface
+{
+public:
+    AsyncDBusInterface(const QString &service, const QString &path,
+                       const QString &interface, const QDBusConnection &connection,
+                       QObject *parent = 0)
+    : QDBusAbstractInterface(service, path, interface.toLatin1().data(), connection, parent)
+    {}
+};
+
+// QDBusConnection::connect() only takes slots, this passes the message on to a handler.
+class DBusSignalRelay : public QObject
+{
+    Q_OBJECT
+public:
+    DBusSignalRelay(const std::function<void(const QDBusMessage &)> &handler, QObject *parent)
+        : QObject(parent)
+        , m_handler(handler)
+    {}
+
+public Q_SLOTS:
+    void relay(const QDBusMessage &message) { m_handler(message); }
+
+private:
+    std::function<void(const QDBusMessage &)> m_handler;
+};
+
+typedef QHash<QString, QWeakPointer<QDBusAbstractInterface>> InterfaceRegistry;
+Q_GLOBAL_STATIC(InterfaceRegistry, sharedInterfaces)
 
 AbstractDBusServiceMonitor::AbstractDBusServiceMonitor(const QString &service, const QString &path,
                                                        const QString &interface, const Bus bus,
@@ -33,68 +74,95 @@ AbstractDBusServiceMonitor::AbstractDBusServiceMonitor(const QString &service, c
     , m_path(path)
     , m_interface(interface)
     , m_bus(bus)
-    , m_watcher(new QDBusServiceWatcher(service,
-                                        (bus == SystemBus) ? QDBusConnection::systemBus()
-                                                           : QDBusConnection::sessionBus()))
-    , m_dbusInterface(nullptr)
+    , m_watcher(new QDBusServiceWatcher(service, connection()))
+    , m_registrationKnown(false)
 {
     connect(m_watcher, &QDBusServiceWatcher::serviceRegistered, this, &AbstractDBusServiceMonitor::onServiceRegistered);
     connect(m_watcher, &QDBusServiceWatcher::serviceUnregistered, this, &AbstractDBusServiceMonitor::onServiceUnregistered);
 
-    // Connect to the service if it's up already
-    QDBusConnectionInterface* sessionBus = QDBusConnection::sessionBus().interface();
-    QDBusReply<bool> reply = sessionBus->isServiceRegistered(m_service);
-    if (reply.isValid() && reply.value()) {
-        onServiceRegistered(m_service);
+    // Connect to the service if it's up already, without waiting for the bus to tell
+    QDBusConnectionInterface* busInterface = connection().interface();
+    if (busInterface) {
+        QDBusPendingCall call = busInterface->asyncCall(QStringLiteral("NameHasOwner"), m_service);
+        QDBusPendingCallWatcher *callWatcher = new QDBusPendingCallWatcher(call, this);
+        connect(callWatcher, &QDBusPendingCallWatcher::finished, this, &AbstractDBusServiceMonitor::onRegistrationChecked);
     }
 }
 
 AbstractDBusServiceMonitor::~AbstractDBusServiceMonitor()
 {
     delete m_watcher;
-    delete m_dbusInterface;
 }
 
-void AbstractDBusServiceMonitor::onServiceRegistered(const QString &)
+QDBusConnection AbstractDBusServiceMonitor::connection() const
+{
+    return (m_bus == SystemBus) ? QDBusConnection::systemBus() : QDBusConnection::sessionBus();
+}
+
+void AbstractDBusServiceMonitor::onRegistrationChecked(QDBusPendingCallWatcher *watcher)
 {
-    if (m_dbusInterface != nullptr) {
-        delete m_dbusInterface;
-        m_dbusInterface = nullptr;
+    watcher->deleteLater();
+
+    QDBusPendingReply<bool> reply = *watcher;
+    if (m_registrationKnown || reply.isError()) {
+        return;
     }
 
-    m_dbusInterface = createInterface(m_service, m_path, m_interface,
-                                      (m_bus == SystemBus) ? QDBusConnection::systemBus()
-                                                           : QDBusConnection::sessionBus());
+    if (reply.value()) {
+        onServiceRegistered(m_service);
+    }
+}
+
+void AbstractDBusServiceMonitor::onServiceRegistered(const QString &)
+{
+    m_registrationKnown = true;
+
+    m_dbusInterface = createInterface(m_service, m_path, m_interface, connection());
     Q_EMIT serviceAvailableChanged(true);
 }
 
-/*
- * Default implementation creates a QDBusInterface. This performs blocking introspection of the
- * service at initialization, which may be undesirable if the service is slow/blocked.
- */
-QDBusAbstractInterface*
+QSharedPointer<QDBusAbstractInterface>
 AbstractDBusServiceMonitor::createInterface(const QString &service, const QString &path,
                                             const QString &interface, const QDBusConnection &connection)
 {
-    return new QDBusInterface(service, path, interface, connection);
+    const QString key = connection.name() + QLatin1Char(' ') + service + QLatin1Char(' ')
+                      + path + QLatin1Char(' ') + interface;
+
+    QSharedPointer<QDBusAbstractInterface> dbusInterface = sharedInterfaces->value(key).toStrongRef();
+    if (!dbusInterface) {
+        dbusInterface.reset(new AsyncDBusInterface(service, path, interface, connection));
+        sharedInterfaces->insert(key, dbusInterface);
+    }
+    return dbusInterface;
 }
 
 void AbstractDBusServiceMonitor::onServiceUnregistered(const QString &)
 {
-    if (m_dbusInterface != nullptr) {
-        delete m_dbusInterface;
-        m_dbusInterface = nullptr;
-    }
+    m_registrationKnown = true;
 
+    m_dbusInterface.clear();
     Q_EMIT serviceAvailableChanged(false);
 }
 
 QDBusAbstractInterface* AbstractDBusServiceMonitor::dbusInterface() const
 {
-    return m_dbusInterface;
+    return m_dbusInterface.data();
 }
 
 bool AbstractDBusServiceMonitor::serviceAvailable() const
 {
-    return m_dbusInterface != nullptr;
+    return !m_dbusInterface.isNull();
+}
+
+bool AbstractDBusServiceMonitor::connectToSignal(const QString &name, QObject *context,
+                                                 const std::function<void(const QDBusMessage &)> &handler)
+{
+    DBusSignalRelay *relay = new DBusSignalRelay(handler, context);
+    if (!connection().connect(m_service, m_path, m_interface, name, relay, SLOT(relay(QDBusMessage)))) {
+        delete relay;
+        return false;
+    }
+    return true;
 }
+
+#include "abstractdbusservicemonitor.moc"
@@ -22,11 +22,32 @@
 
 #include <QObject>
 #include <QString>
+#include <QDBusArgument>
 #include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDebug>
+#include <QSharedPointer>
+
+#include <functional>
+#include <type_traits>
 
 class QDBusAbstractInterface;
+class QDBusPendingCallWatcher;
 class QDBusServiceWatcher;
 
+namespace DBusSignalArguments {
+template <int...> struct Indexes {};
+template <int N, int... Is> struct MakeIndexes : MakeIndexes<N - 1, N - 1, Is...> {};
+template <int... Is> struct MakeIndexes<0, Is...> { typedef Indexes<Is...> Type; };
+}
+
+/*
+ * Keeps an interface to a DBus service around for as long as the service is on the bus.
+ *
+ * Nothing here blocks: whether the service is up already is asked for asynchronously,
+ * and the interfaces aren't introspected. Monitors of the same service, path and
+ * interface share one interface.
+ */
 class Q_DECL_EXPORT AbstractDBusServiceMonitor : public QObject
 {
     Q_OBJECT
@@ -48,23 +69,59 @@ public:
 
     bool serviceAvailable() const;
 
+    // As the interfaces aren't introspected, their signals can't be connected to with
+    // QObject::connect(). These go through the bus instead, and stay connected while
+    // the service comes and goes. The handler goes away along with the context.
+    bool connectToSignal(const QString &name, QObject *context,
+                         const std::function<void(const QDBusMessage &)> &handler);
+
+    // The slot's arguments are demarshalled from the signal's.
+    template <typename Receiver, typename... Args>
+    bool connectToSignal(const QString &name, Receiver *receiver, void (Receiver::*slot)(Args...))
+    {
+        return connectToSignal(name, receiver, [name, receiver, slot](const QDBusMessage &message) {
+            if (message.arguments().count() < static_cast<int>(sizeof...(Args))) {
+                qWarning() << "AbstractDBusServiceMonitor: Not enough arguments for" << name;
+                return;
+            }
+            invoke(message.arguments(), receiver, slot, typename DBusSignalArguments::MakeIndexes<sizeof...(Args)>::Type());
+        });
+    }
+
 Q_SIGNALS:
     void serviceAvailableChanged(bool available);
 
 private Q_SLOTS:
     void onServiceRegistered(const QString &service);
     void onServiceUnregistered(const QString &service);
+    void onRegistrationChecked(QDBusPendingCallWatcher *watcher);
 
 protected:
-    virtual QDBusAbstractInterface* createInterface(const QString &service, const QString &path,
-                                                    const QString &interface, const QDBusConnection &connection);
+    // The default implementation shares a non-introspecting interface with the other monitors.
+    virtual QSharedPointer<QDBusAbstractInterface> createInterface(const QString &service, const QString &path,
+                                                                   const QString &interface,
+                                                                   const QDBusConnection &connection);
+
+    QDBusConnection connection() const;
 
     const QString m_service;
     const QString m_path;
     const QString m_interface;
     const Bus m_bus;
     QDBusServiceWatcher* m_watcher;
-    QDBusAbstractInterface* m_dbusInterface;
+    QSharedPointer<QDBusAbstractInterface> m_dbusInterface;
+
+private:
+    template <typename Receiver, typename... Args, int... Is>
+    static void invoke(const QList<QVariant> &arguments, Receiver *receiver, void (Receiver::*slot)(Args...),
+                       DBusSignalArguments::Indexes<Is...>)
+    {
+        Q_UNUSED(arguments); // when there are none
+        (receiver->*slot)(qdbus_cast<typename std::decay<Args>::type>(arguments.at(Is))...);
+    }
+
+    // Set once the watcher said, which is more recent than what the initial check says
+    bool m_registrationKnown;
 };
 
 #endif // ABSTRACTDBUSSERVICEMONITOR_H
@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "inputlatencytracer.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QTextStream>
+
+#include <cstring>
+
+// Upper bounds of the histogram buckets, in milliseconds. The last bucket takes the rest.
+static const qint64 bucketLimitsMsecs[] = { 1, 2, 4, 8, 12, 16, 24, 33, 50, 67, 100, 200 };
+
+QAtomicInt InputLatencyTracer::s_enabled(0);
+
+InputLatencyTracer *InputLatencyTracer::instance()
+{
+    static InputLatencyTracer tracer;
+    return &tracer;
+}
+
+InputLatencyTracer::InputLatencyTracer()
+    : m_pendingInputNsecs(-1)
+    , m_nextEvent(0)
+{
+    Q_STATIC_ASSERT(sizeof(bucketLimitsMsecs) / sizeof(bucketLimitsMsecs[0]) == BucketCount - 1);
+    m_clock.start();
+    clear();
+}
+
+void InputLatencyTracer::setEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    if (enabled && m_events.isEmpty()) {
+        m_events.reserve(MaxEvents);
+    }
+    m_pendingInputNsecs = -1;
+    s_enabled.store(enabled ? 1 : 0);
+}
+
+void InputLatencyTracer::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    memset(m_histograms, 0, sizeof(m_histograms));
+    m_events.clear();
+    m_nextEvent = 0;
+    m_pendingInputNsecs = -1;
+}
+
+void InputLatencyTracer::record(Stage stage, const char *source)
+{
+    record(stage, source, m_clock.nsecsElapsed());
+}
+
+void InputLatencyTracer::record(Stage stage, const char *source, qint64 now)
+{
+    QMutexLocker locker(&m_mutex);
+
+    qint64 latency = -1;
+    if (stage == InputReceived) {
+        if (m_pendingInputNsecs == -1) {
+            m_pendingInputNsecs = now;
+        }
+        latency = 0;
+    } else if (m_pendingInputNsecs != -1) {
+        latency = now - m_pendingInputNsecs;
+
+        Histogram &histogram = m_histograms[stage];
+        int bucket = 0;
+        while (bucket < BucketCount - 1 && latency > bucketLimitsMsecs[bucket] * 1000000) {
+            ++bucket;
+        }
+        ++histogram.buckets[bucket];
+        ++histogram.count;
+        histogram.totalNsecs += latency;
+        histogram.maxNsecs = qMax(histogram.maxNsecs, latency);
+
+        if (stage == FrameSwapped) {
+            m_pendingInputNsecs = -1;
+        }
+    } else if (stage == FrameSwapped) {
+        // A frame nobody was waiting for, not worth logging
+        return;
+    }
+
+    const Event event = { now, latency, source, stage };
+    if (m_events.count() < MaxEvents) {
+        m_events.append(event);
+    } else {
+        m_events[m_nextEvent] = event;
+    }
+    m_nextEvent = (m_nextEvent + 1) % MaxEvents;
+}
+
+QString InputLatencyTracer::histograms() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    QString result;
+    QTextStream stream(&result);
+    for (int stage = GestureRecognized; stage < StageCount; ++stage) {
+        const Histogram &histogram = m_histograms[stage];
+        stream << stageName(static_cast<Stage>(stage)) << ": " << histogram.count << " samples";
+        if (histogram.count > 0) {
+            stream << ", mean " << histogram.totalNsecs / histogram.count / 1000 << " us"
+                   << ", max " << histogram.maxNsecs / 1000 << " us"
+                   << ", p50 " << bucketName(percentileBucket(histogram, 50))
+                   << ", p99 " << bucketName(percentileBucket(histogram, 99));
+        }
+        stream << "\n";
+
+        for (int bucket = 0; bucket < BucketCount; ++bucket) {
+            stream << "  " << bucketName(bucket) << ": " << histogram.buckets[bucket] << "\n";
+        }
+    }
+    return result;
+}
+
+// The bucket holding the given percentile of the samples, which mustn't be empty
+int InputLatencyTracer::percentileBucket(const Histogram &histogram, int percentile)
+{
+    // Rank of the sample, rounded up
+    const quint64 rank = (histogram.count * percentile + 99) / 100;
+
+    quint64 seen = 0;
+    for (int bucket = 0; bucket < BucketCount - 1; ++bucket) {
+        seen += histogram.buckets[bucket];
+        if (seen >= rank) {
+            return bucket;
+        }
+    }
+    return BucketCount - 1;
+}
+
+QString InputLatencyTracer::bucketName(int bucket)
+{
+    if (bucket < BucketCount - 1) {
+        return QStringLiteral("<= %1 ms").arg(bucketLimitsMsecs[bucket]);
+    }
+    return QStringLiteral("> %1 ms").arg(bucketLimitsMsecs[BucketCount - 2]);
+}
+
+bool InputLatencyTracer::writeTrace(const QString &path) const
+{
+    QJsonArray traceEvents;
+    {
+        QMutexLocker locker(&m_mutex);
+
+        const qint64 pid = QCoreApplication::applicationPid();
+        const int count = m_events.count();
+        const int oldest = count < MaxEvents ? 0 : m_nextEvent;
+        for (int i = 0; i < count; ++i) {
+            const Event &event = m_events[(oldest + i) % count];
+
+            QJsonObject args;
+            args[QStringLiteral("source")] = QString::fromLatin1(event.source);
+            if (event.latencyNsecs >= 0) {
+                args[QStringLiteral("latency_us")] = static_cast<double>(event.latencyNsecs / 1000);
+            }
+
+            QJsonObject traceEvent;
+            traceEvent[QStringLiteral("name")] = QString::fromLatin1(stageName(event.stage));
+            traceEvent[QStringLiteral("cat")] = QStringLiteral("input");
+            traceEvent[QStringLiteral("ph")] = QStringLiteral("i");
+            traceEvent[QStringLiteral("s")] = QStringLiteral("p");
+            traceEvent[QStringLiteral("ts")] = static_cast<double>(event.nsecs / 1000);
+            traceEvent[QStringLiteral("pid")] = static_cast<double>(pid);
+            traceEvent[QStringLiteral("tid")] = 0;
+            traceEvent[QStringLiteral("args")] = args;
+            traceEvents.append(traceEvent);
+
+            // Show the whole wait for the frame as a span
+            if (event.stage == FrameSwapped && event.latencyNsecs >= 0) {
+                QJsonObject span;
+                span[QStringLiteral("name")] = QStringLiteral("InputToPhoton");
+                span[QStringLiteral("cat")] = QStringLiteral("input");
+                span[QStringLiteral("ph")] = QStringLiteral("X");
+                span[QStringLiteral("ts")] = static_cast<double>((event.nsecs - event.latencyNsecs) / 1000);
+                span[QStringLiteral("dur")] = static_cast<double>(event.latencyNsecs / 1000);
+                span[QStringLiteral("pid")] = static_cast<double>(pid);
+                span[QStringLiteral("tid")] = 0;
+                traceEvents.append(span);
+            }
+        }
+    }
+
+    QJsonObject root;
+    root[QStringLiteral("traceEvents")] = traceEvents;
+    root[QStringLiteral("displayTimeUnit")] = QStringLiteral("ms");
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "InputLatencyTracer: Couldn't write trace to" << path << ":" << file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return true;
+}
+
+const char *InputLatencyTracer::stageName(Stage stage)
+{
+    switch (stage) {
+    case InputReceived:
+        return "InputReceived";
+    case GestureRecognized:
+        return "GestureRecognized";
+    case QmlDispatched:
+        return "QmlDispatched";
+    case FrameSwapped:
+        return "FrameSwapped";
+    default:
+        return "Unknown";
+    }
+}
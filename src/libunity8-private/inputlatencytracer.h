@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INPUTLATENCYTRACER_H
+#define INPUTLATENCYTRACER_H
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+/*
+ * Measures how long input takes to make it to the screen.
+ *
+ * Input handling code marks the stages an input event goes through. The
+ * latency of each stage is measured from the oldest input event that hasn't
+ * been followed by a frame yet, so FrameSwapped gives the input-to-photon time.
+ *
+ * Off by default, in which case mark() costs a single atomic load. It's
+ * toggled through the com.canonical.Unity8.Debugging DBus interface.
+ */
+class Q_DECL_EXPORT InputLatencyTracer
+{
+public:
+    enum Stage {
+        InputReceived,
+        GestureRecognized,
+        QmlDispatched,
+        FrameSwapped,
+        StageCount
+    };
+
+    static InputLatencyTracer *instance();
+
+    static bool isEnabled() { return s_enabled.load() != 0; }
+    void setEnabled(bool enabled);
+
+    // Can be called from any thread. source has to be a string literal.
+    static void mark(Stage stage, const char *source) {
+        if (isEnabled()) {
+            instance()->record(stage, source);
+        }
+    }
+
+    // Human readable per-stage latency histograms, with the median and the
+    // 99th percentile rounded up to their bucket
+    QString histograms() const;
+
+    // Writes the recorded events in the Chrome trace event format, for about:tracing or Trace Compass
+    bool writeTrace(const QString &path) const;
+
+    void clear();
+
+private:
+    InputLatencyTracer();
+
+    void record(Stage stage, const char *source);
+    void record(Stage stage, const char *source, qint64 now);
+
+    static const char *stageName(Stage stage);
+
+    static QAtomicInt s_enabled;
+
+    static const int BucketCount = 13;
+    static const int MaxEvents = 65536;
+
+    struct Histogram {
+        quint64 buckets[BucketCount];
+        quint64 count;
+        qint64 totalNsecs;
+        qint64 maxNsecs;
+    };
+
+    static int percentileBucket(const Histogram &histogram, int percentile);
+    static QString bucketName(int bucket);
+
+    struct Event {
+        qint64 nsecs;
+        qint64 latencyNsecs; // -1 if there was no input pending
+        const char *source;
+        Stage stage;
+    };
+
+    mutable QMutex m_mutex;
+    QElapsedTimer m_clock;
+    qint64 m_pendingInputNsecs; // -1 if all input made it to the screen already
+    Histogram m_histograms[StageCount];
+
+    // Circular, the oldest events get overwritten
+    QVector<Event> m_events;
+    int m_nextEvent;
+
+    friend class InputLatencyTracerTest;
+};
+
+#endif // INPUTLATENCYTRACER_H
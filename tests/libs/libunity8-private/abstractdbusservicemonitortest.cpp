@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "abstractdbusservicemonitor.h"
+
+#include <QtTest>
+#include <QDBusAbstractInterface>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QPointer>
+
+static const char *service = "com.canonical.Unity8.MonitorTest";
+static const char *path = "/com/canonical/Unity8/MonitorTest";
+static const char *interface = "com.canonical.Unity8.MonitorTest";
+
+class SignalReceiver : public QObject
+{
+public:
+    void onChanged(const QString &name, int value, const QStringList &tags)
+    {
+        names << name;
+        values << value;
+        lastTags = tags;
+    }
+
+    QStringList names;
+    QList<int> values;
+    QStringList lastTags;
+};
+
+static void emitChanged(const QVariantList &arguments)
+{
+    QDBusMessage message = QDBusMessage::createSignal(path, interface, QStringLiteral("Changed"));
+    message.setArguments(arguments);
+    QDBusConnection::sessionBus().send(message);
+}
+
+class AbstractDBusServiceMonitorTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void cleanup()
+    {
+        QDBusConnection::sessionBus().unregisterService(service);
+    }
+
+    void testServiceAlreadyUp()
+    {
+        QVERIFY(QDBusConnection::sessionBus().registerService(service));
+
+        AbstractDBusServiceMonitor monitor(service, path, interface);
+        QSignalSpy availableSpy(&monitor, &AbstractDBusServiceMonitor::serviceAvailableChanged);
+
+        // Not blocking on the bus to find out
+        QVERIFY(!monitor.serviceAvailable());
+        QVERIFY(monitor.dbusInterface() == nullptr);
+
+        // Done once the answer to the initial NameHasOwner call was handled
+        QTRY_VERIFY(monitor.findChildren<QDBusPendingCallWatcher*>().isEmpty());
+        QVERIFY(monitor.serviceAvailable());
+        QCOMPARE(availableSpy.count(), 1);
+        QCOMPARE(monitor.dbusInterface()->service(), QString(service));
+        QCOMPARE(monitor.dbusInterface()->path(), QString(path));
+        QCOMPARE(monitor.dbusInterface()->interface(), QString(interface));
+    }
+
+    void testServiceNotUp()
+    {
+        AbstractDBusServiceMonitor monitor(service, path, interface);
+        QSignalSpy availableSpy(&monitor, &AbstractDBusServiceMonitor::serviceAvailableChanged);
+
+        QTRY_VERIFY(monitor.findChildren<QDBusPendingCallWatcher*>().isEmpty());
+        QVERIFY(!monitor.serviceAvailable());
+        QCOMPARE(availableSpy.count(), 0);
+
+        QVERIFY(QDBusConnection::sessionBus().registerService(service));
+        QTRY_VERIFY(monitor.serviceAvailable());
+
+        QVERIFY(QDBusConnection::sessionBus().unregisterService(service));
+        QTRY_VERIFY(!monitor.serviceAvailable());
+        QVERIFY(monitor.dbusInterface() == nullptr);
+        QCOMPARE(availableSpy.count(), 2);
+    }
+
+    void testServiceAppearsWhileChecking()
+    {
+        AbstractDBusServiceMonitor monitor(service, path, interface);
+
+        // The bus answers that it's not there, then tells the watcher it is
+        QVERIFY(QDBusConnection::sessionBus().registerService(service));
+
+        QTRY_VERIFY(monitor.findChildren<QDBusPendingCallWatcher*>().isEmpty());
+        QTRY_VERIFY(monitor.serviceAvailable());
+    }
+
+    void testServiceDisappearsWhileChecking()
+    {
+        QVERIFY(QDBusConnection::sessionBus().registerService(service));
+
+        AbstractDBusServiceMonitor monitor(service, path, interface);
+        QSignalSpy availableSpy(&monitor, &AbstractDBusServiceMonitor::serviceAvailableChanged);
+
+        // As if it went away and the watcher got to say so before the answer to the check came in
+        QMetaObject::invokeMethod(&monitor, "onServiceUnregistered", Q_ARG(QString, service));
+
+        // Which is stale by then
+        QTRY_VERIFY(monitor.findChildren<QDBusPendingCallWatcher*>().isEmpty());
+        QVERIFY(!monitor.serviceAvailable());
+        QCOMPARE(availableSpy.count(), 1);
+        QCOMPARE(availableSpy.last().at(0).toBool(), false);
+    }
+
+    void testSharedInterface()
+    {
+        QVERIFY(QDBusConnection::sessionBus().registerService(service));
+
+        AbstractDBusServiceMonitor *monitor1 = new AbstractDBusServiceMonitor(service, path, interface);
+        AbstractDBusServiceMonitor *monitor2 = new AbstractDBusServiceMonitor(service, path, interface);
+        AbstractDBusServiceMonitor other(service, "/com/canonical/Unity8/MonitorTest/Other", interface);
+        QTRY_VERIFY(monitor1->serviceAvailable() && monitor2->serviceAvailable() && other.serviceAvailable());
+
+        QPointer<QDBusAbstractInterface> dbusInterface = monitor1->dbusInterface();
+        QCOMPARE(monitor2->dbusInterface(), dbusInterface.data());
+        QVERIFY(other.dbusInterface() != dbusInterface.data());
+
+        // Released along with the last monitor using it
+        delete monitor1;
+        QVERIFY(!dbusInterface.isNull());
+        delete monitor2;
+        QVERIFY(dbusInterface.isNull());
+        QVERIFY(other.dbusInterface() != nullptr);
+
+        // And created anew for the next one
+        AbstractDBusServiceMonitor monitor3(service, path, interface);
+        QTRY_VERIFY(monitor3.serviceAvailable());
+        QVERIFY(monitor3.dbusInterface() != nullptr);
+        QVERIFY(monitor3.dbusInterface() != other.dbusInterface());
+    }
+
+    void testSharedInterfaceReleasedWithService()
+    {
+        QVERIFY(QDBusConnection::sessionBus().registerService(service));
+
+        AbstractDBusServiceMonitor monitor1(service, path, interface);
+        AbstractDBusServiceMonitor monitor2(service, path, interface);
+        QTRY_VERIFY(monitor1.serviceAvailable() && monitor2.serviceAvailable());
+
+        QPointer<QDBusAbstractInterface> dbusInterface = monitor1.dbusInterface();
+        QVERIFY(QDBusConnection::sessionBus().unregisterService(service));
+        QTRY_VERIFY(!monitor1.serviceAvailable() && !monitor2.serviceAvailable());
+        QVERIFY(dbusInterface.isNull());
+    }
+
+    void testConnectToSignal()
+    {
+        QVERIFY(QDBusConnection::sessionBus().registerService(service));
+
+        AbstractDBusServiceMonitor monitor(service, path, interface);
+        SignalReceiver *receiver = new SignalReceiver;
+        SignalReceiver other;
+        QVERIFY(monitor.connectToSignal(QStringLiteral("Changed"), receiver, &SignalReceiver::onChanged));
+        QVERIFY(monitor.connectToSignal(QStringLiteral("Changed"), &other, &SignalReceiver::onChanged));
+
+        // Arguments demarshalled into the slot's types
+        emitChanged(QVariantList() << QStringLiteral("brightness") << 42 << QStringList({"a", "b"}));
+        QTRY_COMPARE(receiver->names, QStringList() << "brightness");
+        QCOMPARE(receiver->values, QList<int>() << 42);
+        QCOMPARE(receiver->lastTags, QStringList({"a", "b"}));
+
+        // Not enough of them, the slot isn't called
+        QTest::ignoreMessage(QtWarningMsg, "AbstractDBusServiceMonitor: Not enough arguments for \"Changed\"");
+        emitChanged(QVariantList() << QStringLiteral("volume"));
+        emitChanged(QVariantList() << QStringLiteral("volume") << 7 << QStringList());
+        QTRY_COMPARE(receiver->names, QStringList() << "brightness" << "volume");
+        QCOMPARE(receiver->values, QList<int>() << 42 << 7);
+
+        // Gone along with the receiver
+        delete receiver;
+        emitChanged(QVariantList() << QStringLiteral("last") << 0 << QStringList());
+        QTRY_COMPARE(other.names, QStringList() << "brightness" << "volume" << "last");
+    }
+
+    void testConnectToSignalWithHandler()
+    {
+        QVERIFY(QDBusConnection::sessionBus().registerService(service));
+
+        AbstractDBusServiceMonitor monitor(service, path, interface);
+        QObject context;
+        QList<QDBusMessage> messages;
+        QVERIFY(monitor.connectToSignal(QStringLiteral("Changed"), &context, [&messages](const QDBusMessage &message) {
+            messages << message;
+        }));
+
+        emitChanged(QVariantList() << QStringLiteral("brightness"));
+        QTRY_COMPARE(messages.count(), 1);
+        QCOMPARE(messages.first().member(), QString("Changed"));
+        QCOMPARE(messages.first().arguments().first().toString(), QString("brightness"));
+    }
+};
+
+QTEST_GUILESS_MAIN(AbstractDBusServiceMonitorTest)
+#include "abstractdbusservicemonitortest.moc"
@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "inputlatencytracer.h"
+#include "DebuggingController.h"
+
+#include <QtTest>
+#include <QDBusConnectionInterface>
+#include <QDBusInterface>
+#include <QDBusReply>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QQuickWindow>
+#include <QTemporaryDir>
+
+static const qint64 msecs = 1000000;
+
+class InputLatencyTracerTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    InputLatencyTracer *tracer;
+
+    // One sample per histogram bucket edge case, see the comments for the latencies
+    void recordSamples()
+    {
+        tracer->record(InputLatencyTracer::InputReceived, "test", 0);
+        // 1 ms, the upper bound of the first bucket
+        tracer->record(InputLatencyTracer::GestureRecognized, "test", 1 * msecs);
+        // Just above 1 ms
+        tracer->record(InputLatencyTracer::QmlDispatched, "test", 1 * msecs + 1);
+        // 250 ms, past the last limit
+        tracer->record(InputLatencyTracer::FrameSwapped, "test", 250 * msecs);
+
+        // Nothing pending, ignored
+        tracer->record(InputLatencyTracer::FrameSwapped, "test", 300 * msecs);
+
+        // Measured from the first input that was still waiting for a frame, 16 ms
+        tracer->record(InputLatencyTracer::InputReceived, "first", 400 * msecs);
+        tracer->record(InputLatencyTracer::InputReceived, "second", 405 * msecs);
+        tracer->record(InputLatencyTracer::FrameSwapped, "test", 416 * msecs);
+    }
+
+    QJsonArray readTrace(const QString &path)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return QJsonArray();
+        }
+        return QJsonDocument::fromJson(file.readAll()).object().value("traceEvents").toArray();
+    }
+
+private Q_SLOTS:
+
+    void init()
+    {
+        tracer = InputLatencyTracer::instance();
+        tracer->setEnabled(false);
+        tracer->clear();
+    }
+
+    void cleanup()
+    {
+        tracer->setEnabled(false);
+        tracer->clear();
+    }
+
+    void testMarkIgnoredWhenDisabled()
+    {
+        InputLatencyTracer::mark(InputLatencyTracer::InputReceived, "test");
+        InputLatencyTracer::mark(InputLatencyTracer::FrameSwapped, "test");
+        QCOMPARE(tracer->m_events.count(), 0);
+        QCOMPARE(tracer->m_histograms[InputLatencyTracer::FrameSwapped].count, (quint64)0);
+
+        tracer->setEnabled(true);
+        InputLatencyTracer::mark(InputLatencyTracer::InputReceived, "test");
+        InputLatencyTracer::mark(InputLatencyTracer::FrameSwapped, "test");
+        QCOMPARE(tracer->m_events.count(), 2);
+        QCOMPARE(tracer->m_histograms[InputLatencyTracer::FrameSwapped].count, (quint64)1);
+    }
+
+    void testBucketing()
+    {
+        recordSamples();
+
+        const InputLatencyTracer::Histogram &gesture = tracer->m_histograms[InputLatencyTracer::GestureRecognized];
+        QCOMPARE(gesture.count, (quint64)1);
+        QCOMPARE(gesture.buckets[0], (quint64)1);
+
+        const InputLatencyTracer::Histogram &qml = tracer->m_histograms[InputLatencyTracer::QmlDispatched];
+        QCOMPARE(qml.count, (quint64)1);
+        QCOMPARE(qml.buckets[0], (quint64)0);
+        QCOMPARE(qml.buckets[1], (quint64)1);
+
+        const InputLatencyTracer::Histogram &frame = tracer->m_histograms[InputLatencyTracer::FrameSwapped];
+        QCOMPARE(frame.count, (quint64)2);
+        QCOMPARE(frame.buckets[5], (quint64)1); // <= 16 ms
+        QCOMPARE(frame.buckets[InputLatencyTracer::BucketCount - 1], (quint64)1);
+        QCOMPARE(frame.totalNsecs, 266 * msecs);
+        QCOMPARE(frame.maxNsecs, 250 * msecs);
+    }
+
+    void testHistograms()
+    {
+        recordSamples();
+
+        const QStringList lines = tracer->histograms().split('\n', QString::SkipEmptyParts);
+        // Header and a line per bucket, for every stage but InputReceived
+        QCOMPARE(lines.count(), 3 * (1 + InputLatencyTracer::BucketCount));
+
+        const int gesture = lines.indexOf("GestureRecognized: 1 samples, mean 1000 us, max 1000 us, p50 <= 1 ms, p99 <= 1 ms");
+        QVERIFY(gesture != -1);
+        QCOMPARE(lines.at(gesture + 1), QString("  <= 1 ms: 1"));
+
+        const int qml = lines.indexOf("QmlDispatched: 1 samples, mean 1000 us, max 1000 us, p50 <= 2 ms, p99 <= 2 ms");
+        QVERIFY(qml != -1);
+        QCOMPARE(lines.at(qml + 1), QString("  <= 1 ms: 0"));
+        QCOMPARE(lines.at(qml + 2), QString("  <= 2 ms: 1"));
+
+        const int frame = lines.indexOf("FrameSwapped: 2 samples, mean 133000 us, max 250000 us, p50 <= 16 ms, p99 > 200 ms");
+        QVERIFY(frame != -1);
+        QCOMPARE(lines.at(frame + 6), QString("  <= 16 ms: 1"));
+        QCOMPARE(lines.at(frame + InputLatencyTracer::BucketCount), QString("  > 200 ms: 1"));
+    }
+
+    void testHistogramsWithoutSamples()
+    {
+        const QStringList lines = tracer->histograms().split('\n', QString::SkipEmptyParts);
+        QVERIFY(lines.contains("FrameSwapped: 0 samples"));
+        QVERIFY(lines.contains("  > 200 ms: 0"));
+    }
+
+    void testWriteTrace()
+    {
+        recordSamples();
+
+        QTemporaryDir dir;
+        const QString path = dir.path() + "/trace.json";
+        QVERIFY(tracer->writeTrace(path));
+
+        const QJsonArray events = readTrace(path);
+        // 7 marks, plus a span for each frame that had input waiting
+        QCOMPARE(events.count(), 9);
+
+        QStringList names;
+        Q_FOREACH (const QJsonValue &value, events) {
+            names << value.toObject().value("name").toString();
+        }
+        QCOMPARE(names, QStringList() << "InputReceived" << "GestureRecognized" << "QmlDispatched"
+                                      << "FrameSwapped" << "InputToPhoton"
+                                      << "InputReceived" << "InputReceived"
+                                      << "FrameSwapped" << "InputToPhoton");
+
+        const QJsonObject qml = events.at(2).toObject();
+        QCOMPARE(qml.value("cat").toString(), QString("input"));
+        QCOMPARE(qml.value("ph").toString(), QString("i"));
+        QCOMPARE(qml.value("ts").toDouble(), 1000.0);
+        QCOMPARE(qml.value("pid").toDouble(), (double)QCoreApplication::applicationPid());
+        QCOMPARE(qml.value("args").toObject().value("source").toString(), QString("test"));
+        QCOMPARE(qml.value("args").toObject().value("latency_us").toDouble(), 1000.0);
+
+        const QJsonObject second = events.at(6).toObject();
+        QCOMPARE(second.value("args").toObject().value("source").toString(), QString("second"));
+
+        const QJsonObject span = events.at(8).toObject();
+        QCOMPARE(span.value("ph").toString(), QString("X"));
+        QCOMPARE(span.value("ts").toDouble(), 400000.0);
+        QCOMPARE(span.value("dur").toDouble(), 16000.0);
+    }
+
+    void testWriteTraceFails()
+    {
+        QTest::ignoreMessage(QtWarningMsg, QRegularExpression("InputLatencyTracer: Couldn't write trace to.*"));
+        QVERIFY(!tracer->writeTrace("/nonexistent/trace.json"));
+    }
+
+    void testDebuggingController()
+    {
+        QQuickWindow window;
+        DebuggingController controller;
+        QTRY_VERIFY(QDBusConnection::sessionBus().interface()->isServiceRegistered("com.canonical.Unity8"));
+
+        QDBusInterface debugging("com.canonical.Unity8",
+                                 "/com/canonical/Unity8/Debugging",
+                                 "com.canonical.Unity8.Debugging");
+
+        // Starting over throws away what was there
+        recordSamples();
+        QVERIFY(debugging.call("SetInputLatencyTracing", true).type() != QDBusMessage::ErrorMessage);
+        QVERIFY(InputLatencyTracer::isEnabled());
+        QCOMPARE(tracer->m_events.count(), 0);
+
+        // Frames of the shell windows get picked up
+        InputLatencyTracer::mark(InputLatencyTracer::InputReceived, "test");
+        Q_EMIT window.frameSwapped();
+        QCOMPARE(tracer->m_histograms[InputLatencyTracer::FrameSwapped].count, (quint64)1);
+
+        QDBusReply<QString> histograms = debugging.call("GetInputLatencyHistograms");
+        QVERIFY(histograms.isValid());
+        QCOMPARE(histograms.value(), tracer->histograms());
+        QVERIFY(histograms.value().contains("FrameSwapped: 1 samples"));
+
+        // Always to the same file in the cache, callers don't get to pick
+        QTemporaryDir cacheDir;
+        qputenv("XDG_CACHE_HOME", cacheDir.path().toUtf8());
+        QDBusReply<QString> written = debugging.call("WriteInputLatencyTrace");
+        QVERIFY(written.isValid());
+        QCOMPARE(written.value(), cacheDir.path() + "/unity8/input-latency.json");
+        QCOMPARE(readTrace(written.value()).count(), 3);
+
+        QDBusMessage withPath = debugging.call("WriteInputLatencyTrace", cacheDir.path() + "/trace.json");
+        QCOMPARE(withPath.type(), QDBusMessage::ErrorMessage);
+        QVERIFY(!QFile::exists(cacheDir.path() + "/trace.json"));
+
+        QVERIFY(debugging.call("SetInputLatencyTracing", false).type() != QDBusMessage::ErrorMessage);
+        QVERIFY(!InputLatencyTracer::isEnabled());
+
+        // Not listening to the frames anymore, nor keeping what came in
+        InputLatencyTracer::mark(InputLatencyTracer::InputReceived, "test");
+        Q_EMIT window.frameSwapped();
+        QCOMPARE(tracer->m_histograms[InputLatencyTracer::FrameSwapped].count, (quint64)1);
+        QCOMPARE(tracer->m_events.count(), 2);
+    }
+};
+
+QTEST_MAIN(InputLatencyTracerTest)
+#include "inputlatencytracertest.moc"
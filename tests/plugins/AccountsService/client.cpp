@@ -23,6 +23,7 @@
 #include <QSignalSpy>
 #include <QTest>
 #include <QDebug>
+#include <QDBusInterface>
 #include <QDBusReply>
 #include <QDBusMetaType>
 
@@ -59,6 +60,24 @@ public:
         qDBusRegisterMetaType<StringMapList>();
     }
 
+private:
+
+    // Nothing is sent for a user before it was looked up
+    void waitForUser(AccountsServiceDBusAdaptor &session, const QString &user)
+    {
+        bool found = false;
+        session.whenUserFound(user, this, [&found]() { found = true; });
+        QTRY_VERIFY(found);
+    }
+
+    QString realNameOnServer()
+    {
+        auto message = m_userInterface->call("Get",
+                                             "org.freedesktop.Accounts.User",
+                                             "RealName");
+        return message.arguments().value(0).value<QDBusVariant>().variant().toString();
+    }
+
 private Q_SLOTS:
 
     void init() {
@@ -92,13 +111,140 @@ private Q_SLOTS:
     {
         // Test various invalid calls
         AccountsServiceDBusAdaptor session;
+        waitForUser(session, "NOPE");
+        waitForUser(session, QTest::currentTestFunction());
         QCOMPARE(session.getUserPropertyAsync("NOPE", "com.canonical.unity.AccountsService", "demo-edges").value(), QVariant());
         QCOMPARE(session.getUserPropertyAsync(QTest::currentTestFunction(), "com.canonical.unity.AccountsService", "NOPE").value(), QVariant());
     }
 
+    void testCallsBeforeLookupFail()
+    {
+        // Nothing waits for the lookup, the calls fail until it's done
+        AccountsServiceDBusAdaptor session;
+        QDBusPendingReply<QVariant> reply = session.getUserPropertyAsync(QTest::currentTestFunction(), "com.canonical.unity.AccountsService", "demo-edges");
+        QVERIFY(reply.isFinished());
+        QVERIFY(reply.isError());
+        QVERIFY(session.m_pendingUsers.contains(QTest::currentTestFunction()));
+
+        waitForUser(session, QTest::currentTestFunction());
+        QCOMPARE(session.getUserPropertyAsync(QTest::currentTestFunction(), "com.canonical.unity.AccountsService", "demo-edges").value(), QVariant(false));
+    }
+
+    void testUserLookupIsCached()
+    {
+        AccountsServiceDBusAdaptor session;
+        const QString user = QTest::currentTestFunction();
+
+        int found = 0;
+        session.whenUserFound(user, this, [&found]() { found++; });
+        session.whenUserFound(user, this, [&found]() { found++; });
+        QCOMPARE(found, 0);
+        QCOMPARE(session.m_pendingUsers.count(), 1);
+        QTRY_COMPARE(found, 2);
+
+        QVERIFY(session.m_users.contains(user));
+        QCOMPARE(session.getUserForPath(QString("/%1").arg(user)), user);
+
+        // Known now, so no new lookup and no waiting
+        session.whenUserFound(user, this, [&found]() { found++; });
+        QCOMPARE(found, 3);
+        QVERIFY(session.m_pendingUsers.isEmpty());
+    }
+
+    void testUserLookupWithoutContext()
+    {
+        AccountsServiceDBusAdaptor session;
+        bool called = false;
+        QObject *context = new QObject;
+        session.whenUserFound(QTest::currentTestFunction(), context, [&called]() { called = true; });
+        delete context;
+
+        waitForUser(session, QTest::currentTestFunction());
+        QCOMPARE(called, false);
+    }
+
+    void testConcurrentGetAllShareOneCall()
+    {
+        AccountsServiceDBusAdaptor session;
+        const QString user = QTest::currentTestFunction();
+        const QString interface = "com.canonical.unity.AccountsService";
+        waitForUser(session, user);
+
+        QDBusPendingReply<QVariantMap> reply1 = session.getAllPropertiesAsync(user, interface);
+        QDBusPendingCallWatcher *fetching = session.m_properties[user][interface].fetching;
+        QVERIFY(fetching != nullptr);
+        QDBusPendingReply<QVariantMap> reply2 = session.getAllPropertiesAsync(user, interface);
+        QCOMPARE(session.m_properties[user][interface].fetching, fetching);
+
+        reply1.waitForFinished();
+        reply2.waitForFinished();
+        QCOMPARE(reply1.value().value("demo-edges"), QVariant(false));
+        QCOMPARE(reply2.value().value("demo-edges"), QVariant(false));
+
+        // Once done, the values are cached and the next caller gets a call of its own
+        QTRY_VERIFY(session.m_properties[user][interface].fetching == nullptr);
+        QVariant value;
+        QVERIFY(session.cachedProperty(user, interface, "demo-edges", &value));
+        QCOMPARE(value, QVariant(false));
+    }
+
+    void testPropertiesChangedUpdatesCache()
+    {
+        AccountsServiceDBusAdaptor session;
+        QSignalSpy changedSpy(&session, &AccountsServiceDBusAdaptor::propertiesChanged);
+        const QString user = QTest::currentTestFunction();
+        const QString interface = "com.canonical.unity.AccountsService";
+        waitForUser(session, user);
+
+        session.getAllPropertiesAsync(user, interface).waitForFinished();
+        QTRY_VERIFY(session.m_properties[user][interface].fetching == nullptr);
+        const int generation = session.m_properties[user][interface].generation;
+        QVariant value;
+        QVERIFY(session.cachedProperty(user, interface, "demo-edges", &value));
+        QCOMPARE(value, QVariant(false));
+
+        ASSERT_DBUS_CALL(m_userInterface->call("Set", interface, "demo-edges", dbusVariant(true)));
+        QTRY_COMPARE(changedSpy.count(), 1);
+        QCOMPARE(changedSpy.first().at(2).toStringList(), QStringList() << "demo-edges");
+
+        // Replies to GetAll calls sent before the change would be dropped
+        QVERIFY(session.m_properties[user][interface].generation > generation);
+        QVERIFY(session.cachedProperty(user, interface, "demo-edges", &value));
+        QCOMPARE(value, QVariant(true));
+    }
+
+    void testCompleteCacheAfterGetAll()
+    {
+        AccountsServiceDBusAdaptor session;
+        const QString user = QTest::currentTestFunction();
+        const QString interface = "com.canonical.unity.AccountsService";
+        waitForUser(session, user);
+
+        // Nothing fetched yet
+        QVariantMap values;
+        QVERIFY(!session.cachedProperties(user, interface, &values));
+
+        session.getAllPropertiesAsync(user, interface).waitForFinished();
+        QTRY_VERIFY(session.m_properties[user][interface].fetching == nullptr);
+        QVERIFY(session.cachedProperties(user, interface, &values));
+        QCOMPARE(values.value("demo-edges"), QVariant(false));
+
+        // Still complete with the changes merged in
+        QSignalSpy changedSpy(&session, &AccountsServiceDBusAdaptor::propertiesChanged);
+        ASSERT_DBUS_CALL(m_userInterface->call("Set", interface, "demo-edges", dbusVariant(true)));
+        QTRY_COMPARE(changedSpy.count(), 1);
+        QVERIFY(session.cachedProperties(user, interface, &values));
+        QCOMPARE(values.value("demo-edges"), QVariant(true));
+
+        // But not while waiting to hear back about our own change
+        session.setUserPropertyAsync(user, interface, "demo-edges", QVariant(false)).waitForFinished();
+        QVERIFY(!session.cachedProperties(user, interface, &values));
+    }
+
     void testGetSetServiceDBusAdaptor()
     {
         AccountsServiceDBusAdaptor session;
+        waitForUser(session, QTest::currentTestFunction());
         session.setUserPropertyAsync(QTest::currentTestFunction(), "com.canonical.unity.AccountsService", "demo-edges", QVariant(true)).waitForFinished();
         QCOMPARE(session.getUserPropertyAsync(QTest::currentTestFunction(), "com.canonical.unity.AccountsService", "demo-edges").value(), QVariant(true));
         session.setUserPropertyAsync(QTest::currentTestFunction(), "com.canonical.unity.AccountsService", "demo-edges", QVariant(false)).waitForFinished();
@@ -122,6 +268,61 @@ private Q_SLOTS:
         QCOMPARE(session.hereEnabled(), true);
     }
 
+    void testFirstValuesAreRight()
+    {
+        QDBusInterface accountsIface(m_userInterface->service(),
+                                     m_userInterface->path(),
+                                     "org.freedesktop.Accounts.User");
+        ASSERT_DBUS_CALL(accountsIface.call("SetBackgroundFile", "/test/BackgroundFile"));
+        ASSERT_DBUS_CALL(m_userInterface->call("Set",
+                                               "com.canonical.unity.AccountsService",
+                                               "demo-edges",
+                                               dbusVariant(true)));
+        ASSERT_DBUS_CALL(m_userInterface->call("Set",
+                                               "com.ubuntu.AccountsService.SecurityPrivacy",
+                                               "EnableLauncherWhileLocked",
+                                               dbusVariant(false)));
+        ASSERT_DBUS_CALL(m_userInterface->call("Set",
+                                               "com.ubuntu.AccountsService.SecurityPrivacy",
+                                               "EnableIndicatorsWhileLocked",
+                                               dbusVariant(false)));
+
+        // No waiting, the greeter shows whatever is there from the start
+        AccountsService session(this, QTest::currentTestFunction());
+        QCOMPARE(session.backgroundFile(), QString("/test/BackgroundFile"));
+        QCOMPARE(session.demoEdges(), true);
+        QCOMPARE(session.enableLauncherWhileLocked(), false);
+        QCOMPARE(session.enableIndicatorsWhileLocked(), false);
+    }
+
+    void testSwitchingBackUsesCache()
+    {
+        const QString user = QTest::currentTestFunction();
+        const QString other = user + "Other";
+        QDBusInterface accounts("org.freedesktop.Accounts",
+                                "/org/freedesktop/Accounts",
+                                "org.freedesktop.Accounts");
+        QCOMPARE(QDBusReply<bool>(accounts.call("AddUser", other)).value(), true);
+        ASSERT_DBUS_CALL(m_userInterface->call("Set",
+                                               "com.canonical.unity.AccountsService",
+                                               "demo-edges",
+                                               dbusVariant(true)));
+
+        AccountsService session(this, user);
+        QCOMPARE(session.demoEdges(), true);
+
+        // Later switches don't block
+        session.setUser(other);
+        QCOMPARE(session.demoEdges(), true);
+        QTRY_COMPARE(session.demoEdges(), false);
+
+        // Nothing changed meanwhile, so the values are there without asking again
+        session.setUser(user);
+        QCOMPARE(session.demoEdges(), true);
+
+        QCOMPARE(QDBusReply<bool>(accounts.call("RemoveUser", other)).value(), true);
+    }
+
     void testMarkDemoEdgeCompleted()
     {
         AccountsService session(this, QTest::currentTestFunction());
@@ -187,7 +388,7 @@ private Q_SLOTS:
     {
         AccountsService session(this, QTest::currentTestFunction());
 
-        QCOMPARE(session.statsWelcomeScreen(), true);
+        QTRY_COMPARE(session.statsWelcomeScreen(), true);
         ASSERT_DBUS_CALL(m_userInterface->asyncCall("Set",
                                                     "com.ubuntu.touch.AccountsService.SecurityPrivacy",
                                                     "StatsWelcomeScreen",
@@ -199,7 +400,7 @@ private Q_SLOTS:
     {
         AccountsService session(this, QTest::currentTestFunction());
 
-        QCOMPARE(session.enableLauncherWhileLocked(), true);
+        QTRY_COMPARE(session.enableLauncherWhileLocked(), true);
         ASSERT_DBUS_CALL(m_userInterface->asyncCall("Set",
                                                     "com.ubuntu.AccountsService.SecurityPrivacy",
                                                     "EnableLauncherWhileLocked",
@@ -211,7 +412,7 @@ private Q_SLOTS:
     {
         AccountsService session(this, QTest::currentTestFunction());
 
-        QCOMPARE(session.enableIndicatorsWhileLocked(), true);
+        QTRY_COMPARE(session.enableIndicatorsWhileLocked(), true);
         ASSERT_DBUS_CALL(m_userInterface->asyncCall("Set",
                                                     "com.ubuntu.AccountsService.SecurityPrivacy",
                                                     "EnableIndicatorsWhileLocked",
@@ -335,12 +536,8 @@ private Q_SLOTS:
 
         QCOMPARE(session.realName(), QStringLiteral("Stallman"));
 
-        message = m_userInterface->call("Get",
-                                        "org.freedesktop.Accounts.User",
-                                        "RealName");
-        QCOMPARE(message.type(), QDBusMessage::ReplyMessage);
-        response = message.arguments().first().value<QDBusVariant>().variant().toString();
-        QCOMPARE(response, QStringLiteral("Stallman"));
+        // Sent once the user was looked up
+        QTRY_COMPARE(realNameOnServer(), QStringLiteral("Stallman"));
 
     }
 
@@ -14,12 +14,15 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "cardcreator.h"
+
 #include <QDir>
+#include <QJsonDocument>
+#include <QQmlComponent>
 #include <QQmlEngine>
-#include <QQuickItem>
-#include <QQuickView>
 #include <QtTestGui>
 #include <QDebug>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
 
 #include <paths.h>
@@ -32,22 +35,21 @@ private Q_SLOTS:
 
     void initTestCase()
     {
+        // Keep the card cache out of the user one
+        QVERIFY(cacheHome.isValid());
+        qputenv("XDG_CACHE_HOME", cacheHome.path().toUtf8());
     }
 
     void init()
     {
-        view = new QQuickView();
-        if (isRunningInstalled())
-            view->setSource(QUrl::fromLocalFile(testLibDir() + "/" TEST_DIR "/cardcreatortest.qml"));
-        else
-            view->setSource(QUrl::fromLocalFile(testDataDir() + "/" TEST_DIR "/cardcreatortest.qml"));
-        view->show();
-        QTest::qWaitForWindowExposed(view);
+        engine = new QQmlEngine();
+        creator = new CardCreator(engine);
     }
 
     void cleanup()
     {
-        delete view;
+        delete creator;
+        delete engine;
     }
 
     void compareFileContents(const QString &filePath, const QString cardStringResult)
@@ -96,29 +98,94 @@ private Q_SLOTS:
             QVERIFY(lines[2].startsWith(artShapeStyleString));
             QVERIFY(lines[3].startsWith(resultString));
 
-            const QString templateJSON = lines[0].mid(templateString.length());
-            const QString componentsJSON = lines[1].mid(componentsString.length());
+            const QVariant cardTemplate = QJsonDocument::fromJson(lines[0].mid(templateString.length()).toUtf8()).toVariant();
+            const QVariant components = QJsonDocument::fromJson(lines[1].mid(componentsString.length()).toUtf8()).toVariant();
             const QString artShapeStyle = lines[2].mid(artShapeStyleString.length());
             const QString resultFileName = lines[3].mid(resultString.length());
-            QVariant cardStringResult;
-            QVariant createCardComponentResult;
-
-            QMetaObject::invokeMethod(view->rootObject(), "cardString", Q_RETURN_ARG(QVariant, cardStringResult), Q_ARG(QVariant, templateJSON), Q_ARG(QVariant, componentsJSON), Q_ARG(QVariant, false), Q_ARG(QVariant, artShapeStyle));
-            compareFileContents(testDirPath + resultFileName, cardStringResult.toString());
+            const CardDescription description = CardDescription::fromVariant(cardTemplate, components);
 
-            QMetaObject::invokeMethod(view->rootObject(), "cardString", Q_RETURN_ARG(QVariant, cardStringResult), Q_ARG(QVariant, templateJSON), Q_ARG(QVariant, componentsJSON), Q_ARG(QVariant, true), Q_ARG(QVariant, artShapeStyle));
-            compareFileContents(testDirPath + resultFileName + ".cardcreator", cardStringResult.toString());
+            compareFileContents(testDirPath + resultFileName, CardCreator::cardString(description, false, artShapeStyle, QString()));
+            compareFileContents(testDirPath + resultFileName + ".cardcreator", CardCreator::cardString(description, true, artShapeStyle, QString()));
 
-            QMetaObject::invokeMethod(view->rootObject(), "createCardComponent", Q_RETURN_ARG(QVariant, createCardComponentResult), Q_ARG(QVariant, templateJSON), Q_ARG(QVariant, componentsJSON), Q_ARG(QVariant, false), Q_ARG(QVariant, artShapeStyle));
-            QVERIFY(createCardComponentResult.toBool());
+            QQmlComponent *component = creator->getCardComponent(cardTemplate, components, false, artShapeStyle, QString());
+            QVERIFY(component);
+            QTRY_VERIFY(!component->isLoading());
+            QVERIFY2(component->isReady(), qPrintable(component->errorString()));
 
-            QMetaObject::invokeMethod(view->rootObject(), "createCardComponent", Q_RETURN_ARG(QVariant, createCardComponentResult), Q_ARG(QVariant, templateJSON), Q_ARG(QVariant, componentsJSON), Q_ARG(QVariant, true), Q_ARG(QVariant, artShapeStyle));
-            QVERIFY(createCardComponentResult.toBool());
+            component = creator->getCardComponent(cardTemplate, components, true, artShapeStyle, QString());
+            QVERIFY(component);
+            QTRY_VERIFY(!component->isLoading());
+            QVERIFY2(component->isReady(), qPrintable(component->errorString()));
         }
     }
 
+    void testComponentCache()
+    {
+        const QVariantMap cardTemplate = QJsonDocument::fromJson("{\"card-layout\":\"horizontal\"}").toVariant().toMap();
+        const QVariantMap components = QJsonDocument::fromJson("{\"title\":{\"field\":\"title\"},\"art\":{\"field\":\"art\"}}").toVariant().toMap();
+
+        QQmlComponent *component = creator->getCardComponent(cardTemplate, components, false, "flat", "grid");
+        QVERIFY(component);
+
+        // Field names don't change the card
+        QVariantMap otherComponents = components;
+        otherComponents["title"] = QJsonDocument::fromJson("{\"field\":\"name\"}").toVariant();
+        QCOMPARE(creator->getCardComponent(cardTemplate, otherComponents, false, "flat", "grid"), component);
+
+        QVERIFY(creator->getCardComponent(cardTemplate, components, true, "flat", "grid") != component);
+        QVERIFY(creator->getCardComponent(cardTemplate, components, false, "shadow", "grid") != component);
+        QVERIFY(creator->getCardComponent(cardTemplate, components, false, "flat", "carousel") != component);
+
+        otherComponents = components;
+        otherComponents.remove("art");
+        QVERIFY(creator->getCardComponent(cardTemplate, otherComponents, false, "flat", "grid") != component);
+
+        QVERIFY(!creator->getCardComponent(QVariant(), components, false, "flat", "grid"));
+    }
+
+    void testDiskCache()
+    {
+        const QVariantMap cardTemplate = QJsonDocument::fromJson("{\"card-layout\":\"vertical\"}").toVariant().toMap();
+        const QVariantMap components = QJsonDocument::fromJson("{\"title\":{\"field\":\"title\"}}").toVariant().toMap();
+
+        QDir(CardCreator::cacheDirectory()).removeRecursively();
+        delete creator;
+        creator = new CardCreator(engine);
+        QVERIFY(creator->m_fileComponents.isEmpty());
+
+        QQmlComponent *component = creator->getCardComponent(cardTemplate, components, false, "flat", "grid");
+        QVERIFY(component);
+        QTRY_VERIFY(component->isReady());
+        QCOMPARE(creator->m_uses.count(), 1);
+
+        // The index is written when the creator goes away
+        delete creator;
+        creator = new CardCreator(engine);
+
+        // The card of the previous session is being loaded already
+        QCOMPARE(creator->m_uses.count(), 1);
+        QCOMPARE(creator->m_fileComponents.count(), 1);
+        QQmlComponent *prewarmed = creator->m_fileComponents.values().first();
+        QCOMPARE(creator->getCardComponent(cardTemplate, components, false, "flat", "grid"), prewarmed);
+        QTRY_VERIFY(prewarmed->isReady());
+        QCOMPARE(creator->m_uses.values().first(), 2);
+
+        // An index of another version wipes the cache
+        delete creator;
+        QFile index(CardCreator::cacheDirectory() + "index.json");
+        QVERIFY(index.open(QIODevice::WriteOnly));
+        index.write("{\"version\":\"0\",\"uses\":{}}");
+        index.close();
+        creator = new CardCreator(engine);
+        QVERIFY(creator->m_uses.isEmpty());
+        QVERIFY(creator->m_fileComponents.isEmpty());
+        QCOMPARE(QDir(CardCreator::cacheDirectory()).entryList(QDir::Files), QStringList());
+    }
+
 private:
-    QQuickView *view;
+    QTemporaryDir cacheHome;
+    QQmlEngine *engine;
+    CardCreator *creator;
 };
 
 QTEST_MAIN(CardCreatorTest)
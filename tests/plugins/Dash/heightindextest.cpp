@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "heightindex.h"
+
+#include <QTest>
+
+class HeightIndexTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testEmpty()
+    {
+        HeightIndex index;
+        QCOMPARE(index.count(), 0);
+        QCOMPARE(index.totalHeight(), 0.);
+        QCOMPARE(index.position(0), 0.);
+        QCOMPARE(index.indexAt(100), -1);
+    }
+
+    void testMeasured()
+    {
+        HeightIndex index;
+        index.reset(5);
+        for (int i = 0; i < 5; ++i) {
+            index.setHeight(i, 10 * (i + 1));
+        }
+
+        QCOMPARE(index.totalHeight(), 150.);
+        QCOMPARE(index.position(0), 0.);
+        QCOMPARE(index.position(1), 10.);
+        QCOMPARE(index.position(3), 60.);
+        QCOMPARE(index.position(5), 150.);
+
+        QCOMPARE(index.indexAt(0), 0);
+        QCOMPARE(index.indexAt(9.5), 0);
+        QCOMPARE(index.indexAt(10), 1);
+        QCOMPARE(index.indexAt(59), 2);
+        QCOMPARE(index.indexAt(60), 3);
+        QCOMPARE(index.indexAt(149), 4);
+        QCOMPARE(index.indexAt(1000), 4);
+
+        index.setHeight(0, 50);
+        QCOMPARE(index.totalHeight(), 190.);
+        QCOMPARE(index.position(3), 100.);
+        QCOMPARE(index.indexAt(55), 1);
+    }
+
+    void testEstimated()
+    {
+        HeightIndex index;
+        index.reset(10);
+        index.setHeight(0, 20);
+        index.setHeight(1, 40);
+
+        QCOMPARE(index.estimatedHeight(), 30.);
+        QCOMPARE(index.totalHeight(), 300.);
+        QCOMPARE(index.position(2), 60.);
+        QCOMPARE(index.position(4), 120.);
+        QCOMPARE(index.indexAt(125), 4);
+
+        index.invalidate(1);
+        QVERIFY(!index.isMeasured(1));
+        QCOMPARE(index.estimatedHeight(), 20.);
+        QCOMPARE(index.totalHeight(), 200.);
+    }
+
+    void testInsertRemove()
+    {
+        HeightIndex index;
+        index.reset(4);
+        for (int i = 0; i < 4; ++i) {
+            index.setHeight(i, 10 * (i + 1));
+        }
+
+        index.insert(1, 2);
+        QCOMPARE(index.count(), 6);
+        QVERIFY(index.isMeasured(0));
+        QVERIFY(!index.isMeasured(1));
+        QVERIFY(!index.isMeasured(2));
+        QVERIFY(index.isMeasured(3));
+        QCOMPARE(index.position(3), 10. + 2 * index.estimatedHeight());
+
+        index.remove(0, 3);
+        QCOMPARE(index.count(), 3);
+        QCOMPARE(index.totalHeight(), 90.);
+        QCOMPARE(index.position(1), 20.);
+        QCOMPARE(index.indexAt(55), 2);
+    }
+};
+
+QTEST_GUILESS_MAIN(HeightIndexTest)
+
+#include "heightindextest.moc"
@@ -224,12 +224,9 @@ private Q_SLOTS:
         verifyItem(2, 230, 350., false);
         verifyItem(3, 580, 350., true);
         // Just here as first check against m_minYExtent when m_firstVisibleIndex is not 0
-        // We as humans know that m_minYExtent will be 0 but since the first delegate is not there anymore
-        // we have to estimate its size, the average item height is 312.5 which is 162.5 more than the
-        // "real" size of 150 and that's why the m_minYExtent has that "peculiar" value
-        // It's fine since what it means is that we could scroll more up than the original position
-        // but we will recalculate m_minYExtent when the item 0 is created and set it correctly
-        QCOMPARE(lvwph->m_minYExtent, 162.5);
+        // The first delegate is not there anymore but its height was remembered
+        // when it was created so m_minYExtent is exactly 0
+        QCOMPARE(lvwph->m_minYExtent, 0.);
         QCOMPARE(lvwph->m_clipItem->y(), 520.);
         QCOMPARE(lvwph->m_clipItem->clip(), false);
         QCOMPARE(lvwph->m_headerItem->y(), 0.);
@@ -337,7 +334,7 @@ private Q_SLOTS:
         verifyItem(1, -120, 350., false);
         verifyItem(2, 230, 350., false);
         verifyItem(3, 580, 350., true);
-        QCOMPARE(lvwph->m_minYExtent, 162.5);
+        QCOMPARE(lvwph->m_minYExtent, 0.);
         QCOMPARE(lvwph->m_clipItem->y(), 520.);
         QCOMPARE(lvwph->m_clipItem->clip(), false);
         QCOMPARE(lvwph->m_headerItem->y(), 0.);
@@ -443,7 +440,7 @@ private Q_SLOTS:
         verifyItem(1, -120, 350., false);
         verifyItem(2, 230, 350., false);
         verifyItem(3, 580, 350., true);
-        QCOMPARE(lvwph->m_minYExtent, 162.5);
+        QCOMPARE(lvwph->m_minYExtent, 0.);
         QCOMPARE(lvwph->m_clipItem->y(), 520.);
         QCOMPARE(lvwph->m_clipItem->clip(), false);
         QCOMPARE(lvwph->m_headerItem->y(), 0.);
@@ -459,7 +456,7 @@ private Q_SLOTS:
         verifyItem(1, -120, 350., false);
         verifyItem(2, 230, 350., false);
         verifyItem(3, 580, 350., true);
-        QCOMPARE(lvwph->m_minYExtent, 162.5);
+        QCOMPARE(lvwph->m_minYExtent, 0.);
         QCOMPARE(lvwph->m_clipItem->y(), 520.);
         QCOMPARE(lvwph->m_clipItem->clip(), false);
         QCOMPARE(lvwph->m_headerItem->y(), 0.);
@@ -804,7 +801,7 @@ private Q_SLOTS:
         verifyItem(1, -120, 350., false);
         verifyItem(2, 230, 350., false);
         verifyItem(3, 580, 350., true);
-        QCOMPARE(lvwph->m_minYExtent, 162.5);
+        QCOMPARE(lvwph->m_minYExtent, 0.);
         QCOMPARE(lvwph->m_clipItem->y(), 520.);
         QCOMPARE(lvwph->m_clipItem->clip(), false);
         QCOMPARE(lvwph->m_headerItem->y(), 0.);
@@ -1095,7 +1092,7 @@ private Q_SLOTS:
         verifyItem(1, -120, 350., false);
         verifyItem(2, 230, 350., false);
         verifyItem(3, 580, 350., true);
-        QCOMPARE(lvwph->m_minYExtent, 162.5);
+        QCOMPARE(lvwph->m_minYExtent, 0.);
         QCOMPARE(lvwph->m_clipItem->y(), 520.);
         QCOMPARE(lvwph->m_clipItem->clip(), false);
         QCOMPARE(lvwph->m_headerItem->y(), 0.);
@@ -1630,7 +1627,7 @@ private Q_SLOTS:
         verifyItem(1, -158., 350., false);
         verifyItem(2, 192, 350., false);
         verifyItem(3, 542, 350., true);
-        QCOMPARE(lvwph->m_minYExtent, 162.5);
+        QCOMPARE(lvwph->m_minYExtent, 0.);
         QCOMPARE(lvwph->m_clipItem->y(), 558.);
         QCOMPARE(lvwph->m_clipItem->clip(), false);
         QCOMPARE(lvwph->m_headerItem->y(), 0.);
@@ -2026,6 +2023,51 @@ private Q_SLOTS:
         QTRY_COMPARE(lvwph->m_minYExtent, 530.);
     }
 
+    void testJumpToPosition()
+    {
+        for (int i = 0; i < 60; ++i) {
+            QMetaObject::invokeMethod(model, "insertItem", Q_ARG(QVariant, 6 + i), Q_ARG(QVariant, 350));
+        }
+        QTRY_COMPARE(lvwph->m_heightIndex.count(), 66);
+
+        const qreal listStart = -lvwph->m_minYExtent + lvwph->m_headerItem->implicitHeight();
+
+        // Positions inside or just around the created items do not jump
+        const int visibleCount = lvwph->m_visibleItems.count();
+        QCOMPARE(lvwph->jumpToPosition(listStart), false);
+        QCOMPARE(lvwph->jumpToPosition(listStart + lvwph->m_heightIndex.position(visibleCount)), false);
+        QCOMPARE(lvwph->m_firstVisibleIndex, 0);
+        QCOMPARE(lvwph->m_visibleItems.count(), visibleCount);
+
+        // A far away position releases everything and creates just the item under it
+        const qreal position = listStart + lvwph->m_heightIndex.position(40) + lvwph->m_heightIndex.estimatedHeight() / 2;
+        const int expectedIndex = lvwph->m_heightIndex.indexAt(position - listStart);
+        QCOMPARE(expectedIndex, 40);
+        QCOMPARE(lvwph->jumpToPosition(position), true);
+        QCOMPARE(lvwph->m_firstVisibleIndex, expectedIndex);
+        QCOMPARE(lvwph->m_visibleItems.count(), 1);
+
+        // Out of range positions do not jump
+        QCOMPARE(lvwph->jumpToPosition(listStart + lvwph->m_heightIndex.totalHeight() + 1000), false);
+        QCOMPARE(lvwph->m_firstVisibleIndex, expectedIndex);
+    }
+
+    void testLongScrollJumps()
+    {
+        for (int i = 0; i < 60; ++i) {
+            QMetaObject::invokeMethod(model, "insertItem", Q_ARG(QVariant, 6 + i), Q_ARG(QVariant, 350));
+        }
+        QTRY_COMPARE(lvwph->m_heightIndex.count(), 66);
+
+        // Scrolling many viewports away does not create every item in between
+        lvwph->setContentY(lvwph->contentY() + 10000);
+        QTRY_VERIFY(lvwph->m_firstVisibleIndex > 20);
+        QVERIFY(lvwph->m_visibleItems.count() < 10);
+
+        scrollToTop();
+        QTRY_COMPARE(lvwph->m_firstVisibleIndex, 0);
+    }
+
 private:
     QQuickView *view;
     ListViewWithPageHeader *lvwph;
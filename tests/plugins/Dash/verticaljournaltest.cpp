@@ -306,6 +306,25 @@ private Q_SLOTS:
         checkInitialPositions();
     }
 
+    void testDelegatePool()
+    {
+        vj->setDelegatePoolSize(10);
+        QCOMPARE(vj->delegatePoolHits(), 0);
+
+        // Release some items and bring them back, they should come from the pool
+        vj->setDisplayMarginBeginning(-200);
+        vj->setDisplayMarginEnd(-(vj->height() - view->height()));
+        QTRY_COMPARE(vj->m_columnVisibleItems[1].count(), 4);
+        QCOMPARE(vj->m_delegatePool.count(), 4);
+
+        vj->setDisplayMarginBeginning(0);
+        vj->setDisplayMarginEnd(0);
+
+        checkInitialPositions();
+        QCOMPARE(vj->delegatePoolHits(), 4);
+        QCOMPARE(vj->m_delegatePool.count(), 0);
+    }
+
 
     void testColumnWidthChange()
     {
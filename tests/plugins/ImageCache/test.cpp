@@ -15,6 +15,7 @@
  */
 
 #include <QCoreApplication>
+#include <QDataStream>
 #include <QFileInfo>
 #include <QImageReader>
 #include <QQuickView>
@@ -52,6 +53,11 @@ private:
         return reader.size();
     }
 
+    QObject *stats()
+    {
+        return image->property("stats").value<QObject*>();
+    }
+
     QString sourceFile(const QString &name)
     {
         return testDataDir() + "/" TEST_DIR "/graphics/" + name;
@@ -86,14 +92,9 @@ private:
         QCOMPARE(utime(cachePath.toUtf8().data(), &timebuffer), 0);
     }
 
-private Q_SLOTS:
-
-    void init()
+    // A new view means a new engine, so a new image provider with nothing in memory
+    void createView()
     {
-        home = new QTemporaryDir();
-        QVERIFY(home->isValid());
-        qputenv("HOME", home->path().toUtf8());
-
         view = new QQuickView();
         view->setSource(QUrl::fromLocalFile(testDataDir() + "/" TEST_DIR "/test.qml"));
         image = view->rootObject();
@@ -104,6 +105,17 @@ private Q_SLOTS:
         waitForImage(QQuickImage::Null);
     }
 
+private Q_SLOTS:
+
+    void init()
+    {
+        home = new QTemporaryDir();
+        QVERIFY(home->isValid());
+        qputenv("HOME", home->path().toUtf8());
+
+        createView();
+    }
+
     void cleanup()
     {
         delete view;
@@ -135,7 +147,7 @@ private Q_SLOTS:
     {
         setUpImage("wide.jpg", QSize(100, 100));
         waitForImage();
-        QCOMPARE(cachedImageSize(cachedFile(true, "wide.jpg")), QSize(100, 100));
+        QTRY_COMPARE(cachedImageSize(cachedFile(true, "wide.jpg")), QSize(100, 100));
     }
 
     void testWidthSourceSize()
@@ -143,7 +155,7 @@ private Q_SLOTS:
         setUpImage("wide.jpg", QSize(100, 0));
         waitForImage();
         // wide.jpg is 500x200
-        QCOMPARE(cachedImageSize(cachedFile(true, "wide.jpg")), QSize(100, 40));
+        QTRY_COMPARE(cachedImageSize(cachedFile(true, "wide.jpg")), QSize(100, 40));
     }
 
     void testHeightSourceSize()
@@ -151,15 +163,15 @@ private Q_SLOTS:
         setUpImage("wide.jpg", QSize(0, 100));
         waitForImage();
         // wide.jpg is 500x200
-        QCOMPARE(cachedImageSize(cachedFile(true, "wide.jpg")), QSize(250, 100));
+        QTRY_COMPARE(cachedImageSize(cachedFile(true, "wide.jpg")), QSize(250, 100));
     }
 
     void testNameArg()
     {
         setUpImage("wide.jpg?name=foo", QSize(0, 100));
         waitForImage();
+        QTRY_VERIFY(QFile::exists(cachedFile(false, "foo")));
         QVERIFY(!QFile::exists(cachedFile(true, ""))); // check for dir itself
-        QVERIFY(QFile::exists(cachedFile(false, "foo")));
     }
 
     void testLoadCache()
@@ -186,7 +198,7 @@ private Q_SLOTS:
 
         setUpImage("wide.jpg?name=foo", QSize(100, 0));
         waitForImage();
-        QVERIFY(QFileInfo(cacheName).lastModified().toTime_t() >= now); // was recreated
+        QTRY_VERIFY(QFileInfo(cacheName).lastModified().toTime_t() >= now); // was recreated
     }
 
     void testStaleCache()
@@ -202,7 +214,128 @@ private Q_SLOTS:
 
         setUpImage("wide.jpg?name=foo", QSize(0, 100));
         waitForImage();
-        QVERIFY(QFileInfo(cacheName).lastModified().toTime_t() >= now); // was recreated
+        QTRY_VERIFY(QFileInfo(cacheName).lastModified().toTime_t() >= now); // was recreated
+    }
+
+    void testMemoryCache()
+    {
+        // Skip the QML pixmap cache, so that every load reaches us
+        image->setProperty("cache", false);
+
+        setUpImage("wide.jpg", QSize(100, 0));
+        waitForImage();
+        auto cacheName = cachedFile(true, "wide.jpg");
+        QTRY_VERIFY(QFile::exists(cacheName));
+        QVERIFY(QFile::remove(cacheName));
+
+        setUpImage("NOTHERE");
+        waitForImage(QQuickImage::Error);
+
+        setUpImage("wide.jpg", QSize(100, 0));
+        waitForImage();
+        QVERIFY(!QFile::exists(cacheName)); // came from memory
+        QCOMPARE(image->property("implicitWidth").toInt(), 100);
+    }
+
+    void testFastFormat()
+    {
+        stats()->setProperty("fastFormat", true);
+
+        setUpImage("wide.jpg?name=foo", QSize(100, 0));
+        waitForImage();
+        QTRY_VERIFY(QFile::exists(cachedFile(false, "foo")));
+        QCOMPARE(QImageReader(cachedFile(false, "foo")).format(), QByteArray("png"));
+    }
+
+    void testRawFormat()
+    {
+        stats()->setProperty("rawFormat", true);
+
+        setUpImage("wide.jpg?name=foo", QSize(100, 0));
+        waitForImage();
+        auto cacheName = cachedFile(false, "foo");
+        QTRY_VERIFY(QFile::exists(cacheName));
+        QFile cacheFile(cacheName);
+        QVERIFY(cacheFile.open(QIODevice::ReadOnly));
+        QCOMPARE(cacheFile.read(8), QByteArray("U8ICRAW1"));
+        cacheFile.close();
+        auto mtime = QFileInfo(cacheName).lastModified();
+
+        delete view;
+        createView();
+
+        setUpImage("wide.jpg?name=foo", QSize(100, 0));
+        waitForImage();
+        QCOMPARE(image->property("implicitWidth").toInt(), 100);
+        QCOMPARE(image->property("implicitHeight").toInt(), 40);
+        QCOMPARE(QFileInfo(cacheName).lastModified(), mtime); // wasn't recreated
+        QTRY_COMPARE(stats()->property("hits").toInt(), 1);
+    }
+
+    void testRawFormatOverBudget()
+    {
+        stats()->setProperty("rawFormat", true);
+        // 100x40 pixels don't fit in a quarter of this
+        stats()->setProperty("diskBudget", 16000);
+
+        setUpImage("wide.jpg?name=foo", QSize(100, 0));
+        waitForImage();
+        QTRY_VERIFY(QFile::exists(cachedFile(false, "foo")));
+        QCOMPARE(QImageReader(cachedFile(false, "foo")).format(), QByteArray("jpeg"));
+    }
+
+    void testRawFormatTruncated()
+    {
+        stats()->setProperty("rawFormat", true);
+
+        // A header for 100x40 pixels with only a few of them after it
+        auto cacheName = cachedFile(false, "foo");
+        QFileInfo(cacheName).dir().mkpath(QStringLiteral("."));
+        QFile cacheFile(cacheName);
+        QVERIFY(cacheFile.open(QIODevice::WriteOnly));
+        QDataStream header(&cacheFile);
+        header.setByteOrder(QDataStream::ByteOrder(QSysInfo::ByteOrder));
+        header.writeRawData("U8ICRAW1", 8);
+        header << (quint32)100 << (quint32)40 << (quint32)400 << (quint32)QImage::Format_ARGB32_Premultiplied;
+        cacheFile.write(QByteArray(100, 0));
+        cacheFile.close();
+
+        setUpImage("wide.jpg?name=foo", QSize(100, 0));
+        waitForImage();
+        QCOMPARE(image->property("implicitWidth").toInt(), 100);
+        QCOMPARE(image->property("implicitHeight").toInt(), 40);
+        QTRY_COMPARE(QFileInfo(cacheName).size(), (qint64)(24 + 100 * 40 * 4)); // was recreated
+        QCOMPARE(stats()->property("misses").toInt(), 1);
+    }
+
+    void testDiskBudget()
+    {
+        // Skip the QML pixmap cache, so that every load reaches us
+        image->setProperty("cache", false);
+
+        // Only room for the last file written
+        stats()->setProperty("diskBudget", 1);
+
+        setUpImage("wide.jpg?name=first", QSize(100, 0));
+        waitForImage();
+        QTRY_VERIFY(QFile::exists(cachedFile(false, "first")));
+
+        // Decoded images are shared by source and size whatever their name,
+        // so ask for another size to go through the decoding and the disk again
+        setUpImage("wide.jpg?name=second", QSize(50, 0));
+        waitForImage();
+        QTRY_VERIFY(!QFile::exists(cachedFile(false, "first")));
+        QVERIFY(QFile::exists(cachedFile(false, "second")));
+        QTRY_COMPARE(stats()->property("evictions").toInt(), 1);
+        QCOMPARE(stats()->property("bytes").toLongLong(), QFileInfo(cachedFile(false, "second")).size());
+        QCOMPARE(stats()->property("misses").toInt(), 2);
+        QCOMPARE(stats()->property("hits").toInt(), 0);
+
+        // Still in memory
+        setUpImage("wide.jpg?name=first", QSize(100, 0));
+        waitForImage();
+        QTRY_COMPARE(stats()->property("hits").toInt(), 1);
+        QVERIFY(!QFile::exists(cachedFile(false, "first")));
     }
 
 private:
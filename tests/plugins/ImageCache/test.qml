@@ -20,4 +20,6 @@ import ImageCache 0.1
 Image {
     width: 400
     height: 400
+
+    property QtObject stats: ImageCacheStats
 }
@@ -40,6 +40,89 @@ private:
     qint64 m_value;
 };
 
+/*
+  The average estimator as it was before AxisVelocitySampler, walking every
+  sample with a wrapping index. Only here as a baseline for the benchmarks.
+ */
+class LegacyVelocityCalculator {
+public:
+    static const int MIN_SAMPLES_NEEDED = AxisVelocitySampler::MIN_SAMPLES_NEEDED;
+    static const int MAX_SAMPLES = AxisVelocitySampler::MAX_SAMPLES;
+    static const int AGE_OLDEST_SAMPLE = AxisVelocitySampler::AGE_OLDEST_SAMPLE;
+
+    explicit LegacyVelocityCalculator(FakeTimeSource *timeSource)
+        : m_timeSource(timeSource), m_trackedPosition(0.0), m_samplesRead(-1), m_samplesWrite(0) {}
+
+    void setTrackedPosition(qreal newPosition) {
+        processMovement(newPosition - m_trackedPosition);
+        m_trackedPosition = newPosition;
+    }
+
+    qreal calculate() {
+        if (numSamples() < MIN_SAMPLES_NEEDED) {
+            return 0.0;
+        }
+        processMovement(0);
+
+        const int lastIndex = m_samplesWrite == 0 ? MAX_SAMPLES - 1 : m_samplesWrite - 1;
+        const qint64 currTime = m_samples[lastIndex].time;
+
+        qreal totalTime = 0;
+        qreal totalDistance = 0;
+
+        int sampleIndex = (m_samplesRead + 1) % MAX_SAMPLES;
+        qint64 previousTime = m_samples[m_samplesRead].time;
+        while (sampleIndex != m_samplesWrite) {
+            if (currTime - m_samples[sampleIndex].time <= AGE_OLDEST_SAMPLE) {
+                totalDistance += m_samples[sampleIndex].mov;
+                totalTime += m_samples[sampleIndex].time - previousTime;
+            }
+            previousTime = m_samples[sampleIndex].time;
+            sampleIndex = (sampleIndex + 1) % MAX_SAMPLES;
+        }
+
+        return totalDistance / totalTime;
+    }
+
+private:
+    void processMovement(qreal movement) {
+        if (m_samplesRead == -1) {
+            m_samplesRead = m_samplesWrite;
+        } else if (m_samplesRead == m_samplesWrite) {
+            m_samplesRead = (m_samplesRead + 1) % MAX_SAMPLES;
+        }
+
+        m_samples[m_samplesWrite].mov = movement;
+        m_samples[m_samplesWrite].time = m_timeSource->msecsSinceReference();
+        m_samplesWrite = (m_samplesWrite + 1) % MAX_SAMPLES;
+    }
+
+    int numSamples() const {
+        if (m_samplesRead == -1) {
+            return 0;
+        } else if (m_samplesWrite == 0) {
+            return MAX_SAMPLES - m_samplesRead;
+        } else if (m_samplesWrite == m_samplesRead) {
+            return MAX_SAMPLES;
+        } else if (m_samplesWrite < m_samplesRead) {
+            return (MAX_SAMPLES - m_samplesRead) + m_samplesWrite;
+        } else {
+            return m_samplesWrite - m_samplesRead;
+        }
+    }
+
+    struct Sample {
+        qreal mov;
+        qint64 time;
+    };
+
+    FakeTimeSource *m_timeSource;
+    qreal m_trackedPosition;
+    Sample m_samples[MAX_SAMPLES];
+    int m_samplesRead;
+    int m_samplesWrite;
+};
+
 class tst_AxisVelocityCalculator : public QObject
 {
     Q_OBJECT
@@ -51,6 +134,15 @@ private Q_SLOTS:
     void noSamples();
     void overflowSamples();
     void average();
+    void leastSquares();
+    void leastSquaresIgnoresOldSamples();
+    void samplerWithTimestamps();
+
+    void averageMatchesLegacy();
+
+    void benchmarkLegacyAverage();
+    void benchmarkAverage();
+    void benchmarkLeastSquares();
 
 private:
     AxisVelocityCalculator *velCalc;
@@ -158,6 +250,136 @@ void tst_AxisVelocityCalculator::average()
     QVERIFY(velocity > 2.5f);
 }
 
+void tst_AxisVelocityCalculator::leastSquares()
+{
+    qreal pos = 0;
+
+    velCalc->setEstimator(AxisVelocityCalculator::WeightedLeastSquares);
+    velCalc->setTrackedPosition(pos);
+    velCalc->reset();
+
+    fakeTimeSource->increaseMsecsSinceReference(10);
+    pos += 20;
+    velCalc->setTrackedPosition(pos);
+
+    fakeTimeSource->increaseMsecsSinceReference(10);
+    pos += 20;
+    velCalc->setTrackedPosition(pos);
+
+    fakeTimeSource->increaseMsecsSinceReference(10);
+    pos += 20;
+    velCalc->setTrackedPosition(pos);
+
+    qreal velocity = velCalc->calculate();
+
+    QCOMPARE(velocity, 2.0);
+}
+
+void tst_AxisVelocityCalculator::leastSquaresIgnoresOldSamples()
+{
+    qreal pos = 0;
+
+    velCalc->setEstimator(AxisVelocityCalculator::WeightedLeastSquares);
+    velCalc->setTrackedPosition(pos);
+    velCalc->reset();
+
+    /* slow samples, all older than AGE_OLDEST_SAMPLE by the end */
+    for (int i = 0; i < 10; ++i) {
+        fakeTimeSource->increaseMsecsSinceReference(10);
+        pos += 10;
+        velCalc->setTrackedPosition(pos);
+    }
+
+    for (int i = 0; i < 20; ++i) {
+        fakeTimeSource->increaseMsecsSinceReference(10);
+        pos += 30;
+        velCalc->setTrackedPosition(pos);
+    }
+
+    qreal velocity = velCalc->calculate();
+
+    QCOMPARE(velocity, 3.0);
+}
+
+void tst_AxisVelocityCalculator::samplerWithTimestamps()
+{
+    AxisVelocitySampler sampler;
+    QCOMPARE(sampler.velocity(), 0.0);
+
+    sampler.addMovement(0, 1000);
+    sampler.addMovement(15, 1005);
+    sampler.addMovement(15, 1010);
+
+    QCOMPARE(sampler.numSamples(), 3);
+    QCOMPARE(sampler.velocity(AxisVelocitySampler::Average), 3.0);
+    QCOMPARE(sampler.velocity(AxisVelocitySampler::WeightedLeastSquares), 3.0);
+
+    sampler.reset();
+    QCOMPARE(sampler.numSamples(), 0);
+}
+
+void tst_AxisVelocityCalculator::averageMatchesLegacy()
+{
+    LegacyVelocityCalculator legacy(fakeTimeSource.data());
+    qreal pos = 0;
+
+    // Irregular movements and intervals, enough to wrap around and age samples out
+    for (int i = 0; i < 3 * AxisVelocityCalculator::MAX_SAMPLES; ++i) {
+        fakeTimeSource->increaseMsecsSinceReference(1 + (i * 7) % 13);
+        pos += (i * 5) % 11 - 3;
+        velCalc->setTrackedPosition(pos);
+        legacy.setTrackedPosition(pos);
+        if (i % 10 == 9) {
+            QCOMPARE(velCalc->calculate(), legacy.calculate());
+        }
+    }
+}
+
+void tst_AxisVelocityCalculator::benchmarkLegacyAverage()
+{
+    LegacyVelocityCalculator legacy(fakeTimeSource.data());
+    qreal pos = 0;
+
+    QBENCHMARK {
+        for (int i = 0; i < LegacyVelocityCalculator::MAX_SAMPLES; ++i) {
+            fakeTimeSource->increaseMsecsSinceReference(4);
+            pos += 5;
+            legacy.setTrackedPosition(pos);
+            legacy.calculate();
+        }
+    }
+}
+
+void tst_AxisVelocityCalculator::benchmarkAverage()
+{
+    qreal pos = 0;
+
+    QBENCHMARK {
+        for (int i = 0; i < AxisVelocityCalculator::MAX_SAMPLES; ++i) {
+            fakeTimeSource->increaseMsecsSinceReference(4);
+            pos += 5;
+            velCalc->setTrackedPosition(pos);
+            velCalc->calculate();
+        }
+    }
+}
+
+void tst_AxisVelocityCalculator::benchmarkLeastSquares()
+{
+    qreal pos = 0;
+
+    velCalc->setEstimator(AxisVelocityCalculator::WeightedLeastSquares);
+
+    QBENCHMARK {
+        for (int i = 0; i < AxisVelocityCalculator::MAX_SAMPLES; ++i) {
+            fakeTimeSource->increaseMsecsSinceReference(4);
+            pos += 5;
+            velCalc->setTrackedPosition(pos);
+            velCalc->calculate();
+        }
+    }
+}
+
 QTEST_MAIN(tst_AxisVelocityCalculator)
 
 #include "tst_AxisVelocityCalculator.moc"
@@ -66,9 +66,12 @@ private:
 
 private Q_SLOTS:
     void disabledWhileHoldingTouch();
+    void benchmarkReplayTrace();
+    void benchmarkReplayTrace_data();
 
 private:
     QQuickView *createView();
+    void replayTrace();
     TouchRegistry *touchRegistry;
     QQuickView *view;
     QTouchDevice *device;
@@ -370,6 +373,83 @@ void tst_TouchGate::disabledWhileHoldingTouch()
     }
 }
 
+/*
+    Two fingers pinching apart for a second, as sampled by a 120Hz touchscreen
+ */
+void tst_TouchGate::replayTrace()
+{
+    const int frames = 120;
+
+    QTest::touchEvent(view, device)
+        .press(0, QPoint(300, 360))
+        .press(1, QPoint(420, 360));
+
+    for (int i = 1; i <= frames; ++i) {
+        QTest::touchEvent(view, device)
+            .move(0, QPoint(300 - i, 360 - i / 2))
+            .move(1, QPoint(420 + i, 360 + i / 2));
+    }
+
+    QTest::touchEvent(view, device)
+        .release(0, QPoint(300 - frames, 360 - frames / 2))
+        .release(1, QPoint(420 + frames, 360 + frames / 2));
+}
+
+void tst_TouchGate::benchmarkReplayTrace()
+{
+    TouchGate *touchGate = view->rootObject()->findChild<TouchGate*>("touchGate");
+    Q_ASSERT(touchGate);
+    QFETCH(bool, holdOwnership);
+
+    TestItem *testItem = new TestItem;
+    testItem->setWidth(touchGate->width());
+    testItem->setHeight(touchGate->height());
+    testItem->setParentItem(view->rootObject());
+    testItem->setZ(0.0);
+
+    touchGate->setZ(1.0);
+    touchGate->setTargetItem(testItem);
+
+    // Put it in front of touchGate
+    CandidateItem *candidateItem = new CandidateItem;
+    candidateItem->setWidth(touchGate->width());
+    candidateItem->setHeight(touchGate->height());
+    candidateItem->setParentItem(view->rootObject());
+    candidateItem->setZ(2.0);
+
+    candidateItem->touchEventHandler = [&](QTouchEvent* event) {
+        if (holdOwnership) {
+            // Keep TouchGate storing every event until the very end
+            Q_FOREACH(const QTouchEvent::TouchPoint &touchPoint, event->touchPoints()) {
+                if (touchPoint.state() == Qt::TouchPointPressed) {
+                    touchRegistry->addCandidateOwnerForTouch(touchPoint.id(), candidateItem);
+                }
+            }
+        }
+        event->ignore();
+    };
+
+    QBENCHMARK {
+        replayTrace();
+
+        if (holdOwnership) {
+            touchRegistry->removeCandidateOwnerForTouch(0, candidateItem);
+            touchRegistry->removeCandidateOwnerForTouch(1, candidateItem);
+        }
+
+        QVERIFY(touchGate->m_storedEvents.isEmpty());
+        testItem->touchEventsReceived.clear();
+    }
+}
+
+void tst_TouchGate::benchmarkReplayTrace_data()
+{
+    QTest::addColumn<bool>("holdOwnership");
+
+    QTest::newRow("pass through") << false;
+    QTest::newRow("held until touch end") << true;
+}
+
 ///////////// CandidateItem /////////////////////////////////////////////////////////////
 
 void CandidateItem::touchEvent(QTouchEvent *event)
@@ -45,6 +45,7 @@ private Q_SLOTS:
     void releaseAndPressRecognisedGestureDoesNotRejectForPeriod();
     void topAreaReceivesOwnershipFirstWithEqualPoints();
     void topAreaReceivesOwnershipFirstWithMorePoints();
+    void updatedOnlyWithChangedPoints();
 
 private:
     void initGestureComponent(TouchGestureArea *area);
@@ -265,6 +266,38 @@ void tst_TouchGestureArea::topAreaReceivesOwnershipFirstWithMorePoints()
     QCOMPARE((int)m_gestureMiddle->status(), (int)TouchGestureArea::Rejected);
 }
 
+void tst_TouchGestureArea::updatedOnlyWithChangedPoints()
+{
+    m_gestureBottom->setEnabled(true);
+    m_gestureBottom->setMinimumTouchPoints(2);
+
+    QPoint touchPoint = calculateInitialTouchPos(m_gestureBottom).toPoint();
+
+    QTest::touchEvent(m_view, m_device).press(0, touchPoint);
+    QTest::touchEvent(m_view, m_device).stationary(0)
+                                       .press(1, touchPoint);
+    QCOMPARE((int)m_gestureBottom->status(), (int)TouchGestureArea::Recognized);
+
+    QSignalSpy updatedSpy(m_gestureBottom, &TouchGestureArea::updated);
+
+    QTest::touchEvent(m_view, m_device).move(0, touchPoint + QPoint(5, 0))
+                                       .stationary(1);
+    QCOMPARE(updatedSpy.count(), 1);
+    {
+        QList<QObject*> points = updatedSpy.at(0).at(0).value<QList<QObject*>>();
+        QCOMPARE(points.count(), 1);
+        QCOMPARE(static_cast<GestureTouchPoint*>(points.at(0))->id(), 0);
+    }
+
+    // Didn't really move, nothing to tell
+    QTest::touchEvent(m_view, m_device).move(0, touchPoint + QPoint(5, 0))
+                                       .stationary(1);
+    QCOMPARE(updatedSpy.count(), 1);
+
+    QTest::touchEvent(m_view, m_device).release(0, touchPoint + QPoint(5, 0))
+                                       .release(1, touchPoint);
+}
+
 QTEST_MAIN(tst_TouchGestureArea)
 
 #include "tst_TouchGestureArea.moc"
@@ -18,10 +18,12 @@
  */
 
 #include "indicatorsmanager.h"
+#include "unitymenumodelcache.h"
 
 #include <paths.h>
 
 #include <QtTest>
+#include <unitymenumodel.h>
 #include <QDebug>
 
 class IndicatorsManagerTest : public QObject
@@ -128,6 +130,65 @@ private Q_SLOTS:
         QCOMPARE(props["menuObjectPath"].toString(), QString("/com/canonical/indicator/fake1/test2"));
     }
 
+    /*
+     * Test which indicators have a menu in the profile
+     */
+    void testIndicatorInProfile()
+    {
+        IndicatorsManager manager;
+        manager.setProfile("test1");
+        manager.load();
+
+        QCOMPARE(manager.indicatorNames().count(), 4);
+        QCOMPARE(manager.isIndicatorInProfile("indicator-fake1"), true);
+        QCOMPARE(manager.isIndicatorInProfile("indicator-unknown"), false);
+
+        manager.setProfile("test3");
+        QCOMPARE(manager.isIndicatorInProfile("indicator-fake1"), false);
+    }
+
+    /*
+     * Test that the menus of a prefetched profile are the ones used once it's active
+     */
+    void testPrefetch()
+    {
+        IndicatorsManager manager;
+        manager.setProfile("test1");
+        manager.load();
+
+        manager.prefetch("test2");
+        QSharedPointer<UnityMenuModel> prefetched = UnityMenuModelCache::singleton()->model("/com/canonical/indicator/fake1/test2");
+        QCOMPARE(prefetched->busName(), QByteArray("com.canonical.indicator.fake1"));
+
+        manager.setProfile("test2");
+
+        Indicator::Ptr indicator = manager.indicator("indicator-fake1");
+        const QByteArray menuObjectPath = indicator->indicatorProperties().toMap()["menuObjectPath"].toByteArray();
+        QCOMPARE(menuObjectPath, QByteArray("/com/canonical/indicator/fake1/test2"));
+        QCOMPARE(UnityMenuModelCache::singleton()->model(menuObjectPath), prefetched);
+    }
+
+    /*
+     * Test that switching profiles prefetches the menus of the new one
+     */
+    void testSetProfilePrefetches()
+    {
+        IndicatorsManager manager;
+        manager.setProfile("test1");
+        manager.load();
+
+        // Start from a cache without any "test4" menus
+        delete UnityMenuModelCache::singleton();
+        QCOMPARE(UnityMenuModelCache::singleton()->contains("/com/canonical/indicator/fake3/test4"), false);
+
+        manager.setProfile("test4");
+
+        QCOMPARE(UnityMenuModelCache::singleton()->contains("/com/canonical/indicator/fake3/test4"), true);
+        QSharedPointer<UnityMenuModel> model = UnityMenuModelCache::singleton()->model("/com/canonical/indicator/fake3/test4");
+        QCOMPARE(model->busName(), QByteArray("com.canonical.indicator.fake3"));
+        QVERIFY(!model->actions().isEmpty());
+    }
+
     /*
      * Test if a new plugin object is create for each different plugin
      */
@@ -59,6 +59,62 @@ private Q_SLOTS:
 
     }
 
+    /*
+     * Tests that only the indicators with a menu in the profile are in the model
+     */
+    void testProfileWithoutMenus()
+    {
+        IndicatorsModel model;
+        model.setProfile("test3");
+        model.load();
+
+        QCOMPARE(model.property("count").toInt(), 0);
+
+        model.setProfile("test1");
+
+        QCOMPARE(model.property("count").toInt(), 4);
+        QCOMPARE(model.data(0, IndicatorsModelRole::Identifier).toString(), QString("indicator-fake3"));
+        QCOMPARE(model.data(3, IndicatorsModelRole::Identifier).toString(), QString("indicator-fake2"));
+    }
+
+    /*
+     * Tests that switching profiles adds and removes the indicators that gain or lose a menu
+     */
+    void testProfileSwitch()
+    {
+        IndicatorsModel model;
+        model.setProfile("test1");
+        model.load();
+
+        QCOMPARE(model.property("count").toInt(), 4);
+
+        // Only fake1 and fake3 have a menu in "test4"
+        QSignalSpy removedSpy(&model, &QAbstractItemModel::rowsRemoved);
+        model.setProfile("test4");
+
+        QCOMPARE(removedSpy.count(), 2);
+        QCOMPARE(model.property("count").toInt(), 2);
+        QCOMPARE(model.data(0, IndicatorsModelRole::Identifier).toString(), QString("indicator-fake3"));
+        QCOMPARE(model.data(0, IndicatorsModelRole::IndicatorProperties).toMap()["menuObjectPath"].toString(), QString("/com/canonical/indicator/fake3/test4"));
+        QCOMPARE(model.data(1, IndicatorsModelRole::Identifier).toString(), QString("indicator-fake1"));
+
+        // And back, in the right order
+        QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+        model.setProfile("test1");
+
+        QCOMPARE(insertedSpy.count(), 2);
+        QCOMPARE(model.property("count").toInt(), 4);
+        QCOMPARE(model.data(0, IndicatorsModelRole::Identifier).toString(), QString("indicator-fake3"));
+        QCOMPARE(model.data(1, IndicatorsModelRole::Identifier).toString(), QString("indicator-fake4"));
+        QCOMPARE(model.data(2, IndicatorsModelRole::Identifier).toString(), QString("indicator-fake1"));
+        QCOMPARE(model.data(3, IndicatorsModelRole::Identifier).toString(), QString("indicator-fake2"));
+        QCOMPARE(model.data(1, IndicatorsModelRole::IndicatorProperties).toMap()["menuObjectPath"].toString(), QString("/com/canonical/indicator/fake4/test1"));
+
+        // Nothing left without menus
+        model.setProfile("test3");
+        QCOMPARE(model.property("count").toInt(), 0);
+    }
+
     /*
      * Testa that the plugin data was loaded correctly ( "test1" )
      */
@@ -280,6 +280,76 @@ private Q_SLOTS:
         QCOMPARE(activator.isMenuContentActive(11), false);
     }
 
+    /*
+     * Tests that the content the panel is heading to gets activated first.
+     */
+    void testVelocity()
+    {
+        MenuContentActivator activator;
+        activator.setContentTimer(m_fakeTimeSource);
+        activator.setCount(10);
+        activator.setBaseIndex(5);
+        activator.setPosition(5.2);
+        activator.setVelocity(-8); // two and a bit menus left in the look ahead
+
+        connect(&activator, &MenuContentActivator::deltaChanged,
+                this, &MenuConentActivatorTest::onDeltaChange);
+        activator.restart();
+
+        m_fakeTimeSource->emitTimeout();
+        m_fakeTimeSource->emitTimeout();
+        m_fakeTimeSource->emitTimeout();
+        m_fakeTimeSource->emitTimeout();
+        QCOMPARE(getIndexList(&activator), QList<int>() << 3 << 4 << 2 << 1);
+    }
+
+    /*
+     * Tests that slow frames hold off activations, and fast ones speed them up.
+     */
+    void testFrameTime()
+    {
+        MenuContentActivator activator;
+        activator.setContentTimer(m_fakeTimeSource);
+        activator.setCount(10);
+        activator.setBaseIndex(5);
+        activator.restart();
+
+        connect(&activator, &MenuContentActivator::deltaChanged,
+                this, &MenuConentActivatorTest::onDeltaChange);
+
+        activator.reportFrameTime(40);
+        m_fakeTimeSource->emitTimeout();
+        QCOMPARE(getIndexList(&activator), QList<int>());
+
+        // but not for ever
+        m_fakeTimeSource->emitTimeout();
+        QCOMPARE(getIndexList(&activator), QList<int>() << 6);
+
+        activator.reportFrameTime(16);
+        m_fakeTimeSource->emitTimeout();
+        QCOMPARE(getIndexList(&activator), QList<int>() << 6 << 4 << 7 << 3);
+    }
+
+    /*
+     * Tests that the content states are kept when cleared, as QML might be using them.
+     */
+    void testClear()
+    {
+        MenuContentActivator activator;
+        activator.setContentTimer(m_fakeTimeSource);
+        activator.setCount(10);
+        activator.setBaseIndex(5);
+        activator.restart();
+
+        QQmlListProperty<MenuContentState> content = activator.content();
+        MenuContentState* state = content.at(&content, 5);
+        QCOMPARE(state->isActive(), true);
+
+        activator.clear();
+        QCOMPARE(state->isActive(), false);
+        QCOMPARE(content.at(&content, 5), state);
+    }
+
     void onDeltaChange(int delta)
     {
         m_deltas << delta;
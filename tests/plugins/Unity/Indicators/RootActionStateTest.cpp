@@ -23,6 +23,32 @@
 #include <QtTest>
 #include <gio/gio.h>
 
+class TestRootState : public RootStateObject
+{
+    Q_OBJECT
+public:
+    bool valid() const override { return !currentState().empty(); }
+
+    using RootStateObject::setCurrentStateAsync;
+};
+
+static GVariant* createState(const char* title, const char* label)
+{
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add(&builder, "{sv}", "title", g_variant_new_string(title));
+    g_variant_builder_add(&builder, "{sv}", "label", g_variant_new_string(label));
+    return g_variant_ref_sink(g_variant_builder_end(&builder));
+}
+
+static GVariant* createIconState(const char* iconName)
+{
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add(&builder, "{sv}", "icon", g_variant_new_string(iconName));
+    return g_variant_ref_sink(g_variant_builder_end(&builder));
+}
+
 class RootActionStateTest : public QObject
 {
     Q_OBJECT
@@ -89,6 +115,115 @@ private Q_SLOTS:
         QVERIFY(serializedIcons[1] == "image://theme/testIcon1");
         QVERIFY(serializedIcons[2] == "image://theme/testIcon2");
     }
+
+    void testToQVariantBytesIconIsCached()
+    {
+        GBytes* bytes = g_bytes_new_static("iconData", 8);
+        GIcon* icon = g_bytes_icon_new(bytes);
+        GVariant* serializedIcon = g_icon_serialize(icon);
+        g_object_unref(icon);
+        g_bytes_unref(bytes);
+
+        GVariantBuilder builder;
+        g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+        g_variant_builder_add(&builder, "{sv}", "icon", serializedIcon);
+        GVariant* params = g_variant_ref_sink(g_variant_builder_end(&builder));
+        g_variant_unref(serializedIcon);
+
+        RootStateParser rootState;
+        QStringList first = rootState.toQVariant(params).toMap()["icons"].toStringList();
+        const int hits = RootStateParser::iconCacheHits();
+        QStringList second = rootState.toQVariant(params).toMap()["icons"].toStringList();
+        g_variant_unref(params);
+
+        QCOMPARE(first, QStringList() << "data://aWNvbkRhdGE=");
+        QCOMPARE(second, first);
+        QCOMPARE(RootStateParser::iconCacheHits(), hits + 1);
+    }
+
+    void testIconCacheEvictsLeastRecentlyUsed()
+    {
+        RootStateParser rootState;
+        auto parseIcon = [&rootState](const QString& name) {
+            GVariant* state = createIconState(name.toUtf8().constData());
+            const QStringList icons = rootState.toQVariant(state).toMap()["icons"].toStringList();
+            g_variant_unref(state);
+            return icons;
+        };
+
+        // Fills the cache of 64, with the kept icon the oldest one
+        QCOMPARE(parseIcon("lruKept"), QStringList() << "image://theme/lruKept");
+        for (int i = 0; i < 63; i++) {
+            parseIcon(QStringLiteral("lruFiller%1").arg(i));
+        }
+
+        int hits = RootStateParser::iconCacheHits();
+        parseIcon("lruKept");
+        QCOMPARE(RootStateParser::iconCacheHits(), hits + 1);
+
+        // Evicts the first filler instead of the icon just used
+        parseIcon("lruNew");
+        hits = RootStateParser::iconCacheHits();
+        QCOMPARE(parseIcon("lruKept"), QStringList() << "image://theme/lruKept");
+        QCOMPARE(RootStateParser::iconCacheHits(), hits + 1);
+
+        parseIcon("lruFiller0");
+        QCOMPARE(RootStateParser::iconCacheHits(), hits + 1);
+    }
+
+    void testDeferredParserKeepsState()
+    {
+        GVariant* state = createState("title", "label");
+
+        DeferredRootStateParser parser;
+        QCOMPARE(parser.toQVariant(state), QVariant());
+        g_variant_unref(state);
+
+        GVariant* taken = parser.takeState();
+        QVERIFY(taken != nullptr);
+        QVERIFY(parser.takeState() == nullptr);
+
+        QCOMPARE(RootStateParser().toQVariant(taken).toMap()["title"].toString(), QString("title"));
+        g_variant_unref(taken);
+    }
+
+    void testAsyncStateOnlyNotifiesChanges()
+    {
+        TestRootState rootState;
+        QSignalSpy updatedSpy(&rootState, &RootStateObject::updated);
+        QSignalSpy validSpy(&rootState, &RootStateObject::validChanged);
+        QSignalSpy titleSpy(&rootState, &RootStateObject::titleChanged);
+        QSignalSpy labelSpy(&rootState, &RootStateObject::rightLabelChanged);
+
+        rootState.setCurrentStateAsync(createState("title", "50%"));
+        QTRY_COMPARE(updatedSpy.count(), 1);
+        QCOMPARE(validSpy.count(), 1);
+        QCOMPARE(titleSpy.count(), 1);
+        QCOMPARE(labelSpy.count(), 1);
+        QCOMPARE(rootState.title(), QString("title"));
+        QCOMPARE(rootState.rightLabel(), QString("50%"));
+
+        // Same state again, nothing to do
+        rootState.setCurrentStateAsync(createState("title", "50%"));
+        rootState.setCurrentStateAsync(createState("title", "51%"));
+        QTRY_COMPARE(updatedSpy.count(), 2);
+        QCOMPARE(titleSpy.count(), 1);
+        QCOMPARE(labelSpy.count(), 2);
+        QCOMPARE(rootState.rightLabel(), QString("51%"));
+    }
+
+    void testDirectStateDropsConversion()
+    {
+        TestRootState rootState;
+        QSignalSpy updatedSpy(&rootState, &RootStateObject::updated);
+
+        rootState.setCurrentStateAsync(createState("title", "50%"));
+        rootState.setCurrentState(QVariantMap());
+        QTest::qWait(100);
+
+        QCOMPARE(updatedSpy.count(), 0);
+        QCOMPARE(rootState.valid(), false);
+    }
 };
 
 QTEST_GUILESS_MAIN(RootActionStateTest)
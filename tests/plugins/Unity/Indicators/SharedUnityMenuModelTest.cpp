@@ -96,6 +96,74 @@ private Q_SLOTS:
         QCOMPARE(UnityMenuModelCache::singleton()->contains("/com/canonical/test1"), false);
     }
 
+    void testEvictsLeastRecentlyUsed()
+    {
+        UnityMenuModelCache cache;
+        cache.setCapacity(2);
+
+        cache.model("/com/canonical/test1");
+        cache.model("/com/canonical/test2");
+        cache.model("/com/canonical/test1");
+        cache.model("/com/canonical/test3");
+
+        QCOMPARE(cache.contains("/com/canonical/test1"), true);
+        QCOMPARE(cache.contains("/com/canonical/test2"), false);
+        QCOMPARE(cache.contains("/com/canonical/test3"), true);
+    }
+
+    void testModelsInUseAreNotEvicted()
+    {
+        UnityMenuModelCache cache;
+        cache.setCapacity(1);
+
+        QSharedPointer<UnityMenuModel> model1 = cache.model("/com/canonical/test1");
+        cache.model("/com/canonical/test2");
+
+        QCOMPARE(cache.contains("/com/canonical/test1"), true);
+        QCOMPARE(cache.model("/com/canonical/test1"), model1);
+
+        cache.model("/com/canonical/test2");
+        model1.clear();
+        QCOMPARE(cache.contains("/com/canonical/test1"), false);
+    }
+
+    void testPinnedModelsAreNotEvicted()
+    {
+        UnityMenuModelCache cache;
+        cache.setCapacity(1);
+
+        cache.pin("/com/canonical/test1");
+        cache.model("/com/canonical/test1");
+        cache.model("/com/canonical/test2");
+        cache.model("/com/canonical/test3");
+
+        QCOMPARE(cache.contains("/com/canonical/test1"), true);
+        QCOMPARE(cache.contains("/com/canonical/test2"), false);
+        QCOMPARE(cache.contains("/com/canonical/test3"), true);
+
+        cache.trim();
+        QCOMPARE(cache.contains("/com/canonical/test1"), true);
+        QCOMPARE(cache.contains("/com/canonical/test3"), false);
+
+        cache.unpin("/com/canonical/test1");
+        cache.trim();
+        QCOMPARE(cache.contains("/com/canonical/test1"), false);
+    }
+
+    void testPrefetch()
+    {
+        UnityMenuModelCache cache;
+
+        QVariantMap actions;
+        actions["test"] = QString("/com/canonical/test1/actions");
+        cache.prefetch("/com/canonical/test1", "com.canonical.test1", actions);
+
+        QCOMPARE(cache.contains("/com/canonical/test1"), true);
+        QSharedPointer<UnityMenuModel> model = cache.model("/com/canonical/test1");
+        QCOMPARE(model->busName(), QByteArray("com.canonical.test1"));
+        QCOMPARE(model->actions(), actions);
+    }
+
 };
 
 QTEST_GUILESS_MAIN(SharedUnityMenuModelTest)
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "appdrawermodel.h"
+
+#include <QtTest>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+class AppDrawerModelTest : public QObject
+{
+    Q_OBJECT
+
+private:
+    AppDrawerModel *model;
+    QTemporaryDir *cacheDir;
+
+    AppDrawerLoader::App app(const QString &appId, const QString &name, const QStringList &keywords = QStringList())
+    {
+        AppDrawerLoader::App app;
+        app.appId = appId;
+        app.name = name;
+        app.icon = "/path/to/" + appId + ".png";
+        app.keywords = keywords;
+        return app;
+    }
+
+    QStringList appIds()
+    {
+        QStringList appIds;
+        for (int i = 0; i < model->rowCount(QModelIndex()); i++) {
+            appIds << model->data(model->index(i), AppDrawerModelInterface::RoleAppId).toString();
+        }
+        return appIds;
+    }
+
+    void writeSnapshot(int version, const QStringList &appIds)
+    {
+        QJsonArray apps;
+        Q_FOREACH (const QString &appId, appIds) {
+            QJsonObject app;
+            app.insert("appId", appId);
+            app.insert("name", appId.toUpper());
+            app.insert("icon", "/path/to/" + appId + ".png");
+            app.insert("keywords", QJsonArray::fromStringList(QStringList() << "snapshot"));
+            apps.append(app);
+        }
+
+        QJsonObject snapshot;
+        snapshot.insert("version", version);
+        snapshot.insert("apps", apps);
+
+        QFile file(AppDrawerModel::snapshotPath());
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(QJsonDocument(snapshot).toJson());
+    }
+
+private Q_SLOTS:
+
+    // Lets the loader go through whatever is installed, and starts the tests from an empty model
+    void init()
+    {
+        cacheDir = new QTemporaryDir();
+        QVERIFY(cacheDir->isValid());
+        qputenv("XDG_CACHE_HOME", cacheDir->path().toUtf8());
+
+        model = new AppDrawerModel();
+        // Written once the loader is done
+        QTRY_VERIFY(QFile::exists(AppDrawerModel::snapshotPath()));
+        model->onLoadingFinished(QStringList());
+        QCOMPARE(model->rowCount(QModelIndex()), 0);
+    }
+
+    void cleanup()
+    {
+        delete model;
+        delete cacheDir;
+    }
+
+    void testAppsLoadedInsertsBatch()
+    {
+        QSignalSpy insertedSpy(model, &QAbstractItemModel::rowsInserted);
+
+        model->onAppsLoaded(QList<AppDrawerLoader::App>() << app("app1", "App 1") << app("app2", "App 2", QStringList() << "two"));
+
+        // The whole batch at once
+        QCOMPARE(insertedSpy.count(), 1);
+        QCOMPARE(insertedSpy.first().at(1).toInt(), 0);
+        QCOMPARE(insertedSpy.first().at(2).toInt(), 1);
+
+        QCOMPARE(appIds(), QStringList() << "app1" << "app2");
+        QCOMPARE(model->data(model->index(1), AppDrawerModelInterface::RoleName).toString(), QString("App 2"));
+        QCOMPARE(model->data(model->index(1), AppDrawerModelInterface::RoleIcon).toString(), QString("/path/to/app2.png"));
+        QCOMPARE(model->data(model->index(1), AppDrawerModelInterface::RoleKeywords).toStringList(), QStringList() << "two");
+    }
+
+    void testAppsLoadedUpdatesInPlace()
+    {
+        model->onAppsLoaded(QList<AppDrawerLoader::App>() << app("app1", "App 1") << app("app2", "App 2"));
+
+        QSignalSpy insertedSpy(model, &QAbstractItemModel::rowsInserted);
+        QSignalSpy changedSpy(model, &QAbstractItemModel::dataChanged);
+
+        // Unchanged apps don't emit anything
+        model->onAppsLoaded(QList<AppDrawerLoader::App>() << app("app1", "App 1"));
+        QCOMPARE(insertedSpy.count(), 0);
+        QCOMPARE(changedSpy.count(), 0);
+
+        model->onAppsLoaded(QList<AppDrawerLoader::App>() << app("app2", "Renamed") << app("app3", "App 3"));
+
+        QCOMPARE(changedSpy.count(), 1);
+        QCOMPARE(changedSpy.first().at(0).toModelIndex().row(), 1);
+        QCOMPARE(changedSpy.first().at(1).toModelIndex().row(), 1);
+        QCOMPARE(insertedSpy.count(), 1);
+        QCOMPARE(insertedSpy.first().at(1).toInt(), 2);
+        QCOMPARE(insertedSpy.first().at(2).toInt(), 2);
+
+        QCOMPARE(appIds(), QStringList() << "app1" << "app2" << "app3");
+        QCOMPARE(model->data(model->index(1), AppDrawerModelInterface::RoleName).toString(), QString("Renamed"));
+    }
+
+    void testLoadingFinishedRemovesGoneApps()
+    {
+        model->onAppsLoaded(QList<AppDrawerLoader::App>() << app("app1", "App 1") << app("app2", "App 2") << app("app3", "App 3"));
+
+        QSignalSpy removedSpy(model, &QAbstractItemModel::rowsRemoved);
+        model->onLoadingFinished(QStringList() << "app1" << "app3");
+
+        QCOMPARE(removedSpy.count(), 1);
+        QCOMPARE(removedSpy.first().at(1).toInt(), 1);
+        QCOMPARE(removedSpy.first().at(2).toInt(), 1);
+        QCOMPARE(appIds(), QStringList() << "app1" << "app3");
+        QVERIFY(!model->m_items.contains("app2"));
+    }
+
+    void testSnapshotSaveAndLoad()
+    {
+        model->onAppsLoaded(QList<AppDrawerLoader::App>() << app("app1", "App 1", QStringList() << "one") << app("app2", "App 2"));
+        model->onLoadingFinished(QStringList() << "app1" << "app2");
+
+        QFile file(AppDrawerModel::snapshotPath());
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        const QJsonObject snapshot = QJsonDocument::fromJson(file.readAll()).object();
+        QCOMPARE(snapshot.value("version").toInt(), 1);
+        QCOMPARE(snapshot.value("apps").toArray().count(), 2);
+        QCOMPARE(snapshot.value("apps").toArray().at(0).toObject().value("appId").toString(), QString("app1"));
+
+        delete model;
+        model = new AppDrawerModel();
+
+        // Read right away, before the loader says anything
+        QCOMPARE(appIds(), QStringList() << "app1" << "app2");
+        QCOMPARE(model->data(model->index(0), AppDrawerModelInterface::RoleName).toString(), QString("App 1"));
+        QCOMPARE(model->data(model->index(0), AppDrawerModelInterface::RoleIcon).toString(), QString("/path/to/app1.png"));
+        QCOMPARE(model->data(model->index(0), AppDrawerModelInterface::RoleKeywords).toStringList(), QStringList() << "one");
+    }
+
+    void testSnapshotVersionMismatch()
+    {
+        writeSnapshot(0, QStringList() << "app1" << "app2");
+
+        delete model;
+        model = new AppDrawerModel();
+
+        QCOMPARE(model->rowCount(QModelIndex()), 0);
+        // Ignored, but not removed
+        QVERIFY(QFile::exists(AppDrawerModel::snapshotPath()));
+    }
+};
+
+QTEST_GUILESS_MAIN(AppDrawerModelTest)
+#include "appdrawermodeltest.moc"
@@ -24,6 +24,7 @@
 #include "dbusinterface.h"
 #include "gsettings.h"
 #include "asadapter.h"
+#include "usagetracker.h"
 #include "AccountsServiceDBusAdaptor.h"
 
 #include <QtTest>
@@ -222,6 +223,22 @@ private:
         return qdbus_cast<QList<QVariantMap>>(reply.value().value<QDBusArgument>());
     }
 
+    QStringList getASAppIds() {
+        QStringList appIds;
+        Q_FOREACH (const QVariantMap &item, getASConfig()) {
+            appIds << item.value("id").toString();
+        }
+        return appIds;
+    }
+
+    QStringList getLauncherAppIds() {
+        QStringList appIds;
+        for (int i = 0; i < launcherModel->rowCount(); i++) {
+            appIds << launcherModel->get(i)->appId();
+        }
+        return appIds;
+    }
+
     // Link our app data from a tempdir & tell glib/UAL to look there.
     // We do this because we want to be able to delete the applications dir
     // during testing, but that dir may be read-only (installed on system).
@@ -230,6 +247,7 @@ private:
         appDir.link(tmpDir.path() + "/applications");
 
         qputenv("XDG_DATA_HOME", tmpDir.path().toUtf8());
+        qputenv("XDG_CACHE_HOME", tmpDir.path().toUtf8());
     }
 
 private Q_SLOTS:
@@ -277,6 +295,7 @@ private Q_SLOTS:
         while (launcherModel->rowCount(QModelIndex()) > 0) {
             launcherModel->requestRemove(launcherModel->get(0)->appId());
         }
+        launcherModel->m_asAdapter->flush();
 
         QDBusInterface accountsInterface(QStringLiteral("org.freedesktop.Accounts"),
                                          QStringLiteral("/org/freedesktop/Accounts"),
@@ -451,6 +470,53 @@ private Q_SLOTS:
         QCOMPARE(launcherModel->get(1)->focused(), true);
     }
 
+    void testUsageTracking() {
+        const double before = UsageTracker::instance()->usage("rel-icon");
+        appManager->focusApplication("abs-icon");
+        appManager->focusApplication("rel-icon");
+        QVERIFY(UsageTracker::instance()->usage("rel-icon") > before);
+    }
+
+    void testUsagePersistence() {
+        QTemporaryDir usageDir;
+        QVERIFY(usageDir.isValid());
+
+        UsageTracker *tracker = new UsageTracker(usageDir.path());
+        QSignalSpy spy(tracker, &UsageTracker::usageChanged);
+        tracker->recordUse("abs-icon");
+        tracker->recordUse("abs-icon");
+        tracker->recordUse("rel-icon");
+        QCOMPARE(spy.count(), 3);
+
+        // Moves by less than the threshold are kept to ourselves
+        for (int i = 0; i < 20; ++i) {
+            tracker->recordUse("abs-icon");
+        }
+        QVERIFY(spy.count() < 3 + 20);
+        QVERIFY(tracker->usage("abs-icon") > tracker->usage("rel-icon"));
+        delete tracker;
+
+        // Loading folds the log into the snapshot and starts an empty log
+        tracker = new UsageTracker(usageDir.path());
+        QVERIFY(QFile::exists(usageDir.path() + "/usage.json"));
+        QCOMPARE(QFileInfo(usageDir.path() + "/usage.log").size(), 0);
+
+        // Reaching the threshold compacts again, the use after that goes to the log,
+        // which is only written out a bit later
+        for (int i = 0; i < UsageTracker::CompactThreshold + 1; ++i) {
+            tracker->recordUse("rel-icon");
+        }
+        QCOMPARE(QFileInfo(usageDir.path() + "/usage.log").size(), 0);
+        QTRY_VERIFY(QFileInfo(usageDir.path() + "/usage.log").size() > 0);
+        delete tracker;
+
+        // Both the snapshot and the log are read back
+        tracker = new UsageTracker(usageDir.path());
+        QVERIFY(tracker->usage("rel-icon") > tracker->usage("abs-icon"));
+        QVERIFY(qAbs(tracker->usage("abs-icon") - 22) < 0.01);
+        delete tracker;
+    }
+
     void testClosingApps() {
         // At the start there are 2 items. Let's pin one.
         launcherModel->pin("abs-icon");
@@ -752,43 +818,58 @@ private Q_SLOTS:
         QCOMPARE(spy.count(), 2);
     }
 
+    void testRefreshMovesFewestItems() {
+        GSettings *settings = launcherModel->m_settings;
+
+        launcherModel->pin("abs-icon");
+        launcherModel->pin("rel-icon");
+        launcherModel->pin("click-icon");
+        QCOMPARE(launcherModel->rowCount(), 3);
+
+        // Moving the first item to the end is a single move, not two
+        QSignalSpy movedSpy(launcherModel, &LauncherModel::rowsMoved);
+        settings->simulateDConfChanged(QStringList() << "rel-icon" << "click-icon" << "abs-icon");
+        QCOMPARE(movedSpy.count(), 1);
+        QCOMPARE(launcherModel->get(0)->appId(), QString("rel-icon"));
+        QCOMPARE(launcherModel->get(1)->appId(), QString("click-icon"));
+        QCOMPARE(launcherModel->get(2)->appId(), QString("abs-icon"));
+
+        // Nothing to do if the order didn't change
+        settings->simulateDConfChanged(QStringList() << "rel-icon" << "click-icon" << "abs-icon");
+        QCOMPARE(movedSpy.count(), 1);
+
+        for (int i = 0; i < launcherModel->rowCount(); ++i) {
+            QCOMPARE(launcherModel->findApplication(launcherModel->get(i)->appId()), i);
+        }
+    }
+
     void testAddSyncsToAS() {
         // Make sure launcher and AS are in sync when we start the test
-        QCOMPARE(launcherModel->rowCount(), getASConfig().count());
+        QTRY_COMPARE(launcherModel->rowCount(), getASConfig().count());
 
         int oldCount = launcherModel->rowCount();
         appManager->addApplication(new MockApp("click-icon"));
         QCOMPARE(launcherModel->rowCount(), oldCount + 1);
-        QCOMPARE(launcherModel->rowCount(), getASConfig().count());
+        QTRY_COMPARE(launcherModel->rowCount(), getASConfig().count());
     }
 
     void testRemoveSyncsToAS() {
         // Make sure launcher and AS are in sync when we start the test
-        QCOMPARE(launcherModel->rowCount(), getASConfig().count());
+        QTRY_COMPARE(launcherModel->rowCount(), getASConfig().count());
 
         int oldCount = launcherModel->rowCount();
         appManager->stopApplication("abs-icon");
         QCOMPARE(launcherModel->rowCount(), oldCount - 1);
-        QCOMPARE(launcherModel->rowCount(), getASConfig().count());
+        QTRY_COMPARE(launcherModel->rowCount(), getASConfig().count());
     }
 
     void testMoveSyncsToAS() {
         // Make sure launcher and AS are in sync when we start the test
-        QCOMPARE(launcherModel->rowCount(), getASConfig().count());
-
-        for (int i = 0; i < launcherModel->rowCount(); i++) {
-            QString launcherAppId = launcherModel->get(i)->appId();
-            QString asAppId = getASConfig().at(i).value("id").toString();
-            QCOMPARE(launcherAppId, asAppId);
-        }
+        QTRY_COMPARE(getASAppIds(), getLauncherAppIds());
 
         launcherModel->move(0, 1);
 
-        for (int i = 0; i < launcherModel->rowCount(); i++) {
-            QString launcherAppId = launcherModel->get(i)->appId();
-            QString asAppId = getASConfig().at(i).value("id").toString();
-            QCOMPARE(launcherAppId, asAppId);
-        }
+        QTRY_COMPARE(getASAppIds(), getLauncherAppIds());
     }
 
     void testCountChangeSyncsToAS() {
@@ -796,6 +877,7 @@ private Q_SLOTS:
         int index = launcherModel->findApplication("abs-icon");
 
         // Make sure it's invisible and 0 at the beginning
+        QTRY_COMPARE(getASConfig().count(), launcherModel->rowCount());
         QCOMPARE(getASConfig().at(index).value("countVisible").toBool(), false);
         QCOMPARE(getASConfig().at(index).value("count").toInt(), 0);
 
@@ -805,8 +887,29 @@ private Q_SLOTS:
         interface.call("Set", "com.canonical.Unity.Launcher.Item", "countVisible", QVariant::fromValue(QDBusVariant(true)));
 
         // Make sure it changed to visible and 55
-        QCOMPARE(getASConfig().at(index).value("countVisible").toBool(), true);
-        QCOMPARE(getASConfig().at(index).value("count").toInt(), 55);
+        QTRY_COMPARE(getASConfig().at(index).value("countVisible").toBool(), true);
+        QTRY_COMPARE(getASConfig().at(index).value("count").toInt(), 55);
+    }
+
+    void testProgressSyncsAreCoalesced() {
+        ASAdapter *adapter = launcherModel->m_asAdapter;
+        QTRY_COMPARE(getASAppIds(), getLauncherAppIds());
+
+        // A flood of progress updates ends up in a single, rate limited sync
+        for (int progress = 0; progress <= 100; ++progress) {
+            launcherModel->progressChanged("abs-icon", progress);
+        }
+        QVERIFY(adapter->m_progressTimer.isActive());
+        QCOMPARE(getASConfig().at(launcherModel->findApplication("abs-icon")).value("progress").toInt(), -1);
+        QTRY_COMPARE(getASConfig().at(launcherModel->findApplication("abs-icon")).value("progress").toInt(), 100);
+
+        // The same list again isn't sent at all
+        const QByteArray sentHash = adapter->m_sentHash;
+        launcherModel->progressChanged("abs-icon", 100);
+        adapter->flush();
+        QCOMPARE(adapter->m_sentHash, sentHash);
+        QVERIFY(!adapter->m_dirty);
+        QVERIFY(adapter->m_pendingItems.isEmpty());
     }
 
     void testSurfaceCountUpdates() {
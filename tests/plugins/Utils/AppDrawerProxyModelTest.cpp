@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 3.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "appdrawerproxymodel.h"
+
+#include <QAbstractListModel>
+#include <QTest>
+
+class MockAppModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    int rowCount(const QModelIndex & = QModelIndex()) const override
+    {
+        return m_names.count();
+    }
+
+    QVariant data(const QModelIndex &index, int role) const override
+    {
+        switch (role) {
+        case AppDrawerModelInterface::RoleName:
+            return m_names[index.row()];
+        case AppDrawerModelInterface::RoleKeywords:
+            return m_keywords[index.row()];
+        }
+        return QVariant();
+    }
+
+    void insertApp(int row, const QString &name, const QStringList &keywords = QStringList())
+    {
+        beginInsertRows(QModelIndex(), row, row);
+        m_names.insert(row, name);
+        m_keywords.insert(row, keywords);
+        endInsertRows();
+    }
+
+    void removeApp(int row)
+    {
+        beginRemoveRows(QModelIndex(), row, row);
+        m_names.removeAt(row);
+        m_keywords.removeAt(row);
+        endRemoveRows();
+    }
+
+    void moveApp(int from, int to)
+    {
+        beginMoveRows(QModelIndex(), from, from, QModelIndex(), to > from ? to + 1 : to);
+        m_names.move(from, to);
+        m_keywords.move(from, to);
+        endMoveRows();
+    }
+
+private:
+    QStringList m_names;
+    QList<QStringList> m_keywords;
+};
+
+class AppDrawerProxyModelTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init()
+    {
+        source = new MockAppModel;
+        source->insertApp(0, "Camera", {"photo", "picture"});
+        source->insertApp(1, "Calculator", {"math"});
+        source->insertApp(2, "Éditeur", {"text"});
+        source->insertApp(3, "Terminal", {"shell", "command"});
+
+        proxy = new AppDrawerProxyModel;
+        proxy->setSource(source);
+    }
+
+    void cleanup()
+    {
+        delete proxy;
+        delete source;
+    }
+
+    QStringList names()
+    {
+        QStringList result;
+        for (int i = 0; i < proxy->rowCount(); ++i) {
+            result << proxy->data(proxy->index(i, 0), AppDrawerModelInterface::RoleName).toString();
+        }
+        return result;
+    }
+
+    void testFilterString()
+    {
+        proxy->setFilterString("ca");
+        QCOMPARE(names(), QStringList({"Calculator", "Camera"}));
+
+        // Narrowing down
+        proxy->setFilterString("cam");
+        QCOMPARE(names(), QStringList({"Camera"}));
+
+        // And back
+        proxy->setFilterString("c");
+        QCOMPARE(names(), QStringList({"Calculator", "Camera", "Terminal"}));
+
+        proxy->setFilterString("");
+        QCOMPARE(proxy->rowCount(), 4);
+    }
+
+    void testFilterStringFolding()
+    {
+        proxy->setFilterString("EDIT");
+        QCOMPARE(names(), QStringList({"Éditeur"}));
+
+        proxy->setFilterString("édi");
+        QCOMPARE(names(), QStringList({"Éditeur"}));
+    }
+
+    void testSourceChanges()
+    {
+        proxy->setFilterString("cal");
+        QCOMPARE(names(), QStringList({"Calculator"}));
+
+        source->insertApp(0, "Calendar");
+        QCOMPARE(names(), QStringList({"Calculator", "Calendar"}));
+
+        source->removeApp(2); // Calculator
+        QCOMPARE(names(), QStringList({"Calendar"}));
+
+        proxy->setFilterString("pho");
+        QCOMPARE(names(), QStringList({"Camera"}));
+    }
+
+    void testSourceRowsMoved()
+    {
+        source->moveApp(3, 0); // Terminal
+
+        proxy->setFilterString("term");
+        QCOMPARE(names(), QStringList({"Terminal"}));
+
+        proxy->setFilterString("photo");
+        QCOMPARE(names(), QStringList({"Camera"}));
+    }
+
+    void testGroupByAToZ()
+    {
+        proxy->setGroup(AppDrawerProxyModel::GroupByAToZ);
+        proxy->setSortBy(AppDrawerProxyModel::SortByAToZ);
+        // Grouping looks at the source order, Camera and Calculator are neighbours there
+        QCOMPARE(proxy->rowCount(), 3);
+
+        proxy->setGroup(AppDrawerProxyModel::GroupByNone);
+        proxy->setFilterLetter("c");
+        QCOMPARE(names(), QStringList({"Calculator", "Camera"}));
+    }
+
+private:
+    MockAppModel *source{nullptr};
+    AppDrawerProxyModel *proxy{nullptr};
+};
+
+QTEST_GUILESS_MAIN(AppDrawerProxyModelTest)
+#include "AppDrawerProxyModelTest.moc"
@@ -65,6 +65,20 @@ private Q_SLOTS:
         QCOMPARE(loadedGeometry, defaultGeometry);
     }
 
+    void testPersistence() {
+        const QRect geometry{10, 20, 30, 40};
+        storage->saveGeometry(QTest::currentTestFunction(), QRect(1, 2, 3, 4));
+        storage->saveGeometry(QTest::currentTestFunction(), geometry);
+        storage->saveStage(QTest::currentTestFunction(), 2);
+
+        // Pending changes are written on destruction
+        delete storage;
+        storage = new WindowStateStorage(this);
+
+        QCOMPARE(storage->getGeometry(QTest::currentTestFunction(), QRect()), geometry);
+        QCOMPARE(storage->getStage(QTest::currentTestFunction(), 0), 2);
+    }
+
 private:
     WindowStateStorage * storage{nullptr};
 };
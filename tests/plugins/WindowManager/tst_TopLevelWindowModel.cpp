@@ -32,6 +32,10 @@ private Q_SLOTS:
 
     void singleSurfaceStartsHidden();
     void secondSurfaceIsHidden();
+    void lookupsFollowMoves();
+    void raisesAreBatched();
+
+    void benchmarkCreateRaiseClose();
 
 private:
     ApplicationManager *applicationManager{nullptr};
@@ -125,6 +129,111 @@ void tst_TopLevelWindowModel::secondSurfaceIsHidden()
     QCOMPARE((void*)topLevelWindowModel->windowAt(0)->surface(), (void*)firstSurface);
 }
 
+void tst_TopLevelWindowModel::lookupsFollowMoves()
+{
+    auto application = static_cast<Application*>(applicationManager->startApplication(QString("hello-world"), QStringList()));
+    application->m_state = ApplicationInfoInterface::Running;
+
+    QVector<MirSurface*> surfaces;
+    for (int i = 0; i < 3; ++i) {
+        auto surface = new MirSurface;
+        application->m_surfaceList.addSurface(surface);
+        Q_EMIT surfaceManager->surfaceCreated(surface);
+        surfaces.append(surface);
+    }
+    QCOMPARE(topLevelWindowModel->rowCount(), 3);
+    const int bottomId = topLevelWindowModel->idAt(2);
+    QCOMPARE((void*)topLevelWindowModel->surfaceAt(2), (void*)surfaces[0]);
+
+    Q_EMIT surfaceManager->surfacesRaised({surfaces[0]});
+    QCOMPARE((void*)topLevelWindowModel->surfaceAt(0), (void*)surfaces[0]);
+    QCOMPARE(topLevelWindowModel->indexForId(bottomId), 0);
+    QCOMPARE(topLevelWindowModel->indexForId(topLevelWindowModel->idAt(2)), 2);
+
+    // Closing the middle one moves the bottom one up
+    const int lastId = topLevelWindowModel->idAt(2);
+    surfaces[2]->m_live = false;
+    Q_EMIT surfaces[2]->liveChanged(false);
+    delete surfaces[2];
+    QCOMPARE(topLevelWindowModel->rowCount(), 2);
+    QCOMPARE(topLevelWindowModel->indexForId(lastId), 1);
+    QCOMPARE(topLevelWindowModel->indexForId(bottomId), 0);
+
+    // A surface that is gone can't be raised
+    Q_EMIT surfaceManager->surfacesRaised({surfaces[2]});
+    QCOMPARE(topLevelWindowModel->indexForId(lastId), 1);
+}
+
+void tst_TopLevelWindowModel::raisesAreBatched()
+{
+    auto application = static_cast<Application*>(applicationManager->startApplication(QString("hello-world"), QStringList()));
+    application->m_state = ApplicationInfoInterface::Running;
+
+    QVector<MirSurface*> surfaces;
+    for (int i = 0; i < 3; ++i) {
+        auto surface = new MirSurface;
+        application->m_surfaceList.addSurface(surface);
+        Q_EMIT surfaceManager->surfaceCreated(surface);
+        surfaces.append(surface);
+    }
+    // [2, 1, 0]
+
+    QSignalSpy rowsMovedSpy(topLevelWindowModel, &QAbstractItemModel::rowsMoved);
+    QSignalSpy listChangedSpy(topLevelWindowModel, &TopLevelWindowModel::listChanged);
+
+    Q_EMIT surfaceManager->modificationsStarted();
+    Q_EMIT surfaceManager->surfacesRaised({surfaces[0]});
+    Q_EMIT surfaceManager->surfacesRaised({surfaces[2]});
+    Q_EMIT surfaceManager->surfacesRaised({surfaces[1], surfaces[0]});
+    QCOMPARE(rowsMovedSpy.count(), 0);
+    Q_EMIT surfaceManager->modificationsEnded();
+
+    // [0, 1, 2], 2 stays put and the other two move once each
+    QCOMPARE((void*)topLevelWindowModel->surfaceAt(0), (void*)surfaces[0]);
+    QCOMPARE((void*)topLevelWindowModel->surfaceAt(1), (void*)surfaces[1]);
+    QCOMPARE((void*)topLevelWindowModel->surfaceAt(2), (void*)surfaces[2]);
+    QCOMPARE(rowsMovedSpy.count(), 2);
+    QCOMPARE(listChangedSpy.count(), 1);
+
+    // Raising what is already on top changes nothing
+    Q_EMIT surfaceManager->modificationsStarted();
+    Q_EMIT surfaceManager->surfacesRaised({surfaces[1], surfaces[0]});
+    Q_EMIT surfaceManager->modificationsEnded();
+    QCOMPARE(rowsMovedSpy.count(), 2);
+    QCOMPARE(listChangedSpy.count(), 1);
+}
+
+void tst_TopLevelWindowModel::benchmarkCreateRaiseClose()
+{
+    auto application = static_cast<Application*>(applicationManager->startApplication(QString("hello-world"), QStringList()));
+    application->m_state = ApplicationInfoInterface::Running;
+    const int windowCount = 2000;
+
+    QBENCHMARK {
+        QVector<MirSurface*> surfaces;
+        for (int i = 0; i < windowCount; ++i) {
+            auto surface = new MirSurface;
+            application->m_surfaceList.addSurface(surface);
+            Q_EMIT surfaceManager->surfaceCreated(surface);
+            surfaces.append(surface);
+        }
+        QCOMPARE(topLevelWindowModel->rowCount(), windowCount);
+
+        // Raise them all, each from the bottom of the stack
+        for (int i = 0; i < windowCount; ++i) {
+            Q_EMIT surfaceManager->surfacesRaised({surfaces[i]});
+            topLevelWindowModel->raiseId(topLevelWindowModel->idAt(windowCount - 1));
+        }
+
+        Q_FOREACH(MirSurface *surface, surfaces) {
+            surface->m_live = false;
+            Q_EMIT surface->liveChanged(false);
+            delete surface;
+        }
+        QCOMPARE(topLevelWindowModel->rowCount(), 0);
+    }
+}
+
 QTEST_MAIN(tst_TopLevelWindowModel)
 
 #include "tst_TopLevelWindowModel.moc"